@@ -0,0 +1,36 @@
+/**
+ *	\file		admin.c
+ *	\brief		Queries and tunes a running server.
+ *
+ *	\details	This file contains the admin tool. The tool sends a command to the admin queue of a server and prints the lines of the answer. The commands are stats, which gives the live statistics of the server, get, which gives its settings, set with a name and a value, which changes a setting without restarting the server, and reset, which clears the latencies measured.
+ */
+#ifndef ADMIN_H
+#define ADMIN_H
+
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ADMIN_TIMEOUT_MS 1000 // The time the server has to answer a command
+
+/**
+ *	\fn			int adminRequest(key_t serverKey, const char *command, int timeout)
+ *	\brief		Sends a command to a server and prints the answer.
+ *	\param 		serverKey : The listenning key of the server.
+ *	\param 		command : The command.
+ *	\param 		timeout : The time in milliseconds the server has to answer each line.
+ *	\details	The answer comes on the admin queue, on a type of the process, each line in a message until an empty one. Returns 0 on success, -1 if the server has no admin queue or did not answer in time, and 1 if the server answered with an error.
+ */
+int adminRequest(key_t serverKey, const char *command, int timeout);
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the admin tool usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and commands and exits.
+ */
+void _usage(char *name);
+
+#endif
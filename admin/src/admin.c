@@ -0,0 +1,116 @@
+/**
+ *	\file		admin.c
+ *	\brief		Queries and tunes a running server.
+ *
+ *	\details	This file contains the admin tool. The tool sends a command to the admin queue of a server and prints the lines of the answer. The commands are stats, which gives the live statistics of the server, get, which gives its settings, set with a name and a value, which changes a setting without restarting the server, and reset, which clears the latencies measured.
+ */
+#include "admin.h"
+
+int serverPID = 0;
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the admin tool.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-K sets the listenning key of the server and -t the time it has to answer. The words following the options make the command.
+ */
+int main(int argc, char *argv[]) {
+    key_t serverKey = SERVER_LISTENNING_KEY;
+    int timeout = ADMIN_TIMEOUT_MS;
+    char command[MSG_SIZE] = {0};
+    int length = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "K:t:")) != -1) {
+        switch (opt) {
+            case 'K':
+                serverKey = atoi(optarg);
+                break;
+            case 't':
+                timeout = atoi(optarg);
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (optind == argc || serverKey <= 0 || timeout <= 0) {
+        _usage(argv[0]);
+    }
+    for (int i = optind; i < argc; i++) {
+        length += snprintf(command + length, MSG_SIZE - length, i == optind ? "%s" : " %s", argv[i]);
+        if (length >= MSG_SIZE) {
+            fprintf(stderr, "Error: the command is too long\n");
+            return -1;
+        }
+    }
+    serverPID = getpid();
+    switch (adminRequest(serverKey, command, timeout)) {
+        case -1:
+            fprintf(stderr, "Error: no answer from the server with the key %d\n", serverKey);
+            return -1;
+        case 1:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ *	\fn			int adminRequest(key_t serverKey, const char *command, int timeout)
+ *	\brief		Sends a command to a server and prints the answer.
+ *	\param 		serverKey : The listenning key of the server.
+ *	\param 		command : The command.
+ *	\param 		timeout : The time in milliseconds the server has to answer each line.
+ *	\details	The answer comes on the admin queue, on a type of the process, each line in a message until an empty one. Returns 0 on success, -1 if the server has no admin queue or did not answer in time, and 1 if the server answered with an error.
+ */
+int adminRequest(key_t serverKey, const char *command, int timeout) {
+    long replyType = MTYPE_ACK_BASE + getpid();
+    mbuf_t message;
+    int msgid;
+    int status;
+    int error = 0;
+
+    if ((msgid = msgget(ADMIN_QUEUE_KEY(serverKey), 0666)) == -1) {
+        return -1;
+    }
+    // An answer left for a dead process with the same PID would answer the wrong command
+    while (pollMessage(msgid, &message, replyType) == 1);
+    message.mtype = MTYPE_DATA;
+    message.ackType = replyType;
+    strcpy(message.mtext, command);
+    if (_sendMessage(msgid, &message) == -1) {
+        return -1;
+    }
+    while (1) {
+        for (int waited = 0; (status = pollMessage(msgid, &message, replyType)) == 0 && waited < timeout * 1000; waited += CONNECT_POLL_US) {
+            usleep(CONNECT_POLL_US);
+        }
+        if (status != 1) {
+            return -1;
+        }
+        if (message.mtext[0] == '\0') {
+            return error;
+        }
+        error |= strncmp(message.mtext, "error", 5) == 0;
+        printf("%s\n", message.mtext);
+    }
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the admin tool usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and commands and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s [-K listenning key] [-t timeout] command\n", name);
+    fprintf(stderr, "  -K  listenning key of the server (default %d)\n", SERVER_LISTENNING_KEY);
+    fprintf(stderr, "  -t  time in milliseconds the server has to answer (default %d)\n", ADMIN_TIMEOUT_MS);
+    fprintf(stderr, "Commands:\n");
+    fprintf(stderr, "  stats             sessions, clients, queue depths and latencies\n");
+    fprintf(stderr, "  get               settings\n");
+    fprintf(stderr, "  set name value    change a setting: loglevel, size, wait, lobby, turn or shards\n");
+    fprintf(stderr, "  reset             clear the latencies\n");
+    exit(-1);
+}
@@ -0,0 +1,165 @@
+/**
+ *	\file		bench.c
+ *	\brief		Runs the microbenchmarks of the transport primitives.
+ *
+ *	\details	This file contains the benchmark tool. Each benchmark exchanges messages between two processes with the libUtils primitives, the process playing the server being forked for the benchmark.
+ *				Every benchmark is warmed up, repeated, and reported as one CSV line or JSON object per repetition, tagged with the transport it measures so other transports can be compared on the same machine.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define BENCH_DEFAULT_ITERATIONS 10000
+#define BENCH_DEFAULT_WARMUP 1000
+#define BENCH_DEFAULT_REPETITIONS 5
+#define BENCH_DEFAULT_PAIRS 4
+#define BENCH_STREAM_BATCH 64 // Messages posted before draining their acks, the queue must hold twice as many
+#define BENCH_LISTENNING_KEY (SERVER_LISTENNING_KEY + 1) // Never the key of a running server
+#define BENCH_FORMAT_CSV 0
+#define BENCH_FORMAT_JSON 1
+
+/**
+ *	\struct		benchConfig
+ *	\brief		Represents the options of the benchmarks.
+ */
+struct benchConfig
+{
+    int iterations; /**<The number of measured operations of a repetition.*/
+    int warmup; /**<The number of operations run before measuring.*/
+    int repetitions; /**<The number of repetitions of each benchmark.*/
+    int maxPairs; /**<The maximum number of concurrent queue pairs of the scaling benchmark.*/
+    int format; /**<BENCH_FORMAT_CSV or BENCH_FORMAT_JSON.*/
+    const char *filter; /**<Runs only the benchmark with this name, or all of them if NULL.*/
+};
+typedef struct benchConfig benchConfig_t;
+
+/**
+ *	\struct		benchResult
+ *	\brief		Represents the result of a repetition.
+ */
+struct benchResult
+{
+    int pairs; /**<The number of concurrent queue pairs.*/
+    int iterations; /**<The number of measured operations.*/
+    double meanUs; /**<The mean latency of an operation, in microseconds.*/
+    double p50Us; /**<The median latency, in microseconds.*/
+    double p99Us; /**<The 99th percentile latency, in microseconds.*/
+    double opsPerSec; /**<The number of operations per second.*/
+};
+typedef struct benchResult benchResult_t;
+
+/**
+ *	\struct		benchCase
+ *	\brief		Represents a benchmark.
+ *	\details	A benchmark reports each of its results with the callback it is given, once per repetition, or once per repetition and number of pairs.
+ */
+struct benchCase
+{
+    const char *name; /**<The name of the benchmark.*/
+    const char *transport; /**<The transport measured.*/
+    void (*run)(const benchConfig_t *config, const struct benchCase *benchCase); /**<Runs the benchmark.*/
+};
+typedef struct benchCase benchCase_t;
+
+/**
+ *	\fn			void benchRoundTrip(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the round trip of sendData and receiveData.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	An operation is a sendData answered by the receiveData of the peer: the data and its ack.
+ */
+void benchRoundTrip(const benchConfig_t *config, const benchCase_t *benchCase);
+
+/**
+ *	\fn			void benchStream(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the throughput of postData.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	The data is posted by batches of BENCH_STREAM_BATCH messages, then the acks of the batch are drained. The latencies are the batch times divided by the batch size.
+ */
+void benchStream(const benchConfig_t *config, const benchCase_t *benchCase);
+
+/**
+ *	\fn			void benchHandshake(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the connection handshake.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	An operation is a connectToServer accepted by the acceptClient of the peer, on the BENCH_LISTENNING_KEY queue. The peer hands out a queue created before the request, as the server does with its pool, and removes it once the handshake is over.
+ */
+void benchHandshake(const benchConfig_t *config, const benchCase_t *benchCase);
+
+/**
+ *	\fn			void benchScaling(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the round trip with concurrent queue pairs.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	The number of pairs doubles from 1 up to maxPairs. Each pair is two processes doing round trips on their own queue. The operations per second add up the pairs, the percentiles are taken over the mean latencies of the pairs.
+ */
+void benchScaling(const benchConfig_t *config, const benchCase_t *benchCase);
+
+/**
+ *	\fn			void benchReport(const benchConfig_t *config, const benchCase_t *benchCase, int repetition, const benchResult_t *result)
+ *	\brief		Reports the result of a repetition.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\param 		repetition : The index of the repetition.
+ *	\param 		result : The result.
+ */
+void benchReport(const benchConfig_t *config, const benchCase_t *benchCase, int repetition, const benchResult_t *result);
+
+/**
+ *	\fn			void _benchSummarize(double *samples, int nbSamples, double elapsed, benchResult_t *result)
+ *	\brief		Computes a result from latency samples.
+ *	\param 		samples : The latencies, in seconds, sorted in place.
+ *	\param 		nbSamples : The number of samples.
+ *	\param 		elapsed : The time of the whole repetition, in seconds.
+ *	\param 		result : The result, its pairs and iterations are left untouched.
+ */
+void _benchSummarize(double *samples, int nbSamples, double elapsed, benchResult_t *result);
+
+/**
+ *	\fn			pid_t _benchSpawnEcho(int msgid, int count)
+ *	\brief		Forks the peer of the round trip benchmarks.
+ *	\param 		msgid : The queue shared with the peer.
+ *	\param 		count : The number of messages the peer receives and acknowledges before exiting.
+ *	\details	The peer plays the server: it sets serverPID to its own PID, and the caller sets it to the PID of the peer, so each side uses its own data type.
+ */
+pid_t _benchSpawnEcho(int msgid, int count);
+
+/**
+ *	\fn			void _benchRoundTrips(int msgid, int count, double *samples)
+ *	\brief		Does round trips with the peer.
+ *	\param 		msgid : The queue shared with the peer.
+ *	\param 		count : The number of round trips.
+ *	\param 		samples : Where the latency of each round trip is stored, or NULL.
+ */
+void _benchRoundTrips(int msgid, int count, double *samples);
+
+/**
+ *	\fn			double _benchNow()
+ *	\brief		Returns the monotonic time in seconds.
+ */
+double _benchNow();
+
+/**
+ *	\fn			int _benchCompare(const void *a, const void *b)
+ *	\brief		Compares two latencies for qsort.
+ */
+int _benchCompare(const void *a, const void *b);
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the bench usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name);
+
+#endif
@@ -0,0 +1,394 @@
+/**
+ *	\file		bench.c
+ *	\brief		Runs the microbenchmarks of the transport primitives.
+ *
+ *	\details	This file contains the benchmark tool. Each benchmark exchanges messages between two processes with the libUtils primitives, the process playing the server being forked for the benchmark.
+ *				Every benchmark is warmed up, repeated, and reported as one CSV line or JSON object per repetition, tagged with the transport it measures so other transports can be compared on the same machine.
+ */
+#include "bench.h"
+
+int serverPID = 0;
+int nbReports = 0;
+
+benchCase_t benchCases[] = {
+    {"roundtrip", "sysv", benchRoundTrip},
+    {"stream", "sysv", benchStream},
+    {"handshake", "sysv", benchHandshake},
+    {"scaling", "sysv", benchScaling},
+};
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the bench.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-n sets the number of iterations, -w the warmup, -r the repetitions, -p the maximum number of pairs, -o the output format, csv or json, and -b the benchmark to run. The results are written to stdout.
+ */
+int main(int argc, char *argv[]) {
+    benchConfig_t config = {
+        .iterations = BENCH_DEFAULT_ITERATIONS,
+        .warmup = BENCH_DEFAULT_WARMUP,
+        .repetitions = BENCH_DEFAULT_REPETITIONS,
+        .maxPairs = BENCH_DEFAULT_PAIRS,
+        .format = BENCH_FORMAT_CSV,
+        .filter = NULL,
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:r:p:o:b:")) != -1) {
+        switch (opt) {
+            case 'n':
+                config.iterations = atoi(optarg);
+                break;
+            case 'w':
+                config.warmup = atoi(optarg);
+                break;
+            case 'r':
+                config.repetitions = atoi(optarg);
+                break;
+            case 'p':
+                config.maxPairs = atoi(optarg);
+                break;
+            case 'o':
+                if (strcmp(optarg, "csv") == 0) {
+                    config.format = BENCH_FORMAT_CSV;
+                } else if (strcmp(optarg, "json") == 0) {
+                    config.format = BENCH_FORMAT_JSON;
+                } else {
+                    _usage(argv[0]);
+                }
+                break;
+            case 'b':
+                config.filter = optarg;
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (config.iterations < 1 || config.warmup < 0 || config.repetitions < 1 || config.maxPairs < 1) {
+        _usage(argv[0]);
+    }
+
+    if (config.format == BENCH_FORMAT_CSV) {
+        printf("benchmark,transport,pairs,repetition,iterations,mean_us,p50_us,p99_us,ops_per_sec\n");
+    } else {
+        printf("[");
+    }
+    for (size_t i = 0; i < sizeof(benchCases) / sizeof(benchCases[0]); i++) {
+        if (config.filter == NULL || strcmp(config.filter, benchCases[i].name) == 0) {
+            benchCases[i].run(&config, &benchCases[i]);
+        }
+    }
+    if (config.format == BENCH_FORMAT_JSON) {
+        printf("\n]\n");
+    }
+    return 0;
+}
+
+/**
+ *	\fn			void benchRoundTrip(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the round trip of sendData and receiveData.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	An operation is a sendData answered by the receiveData of the peer: the data and its ack.
+ */
+void benchRoundTrip(const benchConfig_t *config, const benchCase_t *benchCase) {
+    double *samples = malloc(config->iterations * sizeof(double));
+    benchResult_t result = {.pairs = 1, .iterations = config->iterations};
+    double start;
+    int msgid;
+    pid_t echo;
+
+    CHECK(msgid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT), "Error: could not create the queue");
+    echo = _benchSpawnEcho(msgid, config->warmup + config->repetitions * config->iterations);
+    _benchRoundTrips(msgid, config->warmup, NULL);
+    for (int r = 0; r < config->repetitions; r++) {
+        start = _benchNow();
+        _benchRoundTrips(msgid, config->iterations, samples);
+        _benchSummarize(samples, config->iterations, _benchNow() - start, &result);
+        benchReport(config, benchCase, r, &result);
+    }
+    waitpid(echo, NULL, 0);
+    msgctl(msgid, IPC_RMID, NULL);
+    free(samples);
+}
+
+/**
+ *	\fn			void benchStream(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the throughput of postData.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	The data is posted by batches of BENCH_STREAM_BATCH messages, then the acks of the batch are drained. The latencies are the batch times divided by the batch size.
+ */
+void benchStream(const benchConfig_t *config, const benchCase_t *benchCase) {
+    int nbBatches = (config->iterations + BENCH_STREAM_BATCH - 1) / BENCH_STREAM_BATCH;
+    int nbWarmupBatches = (config->warmup + BENCH_STREAM_BATCH - 1) / BENCH_STREAM_BATCH;
+    double *samples = malloc(nbBatches * sizeof(double));
+    benchResult_t result = {.pairs = 1, .iterations = nbBatches * BENCH_STREAM_BATCH};
+    mbuf_t ack;
+    double start, batchStart;
+    int msgid;
+    pid_t echo;
+
+    CHECK(msgid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT), "Error: could not create the queue");
+    echo = _benchSpawnEcho(msgid, (nbWarmupBatches + config->repetitions * nbBatches) * BENCH_STREAM_BATCH);
+    for (int r = -1; r < config->repetitions; r++) {
+        // The repetition -1 is the warmup
+        start = _benchNow();
+        for (int b = 0; b < (r == -1 ? nbWarmupBatches : nbBatches); b++) {
+            batchStart = _benchNow();
+            for (int i = 0; i < BENCH_STREAM_BATCH; i++) {
+                CHECK(postData(msgid, "ping"), "Error: could not post data");
+            }
+            for (int i = 0; i < BENCH_STREAM_BATCH; i++) {
+                CHECK(_receiveMessage(msgid, &ack, ACK_TYPE, NO_DEADLINE, 0), "Error: could not receive the ack");
+            }
+            if (r != -1) {
+                samples[b] = (_benchNow() - batchStart) / BENCH_STREAM_BATCH;
+            }
+        }
+        if (r != -1) {
+            _benchSummarize(samples, nbBatches, _benchNow() - start, &result);
+            benchReport(config, benchCase, r, &result);
+        }
+    }
+    waitpid(echo, NULL, 0);
+    msgctl(msgid, IPC_RMID, NULL);
+    free(samples);
+}
+
+/**
+ *	\fn			void benchHandshake(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the connection handshake.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	An operation is a connectToServer accepted by the acceptClient of the peer, on the BENCH_LISTENNING_KEY queue. The peer hands out a queue created before the request, as the server does with its pool, and removes it once the handshake is over.
+ */
+void benchHandshake(const benchConfig_t *config, const benchCase_t *benchCase) {
+    double *samples = malloc(config->iterations * sizeof(double));
+    benchResult_t result = {.pairs = 1, .iterations = config->iterations};
+    int count = config->warmup + config->repetitions * config->iterations;
+    double start, connectStart, elapsed;
+    int listenningQueue;
+    int clientMsgid;
+    int peerPID;
+    pid_t server;
+
+    CHECK(listenningQueue = msgget(BENCH_LISTENNING_KEY, 0666 | IPC_CREAT), "Error: could not create the listenning queue");
+    CHECK(server = fork(), "Error: could not fork");
+    if (server == 0) {
+        serverPID = getpid();
+        for (int i = 0; i < count; i++) {
+            // The next queue is created once the client is answered, as the server fills its pool while idle
+            CHECK(clientMsgid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT), "Error: could not create a client queue");
+            acceptClient(listenningQueue, &peerPID, clientMsgid, 0);
+            msgctl(clientMsgid, IPC_RMID, NULL);
+        }
+        _exit(0);
+    }
+    for (int r = -1; r < config->repetitions; r++) {
+        // The repetition -1 is the warmup
+        start = _benchNow();
+        for (int i = 0; i < (r == -1 ? config->warmup : config->iterations); i++) {
+            connectStart = _benchNow();
+            connectToServer(BENCH_LISTENNING_KEY, 0, &peerPID);
+            elapsed = _benchNow() - connectStart;
+            if (r != -1) {
+                samples[i] = elapsed;
+            }
+        }
+        if (r != -1) {
+            _benchSummarize(samples, config->iterations, _benchNow() - start, &result);
+            benchReport(config, benchCase, r, &result);
+        }
+    }
+    waitpid(server, NULL, 0);
+    msgctl(listenningQueue, IPC_RMID, NULL);
+    free(samples);
+}
+
+/**
+ *	\fn			void benchScaling(const benchConfig_t *config, const benchCase_t *benchCase)
+ *	\brief		Measures the round trip with concurrent queue pairs.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\details	The number of pairs doubles from 1 up to maxPairs. Each pair is two processes doing round trips on their own queue. The operations per second add up the pairs, the percentiles are taken over the mean latencies of the pairs.
+ */
+void benchScaling(const benchConfig_t *config, const benchCase_t *benchCase) {
+    double *samples = malloc(config->maxPairs * sizeof(double));
+    benchResult_t result = {.iterations = config->iterations};
+    int startPipe[2], resultPipe[2];
+    double elapsed, slowest;
+    char start;
+    int msgid;
+    pid_t echo;
+
+    for (int pairs = 1; pairs <= config->maxPairs; pairs *= 2) {
+        result.pairs = pairs;
+        for (int r = 0; r < config->repetitions; r++) {
+            CHECK(pipe(startPipe), "Error: could not create a pipe");
+            CHECK(pipe(resultPipe), "Error: could not create a pipe");
+            for (int p = 0; p < pairs; p++) {
+                pid_t client;
+                CHECK(client = fork(), "Error: could not fork");
+                if (client != 0) {
+                    continue;
+                }
+                close(startPipe[1]);
+                close(resultPipe[0]);
+                CHECK(msgid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT), "Error: could not create the queue");
+                echo = _benchSpawnEcho(msgid, config->warmup + config->iterations);
+                _benchRoundTrips(msgid, config->warmup, NULL);
+                // The pairs start measuring together once the bench closes the start pipe
+                read(startPipe[0], &start, 1);
+                elapsed = _benchNow();
+                _benchRoundTrips(msgid, config->iterations, NULL);
+                elapsed = _benchNow() - elapsed;
+                write(resultPipe[1], &elapsed, sizeof(elapsed));
+                waitpid(echo, NULL, 0);
+                msgctl(msgid, IPC_RMID, NULL);
+                _exit(0);
+            }
+            close(startPipe[0]);
+            close(resultPipe[1]);
+            close(startPipe[1]);
+            slowest = 0;
+            for (int p = 0; p < pairs; p++) {
+                if (read(resultPipe[0], &elapsed, sizeof(elapsed)) != sizeof(elapsed)) {
+                    fprintf(stderr, "Error: a pair of the scaling benchmark failed\n");
+                    exit(-1);
+                }
+                samples[p] = elapsed / config->iterations;
+                slowest = elapsed > slowest ? elapsed : slowest;
+            }
+            close(resultPipe[0]);
+            while (wait(NULL) > 0);
+            _benchSummarize(samples, pairs, slowest, &result);
+            result.opsPerSec = (double)pairs * config->iterations / slowest;
+            benchReport(config, benchCase, r, &result);
+        }
+    }
+    free(samples);
+}
+
+/**
+ *	\fn			void benchReport(const benchConfig_t *config, const benchCase_t *benchCase, int repetition, const benchResult_t *result)
+ *	\brief		Reports the result of a repetition.
+ *	\param 		config : The options of the benchmarks.
+ *	\param 		benchCase : The benchmark.
+ *	\param 		repetition : The index of the repetition.
+ *	\param 		result : The result.
+ */
+void benchReport(const benchConfig_t *config, const benchCase_t *benchCase, int repetition, const benchResult_t *result) {
+    if (config->format == BENCH_FORMAT_CSV) {
+        printf("%s,%s,%d,%d,%d,%.3f,%.3f,%.3f,%.0f\n", benchCase->name, benchCase->transport, result->pairs, repetition,
+               result->iterations, result->meanUs, result->p50Us, result->p99Us, result->opsPerSec);
+    } else {
+        printf("%s\n  {\"benchmark\": \"%s\", \"transport\": \"%s\", \"pairs\": %d, \"repetition\": %d, \"iterations\": %d, "
+               "\"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"ops_per_sec\": %.0f}",
+               nbReports == 0 ? "" : ",", benchCase->name, benchCase->transport, result->pairs, repetition,
+               result->iterations, result->meanUs, result->p50Us, result->p99Us, result->opsPerSec);
+    }
+    nbReports++;
+    fflush(stdout);
+}
+
+/**
+ *	\fn			void _benchSummarize(double *samples, int nbSamples, double elapsed, benchResult_t *result)
+ *	\brief		Computes a result from latency samples.
+ *	\param 		samples : The latencies, in seconds, sorted in place.
+ *	\param 		nbSamples : The number of samples.
+ *	\param 		elapsed : The time of the whole repetition, in seconds.
+ *	\param 		result : The result, its pairs and iterations are left untouched.
+ */
+void _benchSummarize(double *samples, int nbSamples, double elapsed, benchResult_t *result) {
+    double sum = 0;
+    for (int i = 0; i < nbSamples; i++) {
+        sum += samples[i];
+    }
+    qsort(samples, nbSamples, sizeof(double), _benchCompare);
+    result->meanUs = sum / nbSamples * 1e6;
+    result->p50Us = samples[nbSamples / 2] * 1e6;
+    result->p99Us = samples[(int)(nbSamples * 0.99)] * 1e6;
+    result->opsPerSec = result->iterations / elapsed;
+}
+
+/**
+ *	\fn			pid_t _benchSpawnEcho(int msgid, int count)
+ *	\brief		Forks the peer of the round trip benchmarks.
+ *	\param 		msgid : The queue shared with the peer.
+ *	\param 		count : The number of messages the peer receives and acknowledges before exiting.
+ *	\details	The peer plays the server: it sets serverPID to its own PID, and the caller sets it to the PID of the peer, so each side uses its own data type.
+ */
+pid_t _benchSpawnEcho(int msgid, int count) {
+    char buffer[MSG_SIZE];
+    pid_t echo;
+    CHECK(echo = fork(), "Error: could not fork");
+    if (echo == 0) {
+        serverPID = getpid();
+        for (int i = 0; i < count; i++) {
+            receiveData(msgid, buffer, 0);
+        }
+        _exit(0);
+    }
+    serverPID = echo;
+    return echo;
+}
+
+/**
+ *	\fn			void _benchRoundTrips(int msgid, int count, double *samples)
+ *	\brief		Does round trips with the peer.
+ *	\param 		msgid : The queue shared with the peer.
+ *	\param 		count : The number of round trips.
+ *	\param 		samples : Where the latency of each round trip is stored, or NULL.
+ */
+void _benchRoundTrips(int msgid, int count, double *samples) {
+    double start;
+    for (int i = 0; i < count; i++) {
+        start = samples == NULL ? 0 : _benchNow();
+        sendData(msgid, "ping", 0);
+        if (samples != NULL) {
+            samples[i] = _benchNow() - start;
+        }
+    }
+}
+
+/**
+ *	\fn			double _benchNow()
+ *	\brief		Returns the monotonic time in seconds.
+ */
+double _benchNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ *	\fn			int _benchCompare(const void *a, const void *b)
+ *	\brief		Compares two latencies for qsort.
+ */
+int _benchCompare(const void *a, const void *b) {
+    double difference = *(const double *)a - *(const double *)b;
+    return (difference > 0) - (difference < 0);
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the bench usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s [-n iterations] [-w warmup] [-r repetitions] [-p pairs] [-o csv|json] [-b benchmark]\n", name);
+    fprintf(stderr, "  -n  measured operations per repetition (default %d)\n", BENCH_DEFAULT_ITERATIONS);
+    fprintf(stderr, "  -w  operations run before measuring (default %d)\n", BENCH_DEFAULT_WARMUP);
+    fprintf(stderr, "  -r  repetitions of each benchmark (default %d)\n", BENCH_DEFAULT_REPETITIONS);
+    fprintf(stderr, "  -p  maximum number of concurrent queue pairs (default %d)\n", BENCH_DEFAULT_PAIRS);
+    fprintf(stderr, "  -o  output format, csv or json (default csv)\n");
+    fprintf(stderr, "  -b  run only this benchmark:");
+    for (size_t i = 0; i < sizeof(benchCases) / sizeof(benchCases[0]); i++) {
+        fprintf(stderr, " %s", benchCases[i].name);
+    }
+    fprintf(stderr, "\n");
+    exit(-1);
+}
@@ -0,0 +1,66 @@
+/**
+ *	\file		bookgen.c
+ *	\brief		Generates the opening book of the solvers.
+ *
+ *	\details	This file contains the opening book generator. It builds the decision tree of the minimax solver, the guess to play after each path of scores, for the rules the tool is compiled with, and writes it to a file the clients and the bots map at startup.
+ *				Each guess minimizes the worst case, the largest group of codes sharing a score. Ties go to the codes that can still be the secret, then to the smallest code. The guesses are found by the solver of libUtils, whose workers share the search of each node.
+ */
+#ifndef BOOKGEN_H
+#define BOOKGEN_H
+
+#include "book.h"
+#include "solver.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BOOKGEN_DEFAULT_PATH "book.bin"
+#define BOOKGEN_DEFAULT_DEPTH MAX_ROUND
+#define BOOKGEN_DEFAULT_THREADS 1
+
+/**
+ *	\struct		bookBuilder
+ *	\brief		Represents the decision tree being built.
+ */
+struct bookBuilder
+{
+    bookNode_t *nodes; /**<The nodes, the root first.*/
+    int nbNodes; /**<The number of nodes.*/
+    int capacity; /**<The number of nodes allocated.*/
+    int depth; /**<The number of guesses covered by the tree.*/
+    int maxDepth; /**<The deepest guess of the tree, 1 for the root.*/
+};
+typedef struct bookBuilder bookBuilder_t;
+
+/**
+ *	\fn			uint32_t _bookgenBuild(bookBuilder_t *builder, code_t *candidates, int nbCandidates, int depth)
+ *	\brief		Builds the subtree of a set of candidates.
+ *	\param 		builder : The tree being built.
+ *	\param 		candidates : The codes still possible, reordered by score.
+ *	\param 		nbCandidates : The number of candidates.
+ *	\param 		depth : The number of the guess of the node, 1 for the root.
+ *	\details	The node is added before its children, so the root is the first node. The candidates of each score form the subtree of the score, except for the winning score. Below the depth of the book, the node has no child. Returns the index of the node.
+ */
+uint32_t _bookgenBuild(bookBuilder_t *builder, code_t *candidates, int nbCandidates, int depth);
+
+/**
+ *	\fn			int _bookgenWrite(bookBuilder_t *builder, const char *path)
+ *	\brief		Writes the book.
+ *	\param 		builder : The tree.
+ *	\param 		path : The path of the book file.
+ *	\details	The book is written to a temporary file renamed over the path, so a process mapping the previous book never sees a partial file. Returns 0 on success and -1 on error.
+ */
+int _bookgenWrite(bookBuilder_t *builder, const char *path);
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the generator usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name);
+
+#endif
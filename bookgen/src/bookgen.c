@@ -0,0 +1,180 @@
+/**
+ *	\file		bookgen.c
+ *	\brief		Generates the opening book of the solvers.
+ *
+ *	\details	This file contains the opening book generator. It builds the decision tree of the minimax solver, the guess to play after each path of scores, for the rules the tool is compiled with, and writes it to a file the clients and the bots map at startup.
+ *				Each guess minimizes the worst case, the largest group of codes sharing a score. Ties go to the codes that can still be the secret, then to the smallest code. The guesses are found by the solver of libUtils, whose workers share the search of each node.
+ */
+#include "bookgen.h"
+
+int serverPID = 0; // Read by libUtils, the generator never talks to a server
+solver_t solver;
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the generator.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-o sets the path of the book, -d the number of guesses it covers and -j the number of threads searching the guesses. A summary of the tree is displayed once the book is written.
+ */
+int main(int argc, char *argv[]) {
+    static code_t candidates[NB_CODES];
+    bookBuilder_t builder = {0};
+    struct timespec start, end;
+    const char *path = BOOKGEN_DEFAULT_PATH;
+    int nbThreads = BOOKGEN_DEFAULT_THREADS;
+    int opt;
+
+    builder.depth = BOOKGEN_DEFAULT_DEPTH;
+    while ((opt = getopt(argc, argv, "o:d:j:")) != -1) {
+        switch (opt) {
+            case 'o':
+                path = optarg;
+                break;
+            case 'd':
+                builder.depth = atoi(optarg);
+                break;
+            case 'j':
+                nbThreads = atoi(optarg);
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (builder.depth < 1 || builder.depth > MAX_ROUND || nbThreads < 1 || nbThreads > SOLVER_MAX_WORKERS + 1) {
+        _usage(argv[0]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // The calling thread searches too, the other threads are the workers of the solver
+    if (solverInit(&solver, nbThreads - 1) == -1) {
+        perror("Error: could not start the solver");
+        exit(-1);
+    }
+    for (int i = 0; i < NB_CODES; i++) {
+        candidates[i] = i;
+    }
+    _bookgenBuild(&builder, candidates, NB_CODES, 1);
+    if (_bookgenWrite(&builder, path) == -1) {
+        perror("Error: could not write the book");
+        exit(-1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    solverDestroy(&solver);
+
+    printf("%d nodes, %d guesses at most, %zu bytes written to %s in %.3fs\n",
+           builder.nbNodes, builder.maxDepth, sizeof(bookHeader_t) + builder.nbNodes * sizeof(bookNode_t), path,
+           (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    free(builder.nodes);
+    return 0;
+}
+
+/**
+ *	\fn			uint32_t _bookgenBuild(bookBuilder_t *builder, code_t *candidates, int nbCandidates, int depth)
+ *	\brief		Builds the subtree of a set of candidates.
+ *	\param 		builder : The tree being built.
+ *	\param 		candidates : The codes still possible, reordered by score.
+ *	\param 		nbCandidates : The number of candidates.
+ *	\param 		depth : The number of the guess of the node, 1 for the root.
+ *	\details	The node is added before its children, so the root is the first node. The candidates of each score form the subtree of the score, except for the winning score. Below the depth of the book, the node has no child. Returns the index of the node.
+ */
+uint32_t _bookgenBuild(bookBuilder_t *builder, code_t *candidates, int nbCandidates, int depth) {
+    int counts[BOOK_NB_SCORES] = {0};
+    int starts[BOOK_NB_SCORES];
+    uint32_t children[BOOK_NB_SCORES] = {0};
+    code_t *sorted;
+    uint32_t index;
+    code_t guess;
+    int win = bookScoreIndex(SCORE_WIN);
+    int score;
+
+    if (builder->nbNodes == builder->capacity) {
+        builder->capacity = builder->capacity ? builder->capacity * 2 : 1024;
+        builder->nodes = realloc(builder->nodes, builder->capacity * sizeof(bookNode_t));
+        if (builder->nodes == NULL) {
+            perror("Error: could not allocate the book");
+            exit(-1);
+        }
+    }
+    index = builder->nbNodes++;
+    guess = solverBestGuess(&solver, candidates, nbCandidates, 0, NULL);
+    builder->maxDepth = MAX(builder->maxDepth, depth);
+    if (depth < builder->depth) {
+        // The candidates are grouped by score, each group is the candidates of a child
+        sorted = malloc(nbCandidates * sizeof(code_t));
+        if (sorted == NULL) {
+            perror("Error: could not allocate the book");
+            exit(-1);
+        }
+        for (int i = 0; i < nbCandidates; i++) {
+            counts[bookScoreIndex(CODE_FEEDBACK(guess, candidates[i]))]++;
+        }
+        for (int i = 0, start = 0; i < BOOK_NB_SCORES; i++) {
+            starts[i] = start;
+            start += counts[i];
+        }
+        for (int i = 0; i < nbCandidates; i++) {
+            sorted[starts[bookScoreIndex(CODE_FEEDBACK(guess, candidates[i]))]++] = candidates[i];
+        }
+        memcpy(candidates, sorted, nbCandidates * sizeof(code_t));
+        free(sorted);
+        for (score = 0; score < BOOK_NB_SCORES; score++) {
+            if (score != win && counts[score] > 0) {
+                children[score] = _bookgenBuild(builder, candidates + starts[score] - counts[score], counts[score], depth + 1);
+            }
+        }
+    }
+    // The children may have moved the nodes
+    builder->nodes[index].guess = guess;
+    builder->nodes[index].candidates = nbCandidates;
+    memcpy(builder->nodes[index].children, children, sizeof(children));
+    return index;
+}
+
+/**
+ *	\fn			int _bookgenWrite(bookBuilder_t *builder, const char *path)
+ *	\brief		Writes the book.
+ *	\param 		builder : The tree.
+ *	\param 		path : The path of the book file.
+ *	\details	The book is written to a temporary file renamed over the path, so a process mapping the previous book never sees a partial file. Returns 0 on success and -1 on error.
+ */
+int _bookgenWrite(bookBuilder_t *builder, const char *path) {
+    bookHeader_t header = {0};
+    char temporaryPath[4096];
+    FILE *file;
+    int status = 0;
+
+    memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = BOOK_VERSION;
+    header.boardWidth = BOARD_WIDTH;
+    header.nbColors = NB_COLORS;
+    header.nbNodes = builder->nbNodes;
+    header.depth = builder->depth;
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", path, getpid());
+    if ((file = fopen(temporaryPath, "wb")) == NULL) {
+        return -1;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1
+        || fwrite(builder->nodes, sizeof(bookNode_t), builder->nbNodes, file) != (size_t) builder->nbNodes) {
+        status = -1;
+    }
+    if (fclose(file) != 0 || status == -1 || rename(temporaryPath, path) == -1) {
+        unlink(temporaryPath);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the generator usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s [-o path] [-d depth] [-j threads]\n", name);
+    fprintf(stderr, "  -o  path of the book (default %s)\n", BOOKGEN_DEFAULT_PATH);
+    fprintf(stderr, "  -d  number of guesses covered by the book (1-%d, default %d)\n", MAX_ROUND, BOOKGEN_DEFAULT_DEPTH);
+    fprintf(stderr, "  -j  number of threads searching the guesses (1-%d, default %d)\n", SOLVER_MAX_WORKERS + 1, BOOKGEN_DEFAULT_THREADS);
+    exit(-1);
+}
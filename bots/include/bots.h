@@ -0,0 +1,111 @@
+/**
+ *	\file		bots.c
+ *	\brief		Runs virtual clients for load tests.
+ *
+ *	\details	This file contains the bots tool. It hosts many virtual clients in one process, spread over a few threads, each of them playing random combinations, or the minimax combinations of the solver, until its game is over, and the combinations of an opening book as long as the game stays in the book. In a race game, each virtual client streams the codes its scores have not eliminated yet.
+ *				Virtual clients announce the PID 0 to the server, so the server never signals the bots process.
+ */
+#ifndef BOTS_H
+#define BOTS_H
+
+#include "clientContext.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define BOTS_DEFAULT_CLIENTS 4
+#define BOTS_DEFAULT_THREADS 1
+#define BOTS_IDLE_US 1000 // The time a thread sleeps when none of its clients has a message
+
+/**
+ *	\struct		botsRacer
+ *	\brief		Represents the race state of a virtual client.
+ */
+struct botsRacer
+{
+    uint8_t eliminated[NB_CODES]; /**<1 for the codes inconsistent with the scores received.*/
+    int cursor; /**<The number of codes scanned since the last start over.*/
+    int start; /**<The first code scanned.*/
+};
+typedef struct botsRacer botsRacer_t;
+
+/**
+ *	\struct		botsThread
+ *	\brief		Represents a thread running a slice of the virtual clients.
+ */
+struct botsThread
+{
+    pthread_t thread; /**<The thread.*/
+    clientContext_t *contexts; /**<The contexts of the thread's virtual clients.*/
+    botsRacer_t *racers; /**<The race states of the thread's virtual clients.*/
+    int nbContexts; /**<The number of virtual clients of the thread.*/
+    unsigned int seed; /**<The seed of the thread's random combinations.*/
+    int nbWins; /**<The number of games won by the thread's virtual clients.*/
+    int nbLosses; /**<The number of games lost by the thread's virtual clients.*/
+    int nbLost; /**<The number of virtual clients which lost the server.*/
+    const book_t *book; /**<The opening book shared by the threads, or NULL.*/
+    solver_t *solver; /**<The solver shared by the threads, or NULL for random combinations.*/
+    long nbRaceGuesses; /**<The number of race guesses scored for the thread's virtual clients.*/
+};
+typedef struct botsThread botsThread_t;
+
+/**
+ *	\fn			void *botsThreadHandler(void *args)
+ *	\brief		Runs the virtual clients of a thread.
+ *	\param 		args : The thread, a botsThread_t.
+ *	\details	The virtual clients are connected and made ready, then stepped in turn until all their games are over. A virtual client typing its combination plays the one of the book, or out of the book the one of the solver or a random one. A racing virtual client keeps its window of race messages full. The thread sleeps BOTS_IDLE_US when none of its clients has a message.
+ */
+void *botsThreadHandler(void *args);
+
+/**
+ *	\fn			void _botsRandomCombination(char *combination, unsigned int *seed)
+ *	\brief		Draws a random combination.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\param 		seed : The seed of the thread.
+ */
+void _botsRandomCombination(char *combination, unsigned int *seed);
+
+/**
+ *	\fn			void _botsRaceFill(clientContext_t *context, botsRacer_t *racer)
+ *	\brief		Streams the next guesses of a racing virtual client.
+ *	\param 		context : The context of the virtual client.
+ *	\param 		racer : The race state of the virtual client.
+ *	\details	The codes not eliminated yet are sent in order from the cursor, until the window of messages in flight is full. Once every code has been sent, the cursor starts over with the codes still possible.
+ */
+void _botsRaceFill(clientContext_t *context, botsRacer_t *racer);
+
+/**
+ *	\fn			void _botsRaceScored(botsRacer_t *racer, const clientRaceMessage_t *result)
+ *	\brief		Eliminates the codes inconsistent with race scores.
+ *	\param 		racer : The race state of the virtual client.
+ *	\param 		result : The guesses and their scores.
+ */
+void _botsRaceScored(botsRacer_t *racer, const clientRaceMessage_t *result);
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the bots usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name);
+
+/**
+ *	\fn			void signalHandlerStop(int signum)
+ *	\brief		Stops the bots.
+ *	\param 		signum : The signal number.
+ */
+void signalHandlerStop(int signum);
+
+/**
+ *	\fn			void cleanup()
+ *	\brief		Closes the connections of the virtual clients on exit.
+ *	\details	The queues of the games that are not over are removed.
+ */
+void cleanup();
+
+#endif
@@ -0,0 +1,292 @@
+/**
+ *	\file		bots.c
+ *	\brief		Runs virtual clients for load tests.
+ *
+ *	\details	This file contains the bots tool. It hosts many virtual clients in one process, spread over a few threads, each of them playing random combinations, or the minimax combinations of the solver, until its game is over, and the combinations of an opening book as long as the game stays in the book. In a race game, each virtual client streams the codes its scores have not eliminated yet.
+ *				Virtual clients announce the PID 0 to the server, so the server never signals the bots process.
+ */
+#include "bots.h"
+
+int serverPID = 0;
+clientContext_t *contexts = NULL;
+int nbContexts = 0;
+book_t book = {0};
+solver_t solver;
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the bots.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-n sets the number of virtual clients, -j the number of threads, -b the opening book and -m the number of workers of the solver, the virtual clients playing random combinations without it. The virtual clients are split between the threads, and a summary is displayed once all the games are over.
+ */
+int main(int argc, char *argv[]) {
+    botsThread_t *threads;
+    botsRacer_t *racers;
+    struct timespec start, end;
+    double elapsed;
+    long nbRaceGuesses = 0;
+    int nbThreads = BOTS_DEFAULT_THREADS;
+    int nbSolverWorkers = -1;
+    int nbWins = 0, nbLosses = 0, nbLost = 0;
+    int first = 0;
+    int opt;
+
+    nbContexts = BOTS_DEFAULT_CLIENTS;
+    while ((opt = getopt(argc, argv, "n:j:b:m:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nbContexts = atoi(optarg);
+                break;
+            case 'j':
+                nbThreads = atoi(optarg);
+                break;
+            case 'b':
+                if (bookOpen(&book, optarg) == -1) {
+                    fprintf(stderr, "Error: %s is not an opening book for these rules.\n", optarg);
+                    exit(-1);
+                }
+                break;
+            case 'm':
+                nbSolverWorkers = atoi(optarg);
+                if (nbSolverWorkers < 0 || nbSolverWorkers > SOLVER_MAX_WORKERS) {
+                    _usage(argv[0]);
+                }
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (nbContexts < 1 || nbThreads < 1) {
+        _usage(argv[0]);
+    }
+    if (nbThreads > nbContexts) {
+        nbThreads = nbContexts;
+    }
+
+    contexts = malloc(nbContexts * sizeof(clientContext_t));
+    threads = malloc(nbThreads * sizeof(botsThread_t));
+    racers = calloc(nbContexts, sizeof(botsRacer_t));
+    if (contexts == NULL || threads == NULL || racers == NULL) {
+        perror("Error: could not allocate the virtual clients");
+        exit(-1);
+    }
+    for (int i = 0; i < nbContexts; i++) {
+        contexts[i].game.msgid = -1;
+    }
+    codeFeedbackInit();
+    if (nbSolverWorkers >= 0 && solverInit(&solver, nbSolverWorkers) == -1) {
+        perror("Error: could not start the solver");
+        exit(-1);
+    }
+    traceInit("bots");
+    signal(SIGINT, signalHandlerStop);
+    signal(SIGTERM, signalHandlerStop);
+    atexit(cleanup);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < nbThreads; i++) {
+        threads[i].contexts = contexts + first;
+        threads[i].racers = racers + first;
+        threads[i].nbRaceGuesses = 0;
+        threads[i].nbContexts = nbContexts / nbThreads + (i < nbContexts % nbThreads);
+        threads[i].seed = time(NULL) ^ (i * 2654435761u);
+        threads[i].nbWins = 0;
+        threads[i].nbLosses = 0;
+        threads[i].nbLost = 0;
+        threads[i].book = book.header != NULL ? &book : NULL;
+        threads[i].solver = nbSolverWorkers >= 0 ? &solver : NULL;
+        first += threads[i].nbContexts;
+        if (pthread_create(&threads[i].thread, NULL, botsThreadHandler, &threads[i]) != 0) {
+            perror("Error: could not create a bots thread");
+            exit(-1);
+        }
+    }
+    for (int i = 0; i < nbThreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+        nbWins += threads[i].nbWins;
+        nbLosses += threads[i].nbLosses;
+        nbLost += threads[i].nbLost;
+        nbRaceGuesses += threads[i].nbRaceGuesses;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%d virtual clients on %d threads in %.3fs\n", nbContexts, nbThreads, elapsed);
+    printf("Wins: %d, losses: %d, lost connections: %d\n", nbWins, nbLosses, nbLost);
+    if (nbRaceGuesses > 0) {
+        printf("Race guesses scored: %ld (%.0f/s)\n", nbRaceGuesses, nbRaceGuesses / elapsed);
+    }
+    if (nbSolverWorkers >= 0) {
+        printf("Minimax searches: %ld, %ld with the workers, %ld answered by the memo\n", solver.nbSearches, solver.nbParallel, solver.nbMemoized);
+        solverDestroy(&solver);
+    }
+    free(racers);
+    free(threads);
+    return nbLost == 0 ? 0 : 1;
+}
+
+/**
+ *	\fn			void *botsThreadHandler(void *args)
+ *	\brief		Runs the virtual clients of a thread.
+ *	\param 		args : The thread, a botsThread_t.
+ *	\details	The virtual clients are connected and made ready, then stepped in turn until all their games are over. A virtual client typing its combination plays the one of the book, or out of the book the one of the solver or a random one. A racing virtual client keeps its window of race messages full. The thread sleeps BOTS_IDLE_US when none of its clients has a message.
+ */
+void *botsThreadHandler(void *args) {
+    botsThread_t *thread = (botsThread_t *)args;
+    clientContext_t *context;
+    char combination[BOARD_WIDTH + 1];
+    int nbPlaying = thread->nbContexts;
+    int active;
+    int event;
+
+    for (int i = 0; i < thread->nbContexts; i++) {
+        clientConnect(&thread->contexts[i], SERVER_LISTENNING_KEY, 0);
+        clientReady(&thread->contexts[i]);
+    }
+    while (nbPlaying > 0) {
+        active = 0;
+        for (int i = 0; i < thread->nbContexts; i++) {
+            context = &thread->contexts[i];
+            if (context->state == CLIENT_OVER || context->state == CLIENT_LOST) {
+                continue;
+            }
+            event = clientStep(context);
+            while (event == CLIENT_EVENT_RACE) {
+                _botsRaceScored(&thread->racers[i], &context->raceResult);
+                thread->nbRaceGuesses += context->raceResult.nbScores;
+                event = clientStep(context);
+            }
+            if (event != CLIENT_EVENT_NONE) {
+                active = 1;
+            }
+            if (context->state == CLIENT_RACING && context->raceCount < CLIENT_RACE_WINDOW) {
+                if (thread->racers[i].start == 0 && thread->racers[i].cursor == 0) {
+                    thread->racers[i].start = rand_r(&thread->seed) % NB_CODES;
+                }
+                _botsRaceFill(context, &thread->racers[i]);
+                active = 1;
+            }
+            if (context->state == CLIENT_TYPING) {
+                if ((thread->book == NULL || clientBookCombination(context, thread->book, combination) == -1)
+                    && (thread->solver == NULL || clientSolverCombination(context, thread->solver, rand_r(&thread->seed) % NB_CODES, combination) == -1)) {
+                    _botsRandomCombination(combination, &thread->seed);
+                }
+                clientSendCombination(context, combination);
+                active = 1;
+            }
+            if (context->state == CLIENT_OVER) {
+                if (context->winner == context->game.playerIndex) {
+                    thread->nbWins++;
+                } else {
+                    thread->nbLosses++;
+                }
+                nbPlaying--;
+            } else if (context->state == CLIENT_LOST) {
+                thread->nbLost++;
+                clientClose(context);
+                nbPlaying--;
+            }
+        }
+        if (!active) {
+            usleep(BOTS_IDLE_US);
+        }
+    }
+    return NULL;
+}
+
+/**
+ *	\fn			void _botsRandomCombination(char *combination, unsigned int *seed)
+ *	\brief		Draws a random combination.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\param 		seed : The seed of the thread.
+ */
+void _botsRandomCombination(char *combination, unsigned int *seed) {
+    char colors[] = "RGBCYM";
+    for (int i = 0; i < BOARD_WIDTH; i++) {
+        combination[i] = colors[rand_r(seed) % (sizeof(colors) - 1)];
+    }
+    combination[BOARD_WIDTH] = '\0';
+}
+
+/**
+ *	\fn			void _botsRaceFill(clientContext_t *context, botsRacer_t *racer)
+ *	\brief		Streams the next guesses of a racing virtual client.
+ *	\param 		context : The context of the virtual client.
+ *	\param 		racer : The race state of the virtual client.
+ *	\details	The codes not eliminated yet are sent in order from the cursor, until the window of messages in flight is full. Once every code has been sent, the cursor starts over with the codes still possible.
+ */
+void _botsRaceFill(clientContext_t *context, botsRacer_t *racer) {
+    code_t guesses[RACE_GUESSES_PER_MESSAGE];
+    int nbGuesses;
+    code_t code;
+    while (context->raceCount < CLIENT_RACE_WINDOW) {
+        nbGuesses = 0;
+        while (nbGuesses < RACE_GUESSES_PER_MESSAGE && racer->cursor < NB_CODES) {
+            code = (racer->start + racer->cursor++) % NB_CODES;
+            if (!racer->eliminated[code]) {
+                guesses[nbGuesses++] = code;
+            }
+        }
+        if (racer->cursor == NB_CODES) {
+            racer->cursor = 0;
+        }
+        if (nbGuesses == 0 || clientRaceSend(context, guesses, nbGuesses) == -1) {
+            return;
+        }
+    }
+}
+
+/**
+ *	\fn			void _botsRaceScored(botsRacer_t *racer, const clientRaceMessage_t *result)
+ *	\brief		Eliminates the codes inconsistent with race scores.
+ *	\param 		racer : The race state of the virtual client.
+ *	\param 		result : The guesses and their scores.
+ */
+void _botsRaceScored(botsRacer_t *racer, const clientRaceMessage_t *result) {
+    for (int i = 0; i < result->nbScores; i++) {
+        for (int code = 0; code < NB_CODES; code++) {
+            if (CODE_FEEDBACK(result->guesses[i], code) != result->scores[i]) {
+                racer->eliminated[code] = 1;
+            }
+        }
+    }
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the bots usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s [-n clients] [-j threads] [-b book] [-m solver workers]\n", name);
+    fprintf(stderr, "  -n  number of virtual clients (default %d)\n", BOTS_DEFAULT_CLIENTS);
+    fprintf(stderr, "  -j  number of threads (default %d)\n", BOTS_DEFAULT_THREADS);
+    fprintf(stderr, "  -b  opening book generated by bookgen (default random combinations)\n");
+    fprintf(stderr, "  -m  play the minimax combinations, with this number of threads helping the solver (0-%d, default random combinations)\n", SOLVER_MAX_WORKERS);
+    exit(-1);
+}
+
+/**
+ *	\fn			void signalHandlerStop(int signum)
+ *	\brief		Stops the bots.
+ *	\param 		signum : The signal number.
+ */
+void signalHandlerStop(int signum) {
+    printf("Caught signal %d\n", signum);
+    exit(signum);
+}
+
+/**
+ *	\fn			void cleanup()
+ *	\brief		Closes the connections of the virtual clients on exit.
+ *	\details	The queues of the games that are not over are removed.
+ */
+void cleanup() {
+    for (int i = 0; i < nbContexts; i++) {
+        if (contexts[i].game.msgid != -1) {
+            clientClose(&contexts[i]);
+        }
+    }
+}
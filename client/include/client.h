@@ -2,7 +2,7 @@
  *	\file		client.c
  *	\brief		Handles the main game loop for the client.
  *
- *	\details	This file contains the main game loop and the functions for checking if the game is over and ending the game.
+ *	\details	This file contains the main game loop and the function ending the game.
  */
 #ifndef CLIENT_H
 #define CLIENT_H
@@ -12,27 +12,31 @@
 #include "clientInit.h" 
 #include "clientShow.h" 
 #include "clientCommunication.h" 
+#include "clientEditor.h" 
+#include "clientContext.h" 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <signal.h>
+#include <poll.h>
 
 /**
- *	\fn			int isGameOver(game_t game)
- *	\brief		Checks if the game is over.
- *	\param 		game : The game state.
- *	\details		Returns 1 if the game is over (either the player has found the secret combination, the maximum number of rounds has been reached, or another player has found the secret combination), and 0 otherwise.
+ *	\fn			void playGame(clientContext_t *context, editor_t *editor)
+ *	\brief		The main game loop.
+ *	\param 		context : The client context.
+ *	\param 		editor : The line editor reading the player's input.
+ *	\details    The loop handles the player's input and the server messages at the same time. Message queues cannot be polled, so stdin is polled with a timeout of CLIENT_POLL_MS and the context is stepped between two polls. The game is shown at the end of each round. In a race game, the guesses are sent as soon as they are typed, and their scores are shown as they come. The loop returns as soon as the server ends the game, even while the player is typing. If the input is closed while the player has to type, the client leaves the game: it closes its queue, tells the server and exits with an error.
  */
-int isGameOver(game_t game);
+void playGame(clientContext_t *context, editor_t *editor);
 
 /**
- *	\fn			void endGame(game_t game)
+ *	\fn			void endGame(clientContext_t *context)
  *	\brief		Ends the game.
- *	\param 		game : The game state.
+ *	\param 		context : The client context, once the game is over.
  *	\details		Displays a message indicating whether the player has won or lost, who the winner is (if there is one), and what the secret combination was.
  */
-void endGame(game_t game);
+void endGame(clientContext_t *context);
 
 /**
  *	\fn			void signalHandlerRegister (game_t game)
@@ -54,7 +58,7 @@ void signalHandlerStop(int signum);
  *	\fn			void signalHandlerUSR(int signum)
  *	\brief		Handle client cleanup on exit.
  *	\param 		signum : The signal number.
- *	\details	Remove the client's message queue and send a SIGUSR1 signal to the server to stop the game.
+ *	\details	Restores the terminal and closes the connection. Once the game has ended, the queue is removed by the server.
  */
 void cleanup();
 
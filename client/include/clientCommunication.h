@@ -3,13 +3,16 @@
  *	\brief		Handles the client-side communication for the game.
  *
  *	\details	This file contains the functions necessary for the client-side communication of the game.
- *				It includes functions for connecting to the server, receiving game results, and fetching data from other clients.
+ *				It includes the functions connecting the player to the server and checking the combinations typed by the player. The protocol itself is implemented by the client library.
  */
 #ifndef COMMUNICATION_H
 #define COMMUNICATION_H
 
 #include "utils.h"
 #include "clientData.h"
+#include "clientEditor.h"
+#include "clientContext.h"
+#include <poll.h>
 #include <ctype.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
@@ -17,42 +20,26 @@
 #include <string.h>
 
 
-#define SERVER_LISTENNING_KEY 58392
+#define CLIENT_POLL_MS 20
 
-/**
- *	\fn			void connectionWithServer(game_t *game)
- *	\brief		Establishes a connection with the server.
- *	\param 		game : The game structure that contains the game's state.
- *	\note		The user is prompted to enter the server's IP and port. If no input is given, default values are used.
- *  \details    The player is prompted to enter the server's IP and port. If no input is given, default values are used. The player is then prompted to enter 'ready' to indicate that they are ready to play. The number of players and the player's index are then received from the server.
- */
-void connexionWithServer(game_t *game);
-
-/**
- *	\fn			void sendCombination(game_t *game)
- *	\brief		Sends the player's color combination to the server.
- *	\param 		game : The game structure that contains the game's state.
- *	\note		The player is prompted to enter a combination of colors. The combination is validated before being sent.
- *	\details    The player is prompted to enter a combination of colors. The combination is validated before being sent.
- */
-void sendCombination(game_t *game);
+extern int serverPID;
 
 /**
- *	\fn			void getResult(game_t *game)
- *	\brief		Gets the result of the current round from the server.
- *	\param 		game : The game structure that contains the game's state.
- *  \details    The result of the current round is received from the server and stored in the game's result array.
+ *	\fn			void connectionWithServer(clientContext_t *context, editor_t *editor)
+ *	\brief		Establishes a connection with the server.
+ *	\param 		context : The client context.
+ *	\param 		editor : The line editor reading the player's input.
+ *  \details    The player is prompted to enter 'ready' to indicate that they are ready to play. The client then waits for the server to start the game, which gives the number of players and the player's index.
  */
-void getResult(game_t *game);
+void connexionWithServer(clientContext_t *context, editor_t *editor);
 
 /**
- *	\fn			void fetchOtherClientsData(game_t *game)
- *	\brief		Fetches data from other clients connected to the server.
- *	\param 		game : The game structure that contains the game's state.
- *	\details    The data of the other clients is received from the server and stored in the game's otherPlayers array.
+ *	\fn			int checkCombination(char *combination)
+ *	\brief		Checks the color combination entered by the player.
+ *	\param 		combination : The combination, put in upper case.
+ *	\details    Returns 1 if the combination is made of exactly 4 valid colors. Otherwise the error is displayed and 0 is returned.
  */
-void fetchOtherClientsData(game_t *game);
-
+int checkCombination(char *combination);
 
 
 
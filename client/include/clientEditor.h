@@ -0,0 +1,92 @@
+/**
+ *	\file		clientEditor.c
+ *	\brief		Handles the line editor of the client.
+ *
+ *	\details	This file contains the functions of the line editor reading the player's input.
+ *				The terminal is put in non-canonical mode, so the input is read byte by byte without blocking and the client can handle the server messages while the player is typing.
+ */
+#ifndef EDITOR_H
+#define EDITOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+#define EDITOR_LINE_SIZE 64
+#define EDITOR_INPUT_SIZE 256
+#define EDITOR_BACKSPACE 127
+#define EDITOR_ERASE_LINE 21 // Ctrl-U
+
+/**
+ *	\struct		editor
+ *	\brief		Represents the state of the line editor.
+ */
+struct editor
+{
+    char line[EDITOR_LINE_SIZE]; /**<The line being edited.*/
+    int length; /**<The length of the line being edited.*/
+    char input[EDITOR_INPUT_SIZE]; /**<The bytes read from stdin and not edited yet.*/
+    int inputStart; /**<The index of the first byte not edited yet.*/
+    int inputEnd; /**<The index after the last byte read.*/
+    int isTerminal; /**<1 if stdin is a terminal put in non-canonical mode.*/
+    int closed; /**<1 once stdin has reached the end of file.*/
+    struct termios savedTermios; /**<The terminal settings restored at exit.*/
+};
+typedef struct editor editor_t;
+
+/**
+ *	\fn			void editorInit(editor_t *editor)
+ *	\brief		Initializes the line editor.
+ *	\param 		editor : The line editor.
+ *	\details	If stdin is a terminal, it is put in non-canonical mode without echo. The editor echoes the characters itself.
+ */
+void editorInit(editor_t *editor);
+
+/**
+ *	\fn			void editorRestore(editor_t *editor)
+ *	\brief		Restores the terminal.
+ *	\param 		editor : The line editor.
+ *	\details	The terminal settings saved by editorInit are restored.
+ */
+void editorRestore(editor_t *editor);
+
+/**
+ *	\fn			int editorRead(editor_t *editor)
+ *	\brief		Reads the bytes available on stdin.
+ *	\param 		editor : The line editor.
+ *	\details	Must be called when stdin is readable. Returns the number of bytes read, 0 at the end of file.
+ */
+int editorRead(editor_t *editor);
+
+/**
+ *	\fn			int editorNextLine(editor_t *editor, char *line, size_t size)
+ *	\brief		Edits the bytes already read.
+ *	\param 		editor : The line editor.
+ *	\param 		line : The buffer where the completed line is stored.
+ *	\param 		size : The size of the buffer.
+ *	\details	The bytes read are applied to the line until it is completed by a new line. Returns 1 if a line was completed, the bytes after it are kept for the next line, and 0 otherwise.
+ */
+int editorNextLine(editor_t *editor, char *line, size_t size);
+
+/**
+ *	\fn			int editorGetLine(editor_t *editor, char *line, size_t size)
+ *	\brief		Waits for a line.
+ *	\param 		editor : The line editor.
+ *	\param 		line : The buffer where the line is stored.
+ *	\param 		size : The size of the buffer.
+ *	\details	Blocks until the player has completed a line. Returns 0 on success and -1 at the end of file.
+ */
+int editorGetLine(editor_t *editor, char *line, size_t size);
+
+/**
+ *	\fn			void editorInterrupt(editor_t *editor)
+ *	\brief		Leaves the line being edited.
+ *	\param 		editor : The line editor.
+ *	\details	Called before displaying a server event while the player is typing.
+ */
+void editorInterrupt(editor_t *editor);
+
+#endif
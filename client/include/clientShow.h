@@ -8,6 +8,7 @@
 #define SHOW_H
 
 #include "clientData.h" 
+#include "clientContext.h"
 #include <stdio.h> 
 
 
@@ -43,12 +44,27 @@
 void showMenu();
 
 /**
- *	\fn			void showGame(game_t game)
+ *	\fn			void showGame(const game_t *game)
  *	\brief		Displays the current game state.
  *	\param 		game : The game state to be displayed.
  *  \details	The game state is printed to the console with the appropriate format.
  */
-void showGame(game_t game);
+void showGame(const game_t *game);
+
+/**
+ *	\fn			void showRaceResult(const clientRaceMessage_t *result)
+ *	\brief		Displays the scores of race guesses.
+ *	\param 		result : The guesses and their scores.
+ *	\details	Each scored guess is printed on its own line with its score.
+ */
+void showRaceResult(const clientRaceMessage_t *result);
+
+/**
+ *	\fn			void showPrompt()
+ *	\brief		Displays the prompt of the combination.
+ *	\details	The prompt is flushed, the line editor reads the combination after it.
+ */
+void showPrompt();
 
 /**
  *	\fn			void showChar(char c)
@@ -2,86 +2,129 @@
  *	\file		client.c
  *	\brief		Handles the main game loop for the client.
  *
- *	\details	This file contains the main game loop and the functions for checking if the game is over and ending the game.
+ *	\details	This file contains the main game loop and the function ending the game.
  */
 #include "client.h"
 
 
 int serverPID = 0;
-int clientPIDs[MAX_PLAYERS+1] = {0};
+editor_t editor;
+clientContext_t context = {.game.msgid = -1};
 
 /**
  *	\fn			int main()
- *	\brief		The main game loop.
- *	\details    Shows the menu, initializes the game, connects to the server, and then enters the main game loop. The main game loop consists of sending the player's combination to the server, receiving the result of the combination, fetching the data of the other players, and showing the game state. The loop continues until the game is over.    
+ *	\brief		The main function of the client.
+ *	\details    Shows the menu, connects to the server, and then plays the game in the game loop until the server ends the game.
  */
 int main() {
-    game_t game;
     signalHandlerRegister();
+    traceInit("client");
+    editorInit(&editor);
     showMenu();
-    initGame(&game);
-    connexionWithServer(&game);
-    showGame(game); 
-
-    while (!isGameOver(game)){
-        sendCombination(&game);
-        getResult(&game);
-        fetchOtherClientsData(&game);
-        showGame(game); //show game
-        game.nbRound++;
-    }
-    endGame(game); //end game
+    connexionWithServer(&context, &editor);
+    showGame(&context.game); 
+    playGame(&context, &editor);
+    endGame(&context); //end game
 
     return 0;
 }
 
 /**
- *	\fn			int isGameOver(game_t game)
- *	\brief		Checks if the game is over.
- *	\param 		game : The game state.
- *	\details		Returns 1 if the game is over (either the player has found the secret combination, the maximum number of rounds has been reached, or another player has found the secret combination), and 0 otherwise.
+ *	\fn			void playGame(clientContext_t *context, editor_t *editor)
+ *	\brief		The main game loop.
+ *	\param 		context : The client context.
+ *	\param 		editor : The line editor reading the player's input.
+ *	\details    The loop handles the player's input and the server messages at the same time. Message queues cannot be polled, so stdin is polled with a timeout of CLIENT_POLL_MS and the context is stepped between two polls. The game is shown at the end of each round. In a race game, the guesses are sent as soon as they are typed, and their scores are shown as they come. The loop returns as soon as the server ends the game, even while the player is typing. If the input is closed while the player has to type, the client leaves the game: it closes its queue, tells the server and exits with an error.
  */
-int isGameOver(game_t game) {
-    if (game.result[game.nbRound - 1][0] == BOARD_WIDTH) {
-        return 1;
-    } else if (game.nbRound == MAX_ROUND) {
-        return 1;
-    } else {
-        for (int i = 0; i < game.nbPlayers - 1; i++) {
-            if (game.otherPlayers[i].nbGoodPlace == BOARD_WIDTH) {
-                return 1;
+void playGame(clientContext_t *context, editor_t *editor) {
+    struct pollfd stdinPoll = {.fd = STDIN_FILENO, .events = POLLIN};
+    char line[EDITOR_LINE_SIZE];
+    int previousState;
+    code_t guess;
+    int typing;
+    int event;
+
+    showPrompt();
+    while (1) {
+        previousState = context->state;
+        event = clientStep(context);
+        if (event == CLIENT_EVENT_LOST) {
+            fprintf(stderr, "Error: lost the server.\n");
+            exit(-1);
+        }
+        if ((previousState == CLIENT_TYPING || previousState == CLIENT_RACING) && context->state != previousState) {
+            editorInterrupt(editor);
+        }
+        if (event == CLIENT_EVENT_OVER) {
+            return;
+        }
+        if (event == CLIENT_EVENT_ROUND) {
+            showGame(&context->game);
+            if (context->state == CLIENT_FINISHED) {
+                if (context->game.nbRound == MAX_ROUND) {
+                    printf("Waiting for other players to finish the game...\n");
+                }
+                printf("Waiting for other players to finish their round...\n");
+            } else {
+                showPrompt();
+            }
+            continue;
+        }
+        if (event == CLIENT_EVENT_RACE) {
+            editorInterrupt(editor);
+            showRaceResult(&context->raceResult);
+            showPrompt();
+            continue;
+        }
+        typing = context->state == CLIENT_TYPING || context->state == CLIENT_RACING;
+        if (typing && editorNextLine(editor, line, sizeof(line))) {
+            if (context->state == CLIENT_RACING) {
+                if (checkCombination(line) && codePack(line, &guess) == 0 && clientRaceSend(context, &guess, 1) == -1) {
+                    if (context->state == CLIENT_LOST) {
+                        fprintf(stderr, "Error: lost the server.\n");
+                        exit(-1);
+                    }
+                    printf("Error: too many guesses waiting for their score. Please try again.\n");
+                }
+                showPrompt();
+            } else if (checkCombination(line)) {
+                CHECK(clientSendCombination(context, line), "Error: lost the server");
+            } else {
+                showPrompt();
             }
+            continue;
+        }
+        if (typing && editor->closed) {
+            fprintf(stderr, "Error: the input was closed before the end of the game.\n");
+            clientClose(context);
+            if (serverPID > 0) {
+                kill(serverPID, SIGUSR1);
+            }
+            exit(-1);
+        }
+        // Without pending input the poll only waits for the next step of the context
+        stdinPoll.fd = (typing && !editor->closed) ? STDIN_FILENO : -1;
+        if (poll(&stdinPoll, 1, CLIENT_POLL_MS) > 0) {
+            editorRead(editor);
         }
     }
-    return 0;
 }
 
 /**
- *	\fn			void endGame(game_t game)
+ *	\fn			void endGame(clientContext_t *context)
  *	\brief		Ends the game.
- *	\param 		game : The game state.
+ *	\param 		context : The client context, once the game is over.
  *	\details	Displays a message indicating whether the player has won or lost, who the winner is (if there is one), and what the secret combination was.
  */
-void endGame(game_t game) {
-    char buffer[10];
-    int winner = EMPTY;
-    if (game.nbRound == MAX_ROUND) {
-        printf("Waiting for other players to finish the game...\n");
-    }
-    printf("Waiting for other players to finish their round...\n");
-    receiveData(game.msgid, buffer, 6);
-    if (strcmp(buffer, "win") == 0) {
+void endGame(clientContext_t *context) {
+    if (context->winner == context->game.playerIndex) {
         printf("Congratulations! You won the game!\n");
+    } else if (context->winner == EMPTY) {
+        printf("Sorry, you lost the game. Nobody found the secret combination.\n");
     } else {
-        sscanf(buffer, "loose:%d", &winner);
-        if (winner == EMPTY) {
-            printf("Sorry, you lost the game. Nobody found the secret combination.\n");
-        } else {
-            printf("Sorry, you lost the game. The winner is player %d.\n", winner+1);
-        }
+        printf("Sorry, you lost the game. The winner is player %d.\n", context->winner+1);
     }
-    receiveData(game.msgid, buffer, 7);
-    printf("The secret combination was %s.\n", buffer);
+    printf("The secret combination was %s.\n", context->secretCode);
 }
 
 
@@ -105,12 +148,17 @@ void signalHandlerRegister() {
 void signalHandlerStop(int signum) {
     printf("Caught signal %d\n", signum);
     printf("Game stopped.\n");
-    kill(serverPID, SIGUSR1);
+    if (serverPID > 0) {
+        kill(serverPID, SIGUSR1);
+    }
     exit(signum);
 }
 
 void cleanup() {
+    editorRestore(&editor);
     printf("Cleaning up...\n");
-    msgctl(msgget(ftok("client", getpid()), 0666), IPC_RMID, NULL);
+    if (context.game.msgid != -1) {
+        clientClose(&context);
+    }
 }
 
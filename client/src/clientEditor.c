@@ -0,0 +1,148 @@
+/**
+ *	\file		clientEditor.c
+ *	\brief		Handles the line editor of the client.
+ *
+ *	\details	This file contains the functions of the line editor reading the player's input.
+ *				The terminal is put in non-canonical mode, so the input is read byte by byte without blocking and the client can handle the server messages while the player is typing.
+ */
+#include "clientEditor.h"
+
+/**
+ *	\fn			void editorInit(editor_t *editor)
+ *	\brief		Initializes the line editor.
+ *	\param 		editor : The line editor.
+ *	\details	If stdin is a terminal, it is put in non-canonical mode without echo. The editor echoes the characters itself.
+ */
+void editorInit(editor_t *editor) {
+    struct termios raw;
+    editor->length = 0;
+    editor->inputStart = 0;
+    editor->inputEnd = 0;
+    editor->closed = 0;
+    editor->isTerminal = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &editor->savedTermios) == 0;
+    if (editor->isTerminal) {
+        raw = editor->savedTermios;
+        // Signals are kept so Ctrl-C still stops the client
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+}
+
+/**
+ *	\fn			void editorRestore(editor_t *editor)
+ *	\brief		Restores the terminal.
+ *	\param 		editor : The line editor.
+ *	\details	The terminal settings saved by editorInit are restored.
+ */
+void editorRestore(editor_t *editor) {
+    if (editor->isTerminal) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &editor->savedTermios);
+        editor->isTerminal = 0;
+    }
+}
+
+/**
+ *	\fn			int editorRead(editor_t *editor)
+ *	\brief		Reads the bytes available on stdin.
+ *	\param 		editor : The line editor.
+ *	\details	Must be called when stdin is readable. Returns the number of bytes read, 0 at the end of file.
+ */
+int editorRead(editor_t *editor) {
+    int nbBytes;
+    if (editor->inputStart == editor->inputEnd) {
+        editor->inputStart = 0;
+        editor->inputEnd = 0;
+    }
+    if (editor->inputEnd == EDITOR_INPUT_SIZE) {
+        // The pending bytes are edited before reading more
+        return 1;
+    }
+    nbBytes = read(STDIN_FILENO, editor->input + editor->inputEnd, EDITOR_INPUT_SIZE - editor->inputEnd);
+    if (nbBytes <= 0) {
+        editor->closed = 1;
+        return 0;
+    }
+    editor->inputEnd += nbBytes;
+    return nbBytes;
+}
+
+/**
+ *	\fn			int editorNextLine(editor_t *editor, char *line, size_t size)
+ *	\brief		Edits the bytes already read.
+ *	\param 		editor : The line editor.
+ *	\param 		line : The buffer where the completed line is stored.
+ *	\param 		size : The size of the buffer.
+ *	\details	The bytes read are applied to the line until it is completed by a new line. Returns 1 if a line was completed, the bytes after it are kept for the next line, and 0 otherwise.
+ */
+int editorNextLine(editor_t *editor, char *line, size_t size) {
+    char c;
+    while (editor->inputStart < editor->inputEnd) {
+        c = editor->input[editor->inputStart++];
+        if (c == '\n') {
+            if (editor->isTerminal) {
+                printf("\n");
+            }
+            editor->line[editor->length] = '\0';
+            strncpy(line, editor->line, size - 1);
+            line[size - 1] = '\0';
+            editor->length = 0;
+            return 1;
+        } else if (c == EDITOR_BACKSPACE || c == '\b') {
+            if (editor->length > 0) {
+                editor->length--;
+                if (editor->isTerminal) {
+                    printf("\b \b");
+                }
+            }
+        } else if (c == EDITOR_ERASE_LINE) {
+            while (editor->isTerminal && editor->length > 0) {
+                editor->length--;
+                printf("\b \b");
+            }
+            editor->length = 0;
+        } else if (c >= ' ' && c <= '~' && editor->length < EDITOR_LINE_SIZE - 1) {
+            editor->line[editor->length++] = c;
+            if (editor->isTerminal) {
+                printf("%c", c);
+            }
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
+
+/**
+ *	\fn			int editorGetLine(editor_t *editor, char *line, size_t size)
+ *	\brief		Waits for a line.
+ *	\param 		editor : The line editor.
+ *	\param 		line : The buffer where the line is stored.
+ *	\param 		size : The size of the buffer.
+ *	\details	Blocks until the player has completed a line. Returns 0 on success and -1 at the end of file.
+ */
+int editorGetLine(editor_t *editor, char *line, size_t size) {
+    struct pollfd stdinPoll = {.fd = STDIN_FILENO, .events = POLLIN};
+    fflush(stdout);
+    while (!editorNextLine(editor, line, size)) {
+        if (editor->closed) {
+            return -1;
+        }
+        if (poll(&stdinPoll, 1, -1) > 0) {
+            editorRead(editor);
+        }
+    }
+    return 0;
+}
+
+/**
+ *	\fn			void editorInterrupt(editor_t *editor)
+ *	\brief		Leaves the line being edited.
+ *	\param 		editor : The line editor.
+ *	\details	Called before displaying a server event while the player is typing.
+ */
+void editorInterrupt(editor_t *editor) {
+    if (editor->isTerminal) {
+        printf("\n");
+    }
+}
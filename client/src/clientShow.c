@@ -20,30 +20,30 @@ void showMenu() {
 }
 
 /**
- *	\fn			void showGame(game_t game)
+ *	\fn			void showGame(const game_t *game)
  *	\brief		Displays the current game state.
  *	\param 		game : The game state to be displayed.
  *  \details	The game state is printed to the console with the appropriate format.
  */
-void showGame(game_t game) {
+void showGame(const game_t *game) {
 
-    printf("\n\n\n                                  Player %d\n", game.playerIndex+1);
+    printf("\n\n\n                                  Player %d\n", game->playerIndex+1);
     printf(ANSI_COLOR_GREEN"Right color, Right place"ANSI_RESET_ALL"    ┌───┬─────────────┬───┐    "ANSI_COLOR_YELLOW"Right color, Wrong place"ANSI_RESET_ALL"\n");
     for (int i = 0; i < MAX_ROUND; i++) {
         printf("                            │");
         printf(" ");
-        showChar(game.result[MAX_ROUND - i-1][0]);
+        showChar(game->result[MAX_ROUND - i-1][0]);
         printf(" ");
         printf("│");
         printf(" ");
         for (int j = 0; j < BOARD_WIDTH; j++) {
             
-            showChar(game.board[MAX_ROUND - i-1][j]);
+            showChar(game->board[MAX_ROUND - i-1][j]);
             printf(" ");
         }
         printf("│");
         printf(" ");
-        showChar(game.result[MAX_ROUND - i-1][1]);
+        showChar(game->result[MAX_ROUND - i-1][1]);
         printf(" ");
         printf("│\n");
         if (i < MAX_ROUND-1) {
@@ -51,19 +51,48 @@ void showGame(game_t game) {
         }
     }
     printf("                            └───┴─────────────┴───┘\n");
-    printf("                                  Round: %d\n\n", game.nbRound);
-    for (int i = 0, j = 0; i < game.nbPlayers; i++) {
-        if (game.playerIndex != i) {
+    printf("                                  Round: %d\n\n", game->nbRound);
+    for (int i = 0, j = 0; i < game->nbPlayers; i++) {
+        if (game->playerIndex != i) {
             printf("Player %d\n", i+1);
-            printf("\tRound: %d\n", game.otherPlayers[j].nbRound);
-            printf(ANSI_COLOR_GREEN"\tRight color, Right place: %d\n"ANSI_RESET_ALL, game.otherPlayers[j].nbGoodPlace);
-            printf(ANSI_COLOR_YELLOW"\tRight color, Wrong place: %d\n\n"ANSI_RESET_ALL, game.otherPlayers[j].nbGoodColor);
+            printf("\tRound: %d\n", game->otherPlayers[j].nbRound);
+            printf(ANSI_COLOR_GREEN"\tRight color, Right place: %d\n"ANSI_RESET_ALL, game->otherPlayers[j].nbGoodPlace);
+            printf(ANSI_COLOR_YELLOW"\tRight color, Wrong place: %d\n\n"ANSI_RESET_ALL, game->otherPlayers[j].nbGoodColor);
             printf("\n");
             j++;
         }
     }
 }
 
+/**
+ *	\fn			void showRaceResult(const clientRaceMessage_t *result)
+ *	\brief		Displays the scores of race guesses.
+ *	\param 		result : The guesses and their scores.
+ *	\details	Each scored guess is printed on its own line with its score.
+ */
+void showRaceResult(const clientRaceMessage_t *result) {
+    char combination[BOARD_WIDTH];
+    for (int i = 0; i < result->nbScores; i++) {
+        codeUnpack(result->guesses[i], combination);
+        for (int j = 0; j < BOARD_WIDTH; j++) {
+            showChar(combination[j]);
+            printf(" ");
+        }
+        printf(ANSI_COLOR_GREEN" Right place: %d"ANSI_RESET_ALL, SCORE_GOOD_PLACE(result->scores[i]));
+        printf(ANSI_COLOR_YELLOW"  Wrong place: %d\n"ANSI_RESET_ALL, SCORE_GOOD_COLOR(result->scores[i]));
+    }
+}
+
+/**
+ *	\fn			void showPrompt()
+ *	\brief		Displays the prompt of the combination.
+ *	\details	The prompt is flushed, the line editor reads the combination after it.
+ */
+void showPrompt() {
+    printf("Player, enter your guess, possible colors are R, G, B, C, Y, and M > ");
+    fflush(stdout);
+}
+
 /**
  *	\fn			void showChar(char c)
  *	\brief		Displays a character with the appropriate format.
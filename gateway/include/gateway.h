@@ -0,0 +1,131 @@
+/**
+ *	\file		gateway.c
+ *	\brief		Distributes the clients over several servers.
+ *
+ *	\details	This file contains the gateway. The gateway listens on the key the clients connect to and hands each client to one of the backend servers, each listenning on its own key. The gateway makes the connection handshake with the backend on behalf of the client and answers the client with the backend's PID and queue, so the client then plays with the backend directly and the game messages never go through the gateway.
+ *				The clients are routed by sessions: consecutive clients go to the same backend until it has a whole session, then the next session goes to the backend with the fewest clients. The load of a backend is the number of queues of its clients still existing, a backend removing the queue of a client once its game is over. A backend multiplexing its players moves them to the shared queue of their session when it starts, so they only count while they wait in its lobby. The backends are watched, so the sessions go to the backends started after the gateway and stop going to the backends which stopped.
+ */
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define GATEWAY_MAX_BACKENDS 16
+#define GATEWAY_MAX_ROUTED 4096 // The clients of a backend whose queues are watched, the others are routed without being counted
+#define GATEWAY_SCAN_MS 200 // The period of the watch of the backends
+#define GATEWAY_CONNECT_TIMEOUT_MS 1000 // The time a backend has to answer a connection before it is considered down
+#define GATEWAY_RETRY_S 5 // The time before a backend that stopped answering is tried again while its queues are left
+
+/**
+ *	\struct		gatewayBackend
+ *	\brief		Represents a backend server.
+ */
+struct gatewayBackend
+{
+    key_t key; /**<The listenning key of the backend.*/
+    int pid; /**<The PID of the backend once a client was routed to it, 0 otherwise.*/
+    int up; /**<1 while the sessions can be routed to the backend.*/
+    time_t retryAt; /**<The time the backend is tried again if it stopped answering.*/
+    int msgids[GATEWAY_MAX_ROUTED]; /**<The queues of the clients routed to the backend which still exist.*/
+    int nbClients; /**<The number of queues watched.*/
+    long nbRouted; /**<The number of clients routed to the backend.*/
+};
+typedef struct gatewayBackend gatewayBackend_t;
+
+/**
+ *	\struct		gateway
+ *	\brief		Represents the state of the gateway.
+ */
+struct gateway
+{
+    gatewayBackend_t backends[GATEWAY_MAX_BACKENDS]; /**<The backends.*/
+    int nbBackends; /**<The number of backends.*/
+    key_t key; /**<The key the clients connect to.*/
+    int listenners[MAX_LISTENNING_QUEUES]; /**<The listenning queues.*/
+    int nbListenners; /**<The number of listenning queues, each with its thread.*/
+    int sessionSize; /**<The number of consecutive clients routed to the same backend.*/
+    int current; /**<The backend of the session being formed, EMPTY if none.*/
+    int nbSeated; /**<The number of clients routed to the session being formed.*/
+    long nbRefused; /**<The number of clients refused, no backend being up.*/
+    pthread_mutex_t mutex; /**<Protects the backends and the session being formed.*/
+};
+typedef struct gateway gateway_t;
+
+/**
+ *	\fn			void gatewayStartListenning()
+ *	\brief		Creates the listenning queues and their threads.
+ *	\details	The queues left by a previous process on the key beyond the configured number are removed, the clients would count them.
+ */
+void gatewayStartListenning();
+
+/**
+ *	\fn			void gatewayScan()
+ *	\brief		Watches the backends.
+ *	\details	A backend is up while its listenning queue exists and its process is alive. A backend whose process is gone but whose queues are left is tried again after GATEWAY_RETRY_S, it may have been restarted on them. The queues of the clients removed by their backend stop counting in its load, and a backend going down loses its clients.
+ */
+void gatewayScan();
+
+/**
+ *	\fn			void *_gatewayListenningThreadHandler(void *args)
+ *	\brief		Handles a listenning thread.
+ *	\param 		args : The index of the listenning queue of the thread.
+ *	\details	The thread receives the connection requests on its queue and connects each client to a backend. A backend that does not answer is marked down and the client is routed to another one. A client is refused if no backend is up.
+ */
+void *_gatewayListenningThreadHandler(void *args);
+
+/**
+ *	\fn			int _gatewayRoute()
+ *	\brief		Chooses the backend of a client.
+ *	\details	The client joins the session being formed if its backend is up and the session is not full. Otherwise a new session is formed on the backend with the fewest clients. Returns the index of the backend, or EMPTY if no backend is up.
+ */
+int _gatewayRoute();
+
+/**
+ *	\fn			void _gatewayRecord(int backendIndex, int clientMsgid, int backendPID)
+ *	\brief		Records the connection of a client to a backend.
+ *	\param 		backendIndex : The index of the backend.
+ *	\param 		clientMsgid : The queue of the client, -1 if the backend did not answer.
+ *	\param 		backendPID : The PID of the backend.
+ *	\details	The queue of the client is watched, the shared queue if the backend handed out a lane. A backend that did not answer is marked down until GATEWAY_RETRY_S has passed.
+ */
+void _gatewayRecord(int backendIndex, int clientMsgid, int backendPID);
+
+/**
+ *	\fn			void _gatewayDown(gatewayBackend_t *backend)
+ *	\brief		Marks a backend down.
+ *	\param 		backend : The backend.
+ *	\details	Its clients are forgotten and the session being formed on it is closed. Must be called with the mutex of the gateway held.
+ */
+void _gatewayDown(gatewayBackend_t *backend);
+
+/**
+ *	\fn			void signalHandlerStop(int signum)
+ *	\brief		Stops the gateway.
+ *	\param 		signum : The signal number.
+ *	\details	The clients already routed go on playing with their backends.
+ */
+void signalHandlerStop(int signum);
+
+/**
+ *	\fn			void cleanup()
+ *	\brief		Removes the listenning queues.
+ *	\details	The number of clients routed to each backend is displayed.
+ */
+void cleanup();
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the gateway usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name);
+
+#endif
@@ -0,0 +1,304 @@
+/**
+ *	\file		gateway.c
+ *	\brief		Distributes the clients over several servers.
+ *
+ *	\details	This file contains the gateway. The gateway listens on the key the clients connect to and hands each client to one of the backend servers, each listenning on its own key. The gateway makes the connection handshake with the backend on behalf of the client and answers the client with the backend's PID and queue, so the client then plays with the backend directly and the game messages never go through the gateway.
+ *				The clients are routed by sessions: consecutive clients go to the same backend until it has a whole session, then the next session goes to the backend with the fewest clients. The load of a backend is the number of queues of its clients still existing, a backend removing the queue of a client once its game is over. A backend multiplexing its players moves them to the shared queue of their session when it starts, so they only count while they wait in its lobby. The backends are watched, so the sessions go to the backends started after the gateway and stop going to the backends which stopped.
+ */
+#include "gateway.h"
+
+int serverPID = 0;
+gateway_t gateway = {
+    .nbBackends = 0,
+    .key = SERVER_LISTENNING_KEY,
+    .nbListenners = LISTENNING_QUEUES,
+    .sessionSize = MAX_PLAYERS,
+    .current = EMPTY,
+    .nbSeated = 0,
+    .nbRefused = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the gateway.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-b adds the listenning key of a backend, once per backend. -K sets the key the clients connect to, -q the number of listenning queues and -s the number of clients routed to the same backend, which should be the target size of the backends. The backends are then watched until the gateway is stopped.
+ */
+int main(int argc, char *argv[]) {
+    struct timespec scanPeriod = {GATEWAY_SCAN_MS / 1000, (GATEWAY_SCAN_MS % 1000) * 1000000L};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:K:q:s:")) != -1) {
+        switch (opt) {
+            case 'b':
+                if (gateway.nbBackends == GATEWAY_MAX_BACKENDS) {
+                    _usage(argv[0]);
+                }
+                gateway.backends[gateway.nbBackends++].key = atoi(optarg);
+                break;
+            case 'K':
+                gateway.key = atoi(optarg);
+                break;
+            case 'q':
+                gateway.nbListenners = atoi(optarg);
+                break;
+            case 's':
+                gateway.sessionSize = atoi(optarg);
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (gateway.nbBackends == 0 || gateway.key <= 0
+        || gateway.nbListenners < 1 || gateway.nbListenners > MAX_LISTENNING_QUEUES
+        || gateway.sessionSize < 1 || gateway.sessionSize > MAX_PLAYERS) {
+        _usage(argv[0]);
+    }
+    for (int i = 0; i < gateway.nbBackends; i++) {
+        if (gateway.backends[i].key <= 0 || gateway.backends[i].key == gateway.key) {
+            _usage(argv[0]);
+        }
+    }
+
+    serverPID = getpid();
+    traceInit("gateway");
+    signal(SIGINT, signalHandlerStop);
+    signal(SIGTERM, signalHandlerStop);
+    // The clients routed to a backend signal the backend, never the gateway
+    signal(SIGUSR1, SIG_IGN);
+    atexit(cleanup);
+    gatewayScan();
+    gatewayStartListenning();
+    while (1) {
+        nanosleep(&scanPeriod, NULL);
+        gatewayScan();
+    }
+    return 0;
+}
+
+/**
+ *	\fn			void gatewayStartListenning()
+ *	\brief		Creates the listenning queues and their threads.
+ *	\details	The queues left by a previous process on the key beyond the configured number are removed, the clients would count them.
+ */
+void gatewayStartListenning() {
+    pthread_t threadListenning;
+    int msgid;
+    for (int i = gateway.nbListenners; i < MAX_LISTENNING_QUEUES; i++) {
+        if ((msgid = msgget(LISTENNING_QUEUE_KEY(gateway.key, i), 0666)) != -1) {
+            msgctl(msgid, IPC_RMID, NULL);
+        }
+    }
+    for (int i = 0; i < gateway.nbListenners; i++) {
+        CHECK(gateway.listenners[i] = msgget(LISTENNING_QUEUE_KEY(gateway.key, i), 0666 | IPC_CREAT), "Error: could not create the listenning queue");
+    }
+    printf("Gateway listenning with key %d on %d queues for %d backends\n", gateway.key, gateway.nbListenners, gateway.nbBackends);
+    for (intptr_t i = 0; i < gateway.nbListenners; i++) {
+        pthread_create(&threadListenning,
+                        NULL,
+                        _gatewayListenningThreadHandler,
+                        (void *) i);
+        pthread_detach(threadListenning);
+    }
+}
+
+/**
+ *	\fn			void gatewayScan()
+ *	\brief		Watches the backends.
+ *	\details	A backend is up while its listenning queue exists and its process is alive. A backend whose process is gone but whose queues are left is tried again after GATEWAY_RETRY_S, it may have been restarted on them. The queues of the clients removed by their backend stop counting in its load, and a backend going down loses its clients.
+ */
+void gatewayScan() {
+    gatewayBackend_t *backend;
+    struct msqid_ds stat;
+    time_t now = time(NULL);
+    int exists;
+    int up;
+
+    pthread_mutex_lock(&gateway.mutex);
+    for (int i = 0; i < gateway.nbBackends; i++) {
+        backend = &gateway.backends[i];
+        exists = msgget(backend->key, 0666) != -1;
+        if (!exists) {
+            backend->pid = 0;
+        }
+        up = exists && (backend->pid == 0 || kill(backend->pid, 0) == 0 || errno == EPERM);
+        if (exists && !up) {
+            if (backend->up) {
+                backend->retryAt = now + GATEWAY_RETRY_S;
+            } else if (now >= backend->retryAt) {
+                // A killed backend leaves its queues, a backend restarted on them has another PID
+                backend->pid = 0;
+                up = 1;
+            }
+        }
+        if (up && !backend->up && now >= backend->retryAt) {
+            printf("Backend %d (key %d) up.\n", i, backend->key);
+            backend->up = 1;
+        } else if (!up && backend->up) {
+            printf("Backend %d (key %d) down, %d clients lost.\n", i, backend->key, backend->nbClients);
+            _gatewayDown(backend);
+        }
+        for (int j = 0; j < backend->nbClients; j++) {
+            if (msgctl(backend->msgids[j], IPC_STAT, &stat) == -1) {
+                backend->msgids[j--] = backend->msgids[--backend->nbClients];
+            }
+        }
+    }
+    pthread_mutex_unlock(&gateway.mutex);
+    fflush(stdout);
+}
+
+/**
+ *	\fn			void *_gatewayListenningThreadHandler(void *args)
+ *	\brief		Handles a listenning thread.
+ *	\param 		args : The index of the listenning queue of the thread.
+ *	\details	The thread receives the connection requests on its queue and connects each client to a backend. A backend that does not answer is marked down and the client is routed to another one. A client is refused if no backend is up.
+ */
+void *_gatewayListenningThreadHandler(void *args) {
+    int msgid = gateway.listenners[(intptr_t) args];
+    mbuf_t request;
+    int clientPID;
+    int clientMsgid;
+    int backendPID;
+    int backendIndex;
+
+    while (1) {
+        if (receiveConnection(msgid, &request, &clientPID, 0) != 1) {
+            // The queue is removed when the gateway stops
+            if (errno == EIDRM || errno == EINVAL) {
+                break;
+            }
+            continue;
+        }
+        clientMsgid = -1;
+        backendPID = 0;
+        for (int attempt = 0; attempt < gateway.nbBackends && clientMsgid == -1; attempt++) {
+            if ((backendIndex = _gatewayRoute()) == EMPTY) {
+                break;
+            }
+            // The backend registers the client itself, so it signals the client directly
+            clientMsgid = requestConnection(gateway.backends[backendIndex].key, clientPID, &backendPID, GATEWAY_CONNECT_TIMEOUT_MS);
+            _gatewayRecord(backendIndex, clientMsgid, backendPID);
+        }
+        if (clientMsgid == -1) {
+            __atomic_add_fetch(&gateway.nbRefused, 1, __ATOMIC_RELAXED);
+        }
+        answerConnection(msgid, &request, backendPID, clientMsgid);
+        // The gateway only relays the lane, the client plays on it with the backend
+        transportCloseLane(clientMsgid);
+    }
+    return NULL;
+}
+
+/**
+ *	\fn			int _gatewayRoute()
+ *	\brief		Chooses the backend of a client.
+ *	\details	The client joins the session being formed if its backend is up and the session is not full. Otherwise a new session is formed on the backend with the fewest clients. Returns the index of the backend, or EMPTY if no backend is up.
+ */
+int _gatewayRoute() {
+    int backendIndex;
+    pthread_mutex_lock(&gateway.mutex);
+    if (gateway.current == EMPTY || gateway.nbSeated == gateway.sessionSize) {
+        gateway.current = EMPTY;
+        gateway.nbSeated = 0;
+        for (int i = 0; i < gateway.nbBackends; i++) {
+            if (gateway.backends[i].up
+                && (gateway.current == EMPTY || gateway.backends[i].nbClients < gateway.backends[gateway.current].nbClients)) {
+                gateway.current = i;
+            }
+        }
+    }
+    if ((backendIndex = gateway.current) != EMPTY) {
+        gateway.nbSeated++;
+    }
+    pthread_mutex_unlock(&gateway.mutex);
+    return backendIndex;
+}
+
+/**
+ *	\fn			void _gatewayRecord(int backendIndex, int clientMsgid, int backendPID)
+ *	\brief		Records the connection of a client to a backend.
+ *	\param 		backendIndex : The index of the backend.
+ *	\param 		clientMsgid : The queue of the client, -1 if the backend did not answer.
+ *	\param 		backendPID : The PID of the backend.
+ *	\details	The queue of the client is watched, the shared queue if the backend handed out a lane. A backend that did not answer is marked down until GATEWAY_RETRY_S has passed.
+ */
+void _gatewayRecord(int backendIndex, int clientMsgid, int backendPID) {
+    gatewayBackend_t *backend = &gateway.backends[backendIndex];
+    int msgid;
+    transportLaneOf(clientMsgid, &msgid);
+    pthread_mutex_lock(&gateway.mutex);
+    if (clientMsgid == -1) {
+        if (backend->up) {
+            printf("Backend %d (key %d) does not answer, %d clients lost.\n", backendIndex, backend->key, backend->nbClients);
+            backend->retryAt = time(NULL) + GATEWAY_RETRY_S;
+            _gatewayDown(backend);
+        }
+    } else {
+        backend->pid = backendPID;
+        backend->nbRouted++;
+        if (backend->nbClients < GATEWAY_MAX_ROUTED) {
+            backend->msgids[backend->nbClients++] = msgid;
+        }
+    }
+    pthread_mutex_unlock(&gateway.mutex);
+}
+
+/**
+ *	\fn			void _gatewayDown(gatewayBackend_t *backend)
+ *	\brief		Marks a backend down.
+ *	\param 		backend : The backend.
+ *	\details	Its clients are forgotten and the session being formed on it is closed. Must be called with the mutex of the gateway held.
+ */
+void _gatewayDown(gatewayBackend_t *backend) {
+    backend->up = 0;
+    backend->nbClients = 0;
+    if (gateway.current != EMPTY && &gateway.backends[gateway.current] == backend) {
+        gateway.current = EMPTY;
+    }
+}
+
+/**
+ *	\fn			void signalHandlerStop(int signum)
+ *	\brief		Stops the gateway.
+ *	\param 		signum : The signal number.
+ *	\details	The clients already routed go on playing with their backends.
+ */
+void signalHandlerStop(int signum) {
+    printf("Caught signal %d\n", signum);
+    exit(signum);
+}
+
+/**
+ *	\fn			void cleanup()
+ *	\brief		Removes the listenning queues.
+ *	\details	The number of clients routed to each backend is displayed.
+ */
+void cleanup() {
+    printf("backend    key  up  clients  routed\n");
+    for (int i = 0; i < gateway.nbBackends; i++) {
+        printf("%7d  %5d  %2d  %7d  %6ld\n", i, gateway.backends[i].key, gateway.backends[i].up,
+               gateway.backends[i].nbClients, gateway.backends[i].nbRouted);
+    }
+    printf("%ld clients refused\n", gateway.nbRefused);
+    for (int i = 0; i < gateway.nbListenners; i++) {
+        msgctl(gateway.listenners[i], IPC_RMID, NULL);
+    }
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the gateway usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s -b backend key [-b backend key]... [-K listenning key] [-q listenning queues] [-s session size]\n", name);
+    fprintf(stderr, "  -b  listenning key of a backend server, started with -K (1-%d backends)\n", GATEWAY_MAX_BACKENDS);
+    fprintf(stderr, "  -K  key the clients connect to (default %d)\n", SERVER_LISTENNING_KEY);
+    fprintf(stderr, "  -q  number of listenning queues (1-%d, default %d)\n", MAX_LISTENNING_QUEUES, LISTENNING_QUEUES);
+    fprintf(stderr, "  -s  number of consecutive clients routed to the same backend (1-%d, default %d)\n", MAX_PLAYERS, MAX_PLAYERS);
+    exit(-1);
+}
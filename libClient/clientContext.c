@@ -0,0 +1,473 @@
+/**
+ *	\file		clientContext.c
+ *	\brief		Implements the client side of the game protocol.
+ *
+ *	\details	This file contains the reentrant client library. All the state of a client is kept in its context, so one process can run as many clients as it needs, on as many threads as it wants, as long as a context is used by one thread at a time.
+ *				The library never blocks once connected and never writes to the terminal. The caller steps the context and reacts to the events it returns.
+ */
+#include "clientContext.h"
+
+/**
+ *	\fn			void clientConnect(clientContext_t *context, key_t serverKey, int pid)
+ *	\brief		Connects a client to the server.
+ *	\param 		context : The client context.
+ *	\param 		serverKey : The key of the server listenning queue.
+ *	\param 		pid : The PID the server signals when it stops the game, 0 for a virtual client.
+ *	\details	The context is connected and attached to the queue handed out by the server. This is the only call waiting for the server, for the time of the connection handshake.
+ */
+void clientConnect(clientContext_t *context, key_t serverKey, int pid) {
+    int serverPID;
+    int msgid = connectToServer(serverKey, pid, &serverPID);
+    clientAttach(context, msgid, serverPID);
+}
+
+/**
+ *	\fn			void clientAttach(clientContext_t *context, int msgid, int serverPID)
+ *	\brief		Attaches a client to a queue shared with the server.
+ *	\param 		context : The client context.
+ *	\param 		msgid : The queue shared with the server, on the transport of the thread.
+ *	\param 		serverPID : The PID of the server, or the identity the server side assumes.
+ *	\details	The context is initialized without any handshake, the queue is already known to the server. clientConnect attaches the queue handed out by the server, a simulation attaches the loopback queues it created.
+ */
+void clientAttach(clientContext_t *context, int msgid, int serverPID) {
+    initGame(&context->game);
+    context->state = CLIENT_LOBBY;
+    context->lobbyStep = 0;
+    context->nbResults = 0;
+    context->winner = EMPTY;
+    context->secretCode[0] = '\0';
+    context->race = 0;
+    context->lockstep = 0;
+    context->raceHead = 0;
+    context->raceCount = 0;
+    context->serverPID = serverPID;
+    context->game.msgid = msgid;
+}
+
+/**
+ *	\fn			int clientReady(clientContext_t *context)
+ *	\brief		Tells the server the client is ready.
+ *	\param 		context : The client context.
+ *	\details	The client joins the matchmaking. Returns 0 on success and -1 if the server is lost.
+ */
+int clientReady(clientContext_t *context) {
+    if (postData(context->game.msgid, "ready") == -1) {
+        _clientLost(context);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *	\fn			int clientStep(clientContext_t *context)
+ *	\brief		Handles the messages of the server.
+ *	\param 		context : The client context.
+ *	\details	The messages already received are handled without waiting, until one of them raises an event. Returns the event, CLIENT_EVENT_NONE if there is no message left.
+ */
+int clientStep(clientContext_t *context) {
+    mbuf_t message;
+    int event;
+    int status;
+    while (context->state != CLIENT_OVER && context->state != CLIENT_LOST) {
+        if ((status = pollMessage(context->game.msgid, &message, DATA_TYPE)) == -1) {
+            return _clientLost(context);
+        }
+        if (status == 1) {
+            // The server acks a message before answering it, so the ack is checked after the data: data found without its ack ends the game
+            if (_clientPollAck(context) == -1) {
+                return _clientLost(context);
+            }
+            if ((event = _clientHandleData(context, &message)) != CLIENT_EVENT_NONE) {
+                return event;
+            }
+            continue;
+        }
+        if ((status = _clientPollAck(context)) == -1) {
+            return _clientLost(context);
+        }
+        if (status == 0) {
+            break;
+        }
+    }
+    return CLIENT_EVENT_NONE;
+}
+
+/**
+ *	\fn			int clientSendCombination(clientContext_t *context, const char *combination)
+ *	\brief		Sends the combination of the round.
+ *	\param 		context : The client context.
+ *	\param 		combination : The combination, 4 upper case colors.
+ *	\details	Must be called in the CLIENT_TYPING state. Returns 0 on success and -1 if the combination is not valid or the server is lost.
+ */
+int clientSendCombination(clientContext_t *context, const char *combination) {
+    char data[BOARD_WIDTH + 1] = {0};
+    code_t code;
+    if (context->state != CLIENT_TYPING || strlen(combination) != BOARD_WIDTH || codePack(combination, &code) == -1) {
+        return -1;
+    }
+    memcpy(data, combination, BOARD_WIDTH);
+    memcpy(context->game.board[context->game.nbRound], combination, BOARD_WIDTH);
+    if (postData(context->game.msgid, data) == -1) {
+        _clientLost(context);
+        return -1;
+    }
+    context->state = CLIENT_WAITING_ACK;
+    return 0;
+}
+
+/**
+ *	\fn			int clientRaceSend(clientContext_t *context, const code_t *guesses, int nbGuesses)
+ *	\brief		Streams guesses in a race game.
+ *	\param 		context : The client context.
+ *	\param 		guesses : The guesses.
+ *	\param 		nbGuesses : The number of guesses, RACE_GUESSES_PER_MESSAGE at most.
+ *	\details	Must be called in the CLIENT_RACING state. The guesses are sent in one message without waiting for their scores, which come with CLIENT_EVENT_RACE. Returns 0 on success and -1 if the window of messages in flight is full, the guesses are not valid or the server is lost.
+ */
+int clientRaceSend(clientContext_t *context, const code_t *guesses, int nbGuesses) {
+    clientRaceMessage_t *message;
+    char data[MSG_SIZE];
+    if (context->state != CLIENT_RACING || context->raceCount == CLIENT_RACE_WINDOW
+        || nbGuesses < 1 || nbGuesses > RACE_GUESSES_PER_MESSAGE) {
+        return -1;
+    }
+    message = &context->raceWindow[(context->raceHead + context->raceCount) % CLIENT_RACE_WINDOW];
+    for (int i = 0; i < nbGuesses; i++) {
+        if (guesses[i] >= NB_CODES) {
+            return -1;
+        }
+        codeUnpack(guesses[i], data + i * BOARD_WIDTH);
+        message->guesses[i] = guesses[i];
+    }
+    data[nbGuesses * BOARD_WIDTH] = '\0';
+    message->nbGuesses = nbGuesses;
+    if (streamData(context->game.msgid, data) == -1) {
+        _clientLost(context);
+        return -1;
+    }
+    context->raceCount++;
+    return 0;
+}
+
+/**
+ *	\fn			void clientClose(clientContext_t *context)
+ *	\brief		Closes the connection.
+ *	\param 		context : The client context.
+ *	\details	Once the game is over the queue belongs to the server, which removes it, and a lane of a shared queue is only forgotten. Otherwise the client removes it itself, through the transport of the thread. The context is left without a queue.
+ */
+void clientClose(clientContext_t *context) {
+    if (context->state != CLIENT_OVER) {
+        transport->remove(context->game.msgid);
+    } else {
+        transportCloseLane(context->game.msgid);
+    }
+    context->game.msgid = -1;
+}
+
+/**
+ *	\fn			int clientBookCombination(const clientContext_t *context, const book_t *book, char *combination)
+ *	\brief		Finds the combination the opening book plays next.
+ *	\param 		context : The client context.
+ *	\param 		book : The opening book.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The book is walked down the combinations and the results of the rounds played. Returns 0 on success and -1 if the game has left the book.
+ */
+int clientBookCombination(const clientContext_t *context, const book_t *book, char *combination) {
+    const game_t *game = &context->game;
+    code_t guesses[MAX_ROUND];
+    score_t scores[MAX_ROUND];
+    code_t guess;
+    for (int i = 0; i < game->nbRound; i++) {
+        if (codePack(game->board[i], &guesses[i]) == -1) {
+            return -1;
+        }
+        scores[i] = SCORE(game->result[i][0], game->result[i][1]);
+    }
+    if (bookLookup(book, guesses, scores, game->nbRound, &guess) == -1) {
+        return -1;
+    }
+    codeUnpack(guess, combination);
+    combination[BOARD_WIDTH] = '\0';
+    return 0;
+}
+
+/**
+ *	\fn			int clientSolverCombination(const clientContext_t *context, solver_t *solver, code_t origin, char *combination)
+ *	\brief		Finds the minimax combination of the next round.
+ *	\param 		context : The client context.
+ *	\param 		solver : The solver, shared by the clients of the process.
+ *	\param 		origin : The code the ties between the best combinations are broken from, so the clients of a game do not all play the same ones.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The combination minimizes the worst case over the codes consistent with the results of the rounds played. Returns 0 on success and -1 if no code is consistent with the results.
+ */
+int clientSolverCombination(const clientContext_t *context, solver_t *solver, code_t origin, char *combination) {
+    const game_t *game = &context->game;
+    code_t guesses[MAX_ROUND];
+    score_t scores[MAX_ROUND];
+    code_t candidates[NB_CODES];
+    int nbCandidates;
+    for (int i = 0; i < game->nbRound; i++) {
+        if (codePack(game->board[i], &guesses[i]) == -1) {
+            return -1;
+        }
+        scores[i] = SCORE(game->result[i][0], game->result[i][1]);
+    }
+    if ((nbCandidates = solverCandidates(guesses, scores, game->nbRound, candidates)) == 0) {
+        return -1;
+    }
+    codeUnpack(solverBestGuess(solver, candidates, nbCandidates, origin, NULL), combination);
+    combination[BOARD_WIDTH] = '\0';
+    return 0;
+}
+
+/**
+ *	\fn			int _clientPollAck(clientContext_t *context)
+ *	\brief		Handles the ack of the last message sent, if the client waits for one.
+ *	\param 		context : The client context.
+ *	\details	Returns 1 if the ack was handled, 0 if the client does not wait for an ack or the ack has not come yet, and -1 if the server is lost.
+ */
+int _clientPollAck(clientContext_t *context) {
+    mbuf_t ack;
+    int expectedCode;
+    int status;
+    if (context->state == CLIENT_LOBBY && context->lobbyStep == 0) {
+        expectedCode = 1;
+    } else if (context->state == CLIENT_WAITING_ACK) {
+        expectedCode = 3;
+    } else {
+        return 0;
+    }
+    if ((status = pollMessage(context->game.msgid, &ack, ACK_TYPE)) != 1) {
+        return status;
+    }
+    if (checkAcknowledgement(&ack, expectedCode) == -1) {
+        return -1;
+    }
+    traceInstant("ackReceived", context->game.msgid, expectedCode, NULL);
+    if (context->state == CLIENT_LOBBY) {
+        context->lobbyStep = 1;
+    } else {
+        context->state = CLIENT_WAITING_RESULT;
+    }
+    return 1;
+}
+
+/**
+ *	\fn			int _clientHandleData(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles a data message of the server.
+ *	\param 		context : The client context.
+ *	\param 		message : The message.
+ *	\details	The meaning of the message depends on the state of the client. The message is acknowledged with the code the server expects. Returns the event raised by the message.
+ */
+int _clientHandleData(clientContext_t *context, mbuf_t *message) {
+    game_t *game = &context->game;
+    int code;
+    int event = CLIENT_EVENT_NONE;
+
+    switch (context->state) {
+        case CLIENT_LOBBY:
+            if (context->lobbyStep < 2) {
+                game->nbPlayers = message->mtext[0];
+                context->race = message->mtext[1] == 'r';
+                context->lockstep = message->mtext[1] == 'l';
+                // A multiplexed player moves to a lane of the queue of its session before getting its index
+                context->lobbyStep = message->mtext[1] != '\0' && message->mtext[2] == LOBBY_MOVE ? 3 : 2;
+                code = 2;
+            } else if (context->lobbyStep == 3) {
+                return _clientMove(context, message);
+            } else {
+                game->playerIndex = message->mtext[0];
+                traceTagQueue(game->msgid, TRACE_NO_TAG, game->playerIndex);
+                context->state = context->race ? CLIENT_RACING : CLIENT_TYPING;
+                code = 8;
+                event = CLIENT_EVENT_STARTED;
+            }
+            break;
+        case CLIENT_WAITING_RESULT:
+            if (context->lockstep) {
+                // The summary holds all the results of the round
+                _clientHandleSummary(context, message);
+                context->nbResults = game->nbPlayers - 1;
+                code = 9;
+            } else if (context->nbResults == 0) {
+                for (int i = 0; i < RESULT_WIDTH; i++) {
+                    game->result[game->nbRound][i] = message->mtext[i] - '0';
+                }
+                code = 4;
+            } else {
+                if (_clientHandleDelta(&game->otherPlayers[context->nbResults - 1], message) == -1) {
+                    return _clientLost(context);
+                }
+                code = 5;
+            }
+            if (++context->nbResults == game->nbPlayers) {
+                context->nbResults = 0;
+                game->nbRound++;
+                context->state = _clientRoundEndsGame(context) ? CLIENT_FINISHED : CLIENT_TYPING;
+                event = CLIENT_EVENT_ROUND;
+            }
+            break;
+        case CLIENT_ENDING:
+            strncpy(context->secretCode, message->mtext, MSG_SIZE - 1);
+            context->secretCode[MSG_SIZE - 1] = '\0';
+            context->state = CLIENT_OVER;
+            code = 7;
+            event = CLIENT_EVENT_OVER;
+            break;
+        case CLIENT_RACING:
+            if (message->ackType == MTYPE_NO_ACK) {
+                return _clientHandleRace(context, message);
+            }
+            // Otherwise the race is over
+            // fall through
+        default:
+            // Typing, racing, waiting for the ack of the combination or finished: the server ends the game
+            if (strcmp(message->mtext, "win") == 0) {
+                context->winner = game->playerIndex;
+            } else if (sscanf(message->mtext, "loose:%d", &context->winner) != 1) {
+                context->winner = EMPTY;
+            }
+            context->state = CLIENT_ENDING;
+            code = 6;
+            break;
+    }
+    if (acknowledgeData(game->msgid, message, code) == -1) {
+        return _clientLost(context);
+    }
+    return event;
+}
+
+/**
+ *	\fn			int _clientMove(clientContext_t *context, mbuf_t *message)
+ *	\brief		Moves the client to a lane of the queue of its session.
+ *	\param 		context : The client context.
+ *	\param 		message : The shared queue and the index of the lane, separated by a colon.
+ *	\details	The move is acknowledged on the queue of the client, which the server removes once it has the ack, and the client plays on the lane from then on. Returns CLIENT_EVENT_NONE, or CLIENT_EVENT_LOST if the lane cannot be opened or the server is lost.
+ */
+int _clientMove(clientContext_t *context, mbuf_t *message) {
+    int msgid;
+    int lane;
+    int id;
+    if (sscanf(message->mtext, "%d:%d", &msgid, &lane) != 2 || (id = transportOpenLane(msgid, lane)) == -1) {
+        return _clientLost(context);
+    }
+    if (acknowledgeData(context->game.msgid, message, 10) == -1) {
+        transportCloseLane(id);
+        return _clientLost(context);
+    }
+    context->game.msgid = id;
+    context->lobbyStep = 2;
+    return CLIENT_EVENT_NONE;
+}
+
+/**
+ *	\fn			int _clientHandleRace(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles the scores of a race message.
+ *	\param 		context : The client context.
+ *	\param 		message : The scores, two digits per guess.
+ *	\details	The scores answer the oldest message in flight. They are not acknowledged. Returns CLIENT_EVENT_RACE.
+ */
+int _clientHandleRace(clientContext_t *context, mbuf_t *message) {
+    clientRaceMessage_t *result = &context->raceResult;
+    if (context->raceCount == 0) {
+        return _clientLost(context);
+    }
+    *result = context->raceWindow[context->raceHead];
+    context->raceHead = (context->raceHead + 1) % CLIENT_RACE_WINDOW;
+    context->raceCount--;
+    result->nbScores = MIN((int) strlen(message->mtext) / 2, result->nbGuesses);
+    for (int i = 0; i < result->nbScores; i++) {
+        result->scores[i] = SCORE(message->mtext[2 * i] - '0', message->mtext[2 * i + 1] - '0');
+    }
+    return CLIENT_EVENT_RACE;
+}
+
+/**
+ *	\fn			int _clientHandleDelta(otherPlayer_t *otherPlayer, mbuf_t *message)
+ *	\brief		Handles a delta of the history of another player.
+ *	\param 		otherPlayer : The other player.
+ *	\param 		message : The delta, the revision it starts from on SYNC_REVISION_WIDTH digits, then the good places and the good colors of each new row.
+ *	\details	The rows are appended to the history if the delta starts from the revision the client has, and the last row becomes the current result of the player. Returns 0, or -1 if the delta does not start from the client's revision.
+ */
+int _clientHandleDelta(otherPlayer_t *otherPlayer, mbuf_t *message) {
+    const char *row = message->mtext + SYNC_REVISION_WIDTH;
+    int length = strlen(message->mtext);
+    int nbRows = (length - SYNC_REVISION_WIDTH) / RESULT_WIDTH;
+    int revision = 0;
+    if (length < SYNC_REVISION_WIDTH) {
+        return -1;
+    }
+    // The revision is not delimited from the rows
+    for (int i = 0; i < SYNC_REVISION_WIDTH; i++) {
+        revision = revision * 10 + message->mtext[i] - '0';
+    }
+    if (revision != otherPlayer->nbRound || otherPlayer->nbRound + nbRows > MAX_ROUND) {
+        return -1;
+    }
+    for (int i = 0; i < nbRows; i++, row += RESULT_WIDTH) {
+        otherPlayer->result[otherPlayer->nbRound][0] = row[0] - '0';
+        otherPlayer->result[otherPlayer->nbRound][1] = row[1] - '0';
+        otherPlayer->nbGoodPlace = row[0] - '0';
+        otherPlayer->nbGoodColor = row[1] - '0';
+        otherPlayer->nbRound++;
+    }
+    return 0;
+}
+
+/**
+ *	\fn			void _clientHandleSummary(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles the summary of a lockstep round.
+ *	\param 		context : The client context.
+ *	\param 		message : The summary, SUMMARY_ROW_WIDTH characters per player in the order of the indexes: the good places, the good colors and 1 if the player played the round.
+ *	\details	The client's own row is its result, the other rows are stored in the order of the other players.
+ */
+void _clientHandleSummary(clientContext_t *context, mbuf_t *message) {
+    game_t *game = &context->game;
+    otherPlayer_t *otherPlayer = game->otherPlayers;
+    const char *row;
+    for (int i = 0; i < game->nbPlayers; i++) {
+        row = message->mtext + i * SUMMARY_ROW_WIDTH;
+        if (i == game->playerIndex) {
+            game->result[game->nbRound][0] = row[0] - '0';
+            game->result[game->nbRound][1] = row[1] - '0';
+            continue;
+        }
+        otherPlayer->nbGoodPlace = row[0] - '0';
+        otherPlayer->nbGoodColor = row[1] - '0';
+        if (row[2] == '1' && otherPlayer->nbRound < MAX_ROUND) {
+            otherPlayer->result[otherPlayer->nbRound][0] = row[0] - '0';
+            otherPlayer->result[otherPlayer->nbRound][1] = row[1] - '0';
+            otherPlayer->nbRound++;
+        }
+        otherPlayer++;
+    }
+}
+
+/**
+ *	\fn			int _clientRoundEndsGame(clientContext_t *context)
+ *	\brief		Checks if the last round ended the game for the client.
+ *	\param 		context : The client context.
+ *	\details	Returns 1 if the client has found the secret combination, has played all the rounds, or if another player has found the secret combination, and 0 otherwise.
+ */
+int _clientRoundEndsGame(clientContext_t *context) {
+    game_t *game = &context->game;
+    if (game->result[game->nbRound - 1][0] == BOARD_WIDTH || game->nbRound == MAX_ROUND) {
+        return 1;
+    }
+    for (int i = 0; i < game->nbPlayers - 1; i++) {
+        if (game->otherPlayers[i].nbGoodPlace == BOARD_WIDTH) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *	\fn			int _clientLost(clientContext_t *context)
+ *	\brief		Marks the connection as lost.
+ *	\param 		context : The client context.
+ *	\details	Returns CLIENT_EVENT_LOST.
+ */
+int _clientLost(clientContext_t *context) {
+    context->state = CLIENT_LOST;
+    return CLIENT_EVENT_LOST;
+}
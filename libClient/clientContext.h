@@ -0,0 +1,225 @@
+/**
+ *	\file		clientContext.c
+ *	\brief		Implements the client side of the game protocol.
+ *
+ *	\details	This file contains the reentrant client library. All the state of a client is kept in its context, so one process can run as many clients as it needs, on as many threads as it wants, as long as a context is used by one thread at a time.
+ *				The library never blocks once connected and never writes to the terminal. The caller steps the context and reacts to the events it returns.
+ */
+#ifndef CLIENTCONTEXT_H
+#define CLIENTCONTEXT_H
+
+#include "utils.h"
+#include "code.h"
+#include "book.h"
+#include "solver.h"
+#include "clientData.h"
+#include "clientInit.h"
+
+#define CLIENT_LOBBY 0 // Ready, the game has not started yet
+#define CLIENT_TYPING 1 // The client must send its combination
+#define CLIENT_WAITING_ACK 2 // The combination is sent, the server has not read it yet
+#define CLIENT_WAITING_RESULT 3 // The server is sending the results of the round
+#define CLIENT_FINISHED 4 // The game is over for the client, the server has not ended it yet
+#define CLIENT_ENDING 5 // The server has ended the game, the secret combination is coming
+#define CLIENT_OVER 6 // The game is over
+#define CLIENT_LOST 7 // The connection with the server is lost
+#define CLIENT_RACING 8 // The client streams its guesses in a race game
+
+#define CLIENT_EVENT_NONE 0 // Nothing happened
+#define CLIENT_EVENT_STARTED 1 // The game has started, the number of players and the client's index are known
+#define CLIENT_EVENT_ROUND 2 // The results of a round are known
+#define CLIENT_EVENT_OVER 3 // The game is over, the winner and the secret combination are known
+#define CLIENT_EVENT_LOST 4 // The connection with the server is lost
+#define CLIENT_EVENT_RACE 5 // The scores of a race message are known
+
+#define CLIENT_RACE_WINDOW 16 // The race messages in flight, bounded so the queue never fills up with the guesses and their scores
+
+/**
+ *	\struct		clientRaceMessage
+ *	\brief		Represents the guesses of a race message.
+ */
+struct clientRaceMessage
+{
+    code_t guesses[RACE_GUESSES_PER_MESSAGE]; /**<The guesses.*/
+    score_t scores[RACE_GUESSES_PER_MESSAGE]; /**<The scores of the guesses, once known.*/
+    int nbGuesses; /**<The number of guesses.*/
+    int nbScores; /**<The number of scores, fewer than the guesses if one of them won the race.*/
+};
+typedef struct clientRaceMessage clientRaceMessage_t;
+
+/**
+ *	\struct		clientContext
+ *	\brief		Represents a client connected to the server.
+ */
+struct clientContext
+{
+    game_t game; /**<The state of the game, game.msgid is the queue shared with the server.*/
+    int state; /**<The state of the client in the protocol.*/
+    int lobbyStep; /**<The number of lobby messages received: the ack of 'ready', the number of players and the index, or 3 while a multiplexed client waits for the lane of its session.*/
+    int nbResults; /**<The number of results received in the current round.*/
+    int serverPID; /**<The PID of the server.*/
+    int winner; /**<The index of the winner, EMPTY if nobody won, once the game is over.*/
+    char secretCode[MSG_SIZE]; /**<The secret combination, once the game is over.*/
+    int race; /**<1 if the game is a race.*/
+    int lockstep; /**<1 if the rounds are simultaneous, the results of a round coming in one summary.*/
+    clientRaceMessage_t raceWindow[CLIENT_RACE_WINDOW]; /**<The race messages in flight, a circular buffer.*/
+    int raceHead; /**<The index of the oldest race message in flight.*/
+    int raceCount; /**<The number of race messages in flight.*/
+    clientRaceMessage_t raceResult; /**<The last race message scored, on CLIENT_EVENT_RACE.*/
+};
+typedef struct clientContext clientContext_t;
+
+/**
+ *	\fn			void clientConnect(clientContext_t *context, key_t serverKey, int pid)
+ *	\brief		Connects a client to the server.
+ *	\param 		context : The client context.
+ *	\param 		serverKey : The key of the server listenning queue.
+ *	\param 		pid : The PID the server signals when it stops the game, 0 for a virtual client.
+ *	\details	The context is connected and attached to the queue handed out by the server. This is the only call waiting for the server, for the time of the connection handshake.
+ */
+void clientConnect(clientContext_t *context, key_t serverKey, int pid);
+
+/**
+ *	\fn			void clientAttach(clientContext_t *context, int msgid, int serverPID)
+ *	\brief		Attaches a client to a queue shared with the server.
+ *	\param 		context : The client context.
+ *	\param 		msgid : The queue shared with the server, on the transport of the thread.
+ *	\param 		serverPID : The PID of the server, or the identity the server side assumes.
+ *	\details	The context is initialized without any handshake, the queue is already known to the server. clientConnect attaches the queue handed out by the server, a simulation attaches the loopback queues it created.
+ */
+void clientAttach(clientContext_t *context, int msgid, int serverPID);
+
+/**
+ *	\fn			int clientReady(clientContext_t *context)
+ *	\brief		Tells the server the client is ready.
+ *	\param 		context : The client context.
+ *	\details	The client joins the matchmaking. Returns 0 on success and -1 if the server is lost.
+ */
+int clientReady(clientContext_t *context);
+
+/**
+ *	\fn			int clientStep(clientContext_t *context)
+ *	\brief		Handles the messages of the server.
+ *	\param 		context : The client context.
+ *	\details	The messages already received are handled without waiting, until one of them raises an event. Returns the event, CLIENT_EVENT_NONE if there is no message left.
+ */
+int clientStep(clientContext_t *context);
+
+/**
+ *	\fn			int clientSendCombination(clientContext_t *context, const char *combination)
+ *	\brief		Sends the combination of the round.
+ *	\param 		context : The client context.
+ *	\param 		combination : The combination, 4 upper case colors.
+ *	\details	Must be called in the CLIENT_TYPING state. Returns 0 on success and -1 if the combination is not valid or the server is lost.
+ */
+int clientSendCombination(clientContext_t *context, const char *combination);
+
+/**
+ *	\fn			int clientRaceSend(clientContext_t *context, const code_t *guesses, int nbGuesses)
+ *	\brief		Streams guesses in a race game.
+ *	\param 		context : The client context.
+ *	\param 		guesses : The guesses.
+ *	\param 		nbGuesses : The number of guesses, RACE_GUESSES_PER_MESSAGE at most.
+ *	\details	Must be called in the CLIENT_RACING state. The guesses are sent in one message without waiting for their scores, which come with CLIENT_EVENT_RACE. Returns 0 on success and -1 if the window of messages in flight is full, the guesses are not valid or the server is lost.
+ */
+int clientRaceSend(clientContext_t *context, const code_t *guesses, int nbGuesses);
+
+/**
+ *	\fn			void clientClose(clientContext_t *context)
+ *	\brief		Closes the connection.
+ *	\param 		context : The client context.
+ *	\details	Once the game is over the queue belongs to the server, which removes it, and a lane of a shared queue is only forgotten. Otherwise the client removes it itself, through the transport of the thread. The context is left without a queue.
+ */
+void clientClose(clientContext_t *context);
+
+/**
+ *	\fn			int clientBookCombination(const clientContext_t *context, const book_t *book, char *combination)
+ *	\brief		Finds the combination the opening book plays next.
+ *	\param 		context : The client context.
+ *	\param 		book : The opening book.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The book is walked down the combinations and the results of the rounds played. Returns 0 on success and -1 if the game has left the book.
+ */
+int clientBookCombination(const clientContext_t *context, const book_t *book, char *combination);
+
+/**
+ *	\fn			int clientSolverCombination(const clientContext_t *context, solver_t *solver, code_t origin, char *combination)
+ *	\brief		Finds the minimax combination of the next round.
+ *	\param 		context : The client context.
+ *	\param 		solver : The solver, shared by the clients of the process.
+ *	\param 		origin : The code the ties between the best combinations are broken from, so the clients of a game do not all play the same ones.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The combination minimizes the worst case over the codes consistent with the results of the rounds played. Returns 0 on success and -1 if no code is consistent with the results.
+ */
+int clientSolverCombination(const clientContext_t *context, solver_t *solver, code_t origin, char *combination);
+
+/**
+ *	\fn			int _clientPollAck(clientContext_t *context)
+ *	\brief		Handles the ack of the last message sent, if the client waits for one.
+ *	\param 		context : The client context.
+ *	\details	Returns 1 if the ack was handled, 0 if the client does not wait for an ack or the ack has not come yet, and -1 if the server is lost.
+ */
+int _clientPollAck(clientContext_t *context);
+
+/**
+ *	\fn			int _clientHandleData(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles a data message of the server.
+ *	\param 		context : The client context.
+ *	\param 		message : The message.
+ *	\details	The meaning of the message depends on the state of the client. The message is acknowledged with the code the server expects. Returns the event raised by the message.
+ */
+int _clientHandleData(clientContext_t *context, mbuf_t *message);
+
+/**
+ *	\fn			int _clientMove(clientContext_t *context, mbuf_t *message)
+ *	\brief		Moves the client to a lane of the queue of its session.
+ *	\param 		context : The client context.
+ *	\param 		message : The shared queue and the index of the lane, separated by a colon.
+ *	\details	The move is acknowledged on the queue of the client, which the server removes once it has the ack, and the client plays on the lane from then on. Returns CLIENT_EVENT_NONE, or CLIENT_EVENT_LOST if the lane cannot be opened or the server is lost.
+ */
+int _clientMove(clientContext_t *context, mbuf_t *message);
+
+/**
+ *	\fn			int _clientHandleRace(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles the scores of a race message.
+ *	\param 		context : The client context.
+ *	\param 		message : The scores, two digits per guess.
+ *	\details	The scores answer the oldest message in flight. They are not acknowledged. Returns CLIENT_EVENT_RACE.
+ */
+int _clientHandleRace(clientContext_t *context, mbuf_t *message);
+
+/**
+ *	\fn			int _clientHandleDelta(otherPlayer_t *otherPlayer, mbuf_t *message)
+ *	\brief		Handles a delta of the history of another player.
+ *	\param 		otherPlayer : The other player.
+ *	\param 		message : The delta, the revision it starts from on SYNC_REVISION_WIDTH digits, then the good places and the good colors of each new row.
+ *	\details	The rows are appended to the history if the delta starts from the revision the client has, and the last row becomes the current result of the player. Returns 0, or -1 if the delta does not start from the client's revision.
+ */
+int _clientHandleDelta(otherPlayer_t *otherPlayer, mbuf_t *message);
+
+/**
+ *	\fn			void _clientHandleSummary(clientContext_t *context, mbuf_t *message)
+ *	\brief		Handles the summary of a lockstep round.
+ *	\param 		context : The client context.
+ *	\param 		message : The summary, SUMMARY_ROW_WIDTH characters per player in the order of the indexes: the good places, the good colors and 1 if the player played the round.
+ *	\details	The client's own row is its result, the other rows are stored in the order of the other players.
+ */
+void _clientHandleSummary(clientContext_t *context, mbuf_t *message);
+
+/**
+ *	\fn			int _clientRoundEndsGame(clientContext_t *context)
+ *	\brief		Checks if the last round ended the game for the client.
+ *	\param 		context : The client context.
+ *	\details	Returns 1 if the client has found the secret combination, has played all the rounds, or if another player has found the secret combination, and 0 otherwise.
+ */
+int _clientRoundEndsGame(clientContext_t *context);
+
+/**
+ *	\fn			int _clientLost(clientContext_t *context)
+ *	\brief		Marks the connection as lost.
+ *	\param 		context : The client context.
+ *	\details	Returns CLIENT_EVENT_LOST.
+ */
+int _clientLost(clientContext_t *context);
+
+#endif
@@ -33,9 +33,10 @@
  */
 struct otherPlayer
 {
-    int nbRound; /**<The number of rounds the other player has played*/
+    int nbRound; /**<The number of rounds the other player has played, the revision of its history the client has*/
     int nbGoodPlace; /**<The number of colors the other player has placed in the correct positions in the current round*/
     int nbGoodColor; /**<The number of correct colors the other player has placed in the current round, regardless of their positions*/
+    char result[MAX_ROUND][RESULT_WIDTH]; /**<The history of the other player, the result of each of its rounds, the first nbRound are known*/
 };
 typedef struct otherPlayer otherPlayer_t;
 
@@ -4,7 +4,7 @@
  *
  *	\details	This file contains the functions necessary for initializing the game state on the client side.
  */
-#include "clientInit.h" // client/include/init.h
+#include "clientInit.h"
 
 
 /**
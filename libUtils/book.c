@@ -0,0 +1,104 @@
+#include "book.h"
+
+
+/**
+ * \brief Map an opening book
+ * \param book The book
+ * \param path The path of the book file
+ * \return 0 on success, -1 if the file cannot be mapped or does not match the rules
+ * \details Only the header is checked, so opening a book costs the same whatever its size. The pages of the nodes are loaded as the walks touch them.
+*/
+int bookOpen(book_t *book, const char *path) {
+    const bookHeader_t *header;
+    struct stat status;
+    void *mapping;
+    int fd;
+
+    book->header = NULL;
+    book->nodes = NULL;
+    book->size = 0;
+    if ((fd = open(path, O_RDONLY)) == -1) {
+        return -1;
+    }
+    if (fstat(fd, &status) == -1 || (size_t) status.st_size < sizeof(bookHeader_t)) {
+        close(fd);
+        return -1;
+    }
+    mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+    header = mapping;
+    if (strncmp(header->magic, BOOK_MAGIC, sizeof(header->magic)) != 0
+        || header->version != BOOK_VERSION
+        || header->boardWidth != BOARD_WIDTH
+        || header->nbColors != NB_COLORS
+        || header->nbNodes == 0
+        || (size_t) status.st_size != sizeof(bookHeader_t) + header->nbNodes * sizeof(bookNode_t)) {
+        munmap(mapping, status.st_size);
+        return -1;
+    }
+    book->header = header;
+    book->nodes = (const bookNode_t *)(header + 1);
+    book->size = status.st_size;
+    return 0;
+}
+
+/**
+ * \brief Unmap an opening book
+ * \param book The book
+*/
+void bookClose(book_t *book) {
+    if (book->header != NULL) {
+        munmap((void *) book->header, book->size);
+    }
+    book->header = NULL;
+    book->nodes = NULL;
+    book->size = 0;
+}
+
+/**
+ * \brief Find the guess to play after some rounds
+ * \param book The book
+ * \param guesses The guesses played so far
+ * \param scores The scores of the guesses
+ * \param nbRound The number of rounds played
+ * \param guess The guess to play
+ * \return 0 on success, -1 if the rounds played leave the book
+ * \details The walk goes from the root down the scores of the rounds. It leaves the book when a guess played is not the guess of its node, or when the book does not cover a score.
+*/
+int bookLookup(const book_t *book, const code_t *guesses, const score_t *scores, int nbRound, code_t *guess) {
+    uint32_t node = BOOK_ROOT;
+    int index;
+    if (book->header == NULL) {
+        return -1;
+    }
+    for (int round = 0; round < nbRound; round++) {
+        if (book->nodes[node].guess != guesses[round] || (index = bookScoreIndex(scores[round])) == -1) {
+            return -1;
+        }
+        node = book->nodes[node].children[index];
+        if (node == BOOK_OUT || node >= book->header->nbNodes) {
+            return -1;
+        }
+    }
+    *guess = book->nodes[node].guess;
+    return 0;
+}
+
+/**
+ * \brief Get the index of a score among the children of a node
+ * \param score The packed score
+ * \return The index, or -1 if the score is not possible
+ * \details The scores are ordered by good places, then by good colors.
+*/
+int bookScoreIndex(score_t score) {
+    int goodPlace = SCORE_GOOD_PLACE(score);
+    int goodColor = SCORE_GOOD_COLOR(score);
+    if (goodPlace + goodColor > BOARD_WIDTH) {
+        return -1;
+    }
+    // The scores with fewer good places come first, there are BOARD_WIDTH + 1 - k of them with k good places
+    return goodPlace * (BOARD_WIDTH + 1) - goodPlace * (goodPlace - 1) / 2 + goodColor;
+}
@@ -0,0 +1,62 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "code.h"
+
+#define BOOK_MAGIC "MMBOOK"
+#define BOOK_VERSION 1
+#define BOOK_NB_SCORES ((BOARD_WIDTH + 1) * (BOARD_WIDTH + 2) / 2) // The scores with good places + good colors <= BOARD_WIDTH
+#define BOOK_ROOT 0
+#define BOOK_OUT 0 // No node has the root as a child, so the root index marks a path out of the book
+
+/**
+ * \struct      bookHeader
+ * \brief       Represents the header of an opening book file.
+ * \details     The file is the header followed by the nodes, in the byte order of the machine that generated it. The rules it was generated for must match the rules of the reader.
+*/
+struct bookHeader {
+    char magic[8]; /**<BOOK_MAGIC.*/
+    uint32_t version; /**<BOOK_VERSION.*/
+    uint16_t boardWidth; /**<The number of colors of a combination.*/
+    uint16_t nbColors; /**<The number of colors.*/
+    uint32_t nbNodes; /**<The number of nodes.*/
+    uint32_t depth; /**<The number of guesses covered by the book.*/
+};
+typedef struct bookHeader bookHeader_t;
+
+/**
+ * \struct      bookNode
+ * \brief       Represents a node of the decision tree, the guess to play after a path of scores.
+ * \details     The child of a score is the node to play once the guess got that score, indexed by bookScoreIndex. A node takes one cache line for the standard rules.
+*/
+struct bookNode {
+    code_t guess; /**<The guess to play.*/
+    uint16_t candidates; /**<The number of codes still possible before the guess.*/
+    uint32_t children[BOOK_NB_SCORES]; /**<The children of the node by score, BOOK_OUT for the scores out of the book.*/
+};
+typedef struct bookNode bookNode_t;
+
+/**
+ * \struct      book
+ * \brief       Represents an opening book mapped in memory.
+ * \details     The mapping is read only and shared, so the processes using the same book share its pages.
+*/
+struct book {
+    const bookHeader_t *header; /**<The header, at the beginning of the mapping.*/
+    const bookNode_t *nodes; /**<The nodes, the root first.*/
+    size_t size; /**<The size of the mapping.*/
+};
+typedef struct book book_t;
+
+int bookOpen(book_t *book, const char *path);
+void bookClose(book_t *book);
+int bookLookup(const book_t *book, const code_t *guesses, const score_t *scores, int nbRound, code_t *guess);
+int bookScoreIndex(score_t score);
+
+#endif
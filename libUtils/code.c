@@ -0,0 +1,83 @@
+#include "code.h"
+
+score_t codeFeedback[NB_CODES][NB_CODES];
+static pthread_once_t codeFeedbackOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * \brief Pack a combination into a code
+ * \param combination The BOARD_WIDTH colors of the combination
+ * \param code The packed code
+ * \return 0 on success, -1 if a color is not valid
+ * \details The colors are the digits of the code in base NB_COLORS, in the order of CODE_COLORS.
+*/
+int codePack(const char *combination, code_t *code) {
+    const char *color;
+    int packed = 0;
+    for (int i = 0; i < BOARD_WIDTH; i++) {
+        if (combination[i] == '\0' || (color = strchr(CODE_COLORS, combination[i])) == NULL) {
+            return -1;
+        }
+        packed = packed * NB_COLORS + (color - CODE_COLORS);
+    }
+    *code = packed;
+    return 0;
+}
+
+/**
+ * \brief Unpack a code into a combination
+ * \param code The packed code
+ * \param combination The buffer where the BOARD_WIDTH colors are stored, it is not terminated
+*/
+void codeUnpack(code_t code, char *combination) {
+    for (int i = BOARD_WIDTH - 1; i >= 0; i--) {
+        combination[i] = CODE_COLORS[code % NB_COLORS];
+        code /= NB_COLORS;
+    }
+}
+
+/**
+ * \brief Score a guess against the secret code
+ * \param guess The packed guess
+ * \param secret The packed secret code
+ * \return The packed score
+ * \details The good colors do not count the good places.
+*/
+score_t codeScore(code_t guess, code_t secret) {
+    int guessColors[NB_COLORS] = {0};
+    int secretColors[NB_COLORS] = {0};
+    int goodPlace = 0;
+    int goodColor = 0;
+    for (int i = 0; i < BOARD_WIDTH; i++) {
+        if (guess % NB_COLORS == secret % NB_COLORS) {
+            goodPlace++;
+        }
+        guessColors[guess % NB_COLORS]++;
+        secretColors[secret % NB_COLORS]++;
+        guess /= NB_COLORS;
+        secret /= NB_COLORS;
+    }
+    for (int i = 0; i < NB_COLORS; i++) {
+        goodColor += guessColors[i] < secretColors[i] ? guessColors[i] : secretColors[i];
+    }
+    return SCORE(goodPlace, goodColor - goodPlace);
+}
+
+/**
+ * \brief Initialize the feedback table
+ * \details The table holds the score of every guess against every secret code, so the solvers score a pair with one load. It is filled once, the first call does the work and the others wait for it. The table is only touched by the processes that call this function.
+*/
+void codeFeedbackInit() {
+    pthread_once(&codeFeedbackOnce, _codeFeedbackFill);
+}
+
+/**
+ * \brief Fill the feedback table
+ * \details The score is symmetric, so each pair is scored once.
+*/
+void _codeFeedbackFill() {
+    for (int guess = 0; guess < NB_CODES; guess++) {
+        for (int secret = guess; secret < NB_CODES; secret++) {
+            codeFeedback[guess][secret] = codeFeedback[secret][guess] = codeScore(guess, secret);
+        }
+    }
+}
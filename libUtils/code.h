@@ -0,0 +1,40 @@
+#ifndef CODE_H
+#define CODE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "clientData.h"
+
+#define CODE_COLORS "RGBCYM"
+#define NB_COLORS 6
+#define NB_CODES 1296 // NB_COLORS ^ BOARD_WIDTH
+
+/**
+ * \def         SCORE(goodPlace, goodColor)
+ * \brief       Packs a score in one byte, the good places in the high nibble and the good colors in the low nibble.
+ */
+#define SCORE(goodPlace, goodColor) ((score_t)(((goodPlace) << 4) | (goodColor)))
+#define SCORE_GOOD_PLACE(score) ((score) >> 4)
+#define SCORE_GOOD_COLOR(score) ((score) & 0x0F)
+#define SCORE_WIN SCORE(BOARD_WIDTH, 0)
+#define NB_SCORES (SCORE_WIN + 1) // Bound of the packed scores, for the arrays indexed by score
+
+/**
+ * \def         CODE_FEEDBACK(guess, secret)
+ * \brief       Returns the score of a guess against a secret code from the feedback table, once codeFeedbackInit has been called.
+ */
+#define CODE_FEEDBACK(guess, secret) (codeFeedback[guess][secret])
+
+typedef uint16_t code_t; /**<A combination packed as its index in base NB_COLORS, the first color being the most significant digit.*/
+typedef uint8_t score_t; /**<A score packed by SCORE.*/
+
+extern score_t codeFeedback[NB_CODES][NB_CODES];
+
+int codePack(const char *combination, code_t *code);
+void codeUnpack(code_t code, char *combination);
+score_t codeScore(code_t guess, code_t secret);
+void codeFeedbackInit();
+void _codeFeedbackFill();
+
+#endif
@@ -0,0 +1,78 @@
+#include "coroutine.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static __thread coroutine_t *currentCoroutine = NULL;
+
+/**
+ * \brief Initialize a coroutine
+ * \param coroutine The coroutine
+ * \param function The function run by the coroutine
+ * \param args The argument of the function
+ * \param stack The stack of the coroutine
+ * \param stackSize The size of the stack
+ * \details This function prepares the coroutine so that its first resume calls the function on the given stack. The stack must stay allocated until the coroutine has finished.
+*/
+void coroutineInit(coroutine_t *coroutine, void (*function)(void *), void *args, char *stack, size_t stackSize) {
+    getcontext(&coroutine->context);
+    coroutine->context.uc_stack.ss_sp = stack;
+    coroutine->context.uc_stack.ss_size = stackSize;
+    coroutine->context.uc_link = NULL;
+    coroutine->caller = NULL;
+    coroutine->function = function;
+    coroutine->args = args;
+    coroutine->finished = 0;
+    coroutine->started = 0;
+    makecontext(&coroutine->context, _coroutineEntry, 0);
+}
+
+/**
+ * \brief Resume a coroutine
+ * \param coroutine The coroutine
+ * \return 1 if the coroutine yielded, 0 if it has finished
+ * \details This function runs the coroutine on the calling thread until it yields or returns. The first resume makes the calling thread the owner of the coroutine, and resuming it from another thread stops the process.
+*/
+int coroutineResume(coroutine_t *coroutine) {
+    ucontext_t caller;
+    coroutine_t *previous = currentCoroutine;
+    if (!coroutine->started) {
+        coroutine->owner = pthread_self();
+        coroutine->started = 1;
+    } else if (!pthread_equal(coroutine->owner, pthread_self())) {
+        fprintf(stderr, "Error: coroutine resumed by a thread that did not start it.\n");
+        exit(-1);
+    }
+    coroutine->caller = &caller;
+    currentCoroutine = coroutine;
+    swapcontext(&caller, &coroutine->context);
+    currentCoroutine = previous;
+    return !coroutine->finished;
+}
+
+/**
+ * \brief Yield the current coroutine
+ * \details This function gives the hand back to the thread that resumed the coroutine. It returns when the coroutine is resumed again, by the same thread.
+*/
+void coroutineYield() {
+    coroutine_t *coroutine = currentCoroutine;
+    swapcontext(&coroutine->context, coroutine->caller);
+}
+
+/**
+ * \brief Get the running coroutine
+ * \return The coroutine running on the calling thread, or NULL outside of a coroutine
+*/
+coroutine_t *coroutineCurrent() {
+    return currentCoroutine;
+}
+
+/**
+ * \brief Entry point of every coroutine
+ * \details This function calls the function of the coroutine, marks it finished and switches back to the thread that resumed it for the last time.
+*/
+void _coroutineEntry() {
+    coroutine_t *coroutine = currentCoroutine;
+    coroutine->function(coroutine->args);
+    coroutine->finished = 1;
+    setcontext(coroutine->caller);
+}
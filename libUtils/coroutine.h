@@ -0,0 +1,32 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <ucontext.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define COROUTINE_STACK_SIZE (64*1024)
+
+/**
+ * \struct      coroutine
+ * \brief       Represents a coroutine running a function on its own stack.
+ * \details     A coroutine is resumed by a thread and runs until it yields or returns. It must always be resumed by the thread that started it: the compiler may keep the address of thread local state, such as errno, across a yield, so a coroutine resumed by another thread would use the state of the first one.
+*/
+struct coroutine {
+    ucontext_t context; /**<The saved context of the coroutine.*/
+    ucontext_t *caller; /**<The context of the thread that resumed the coroutine.*/
+    void (*function)(void *); /**<The function run by the coroutine.*/
+    void *args; /**<The argument of the function.*/
+    int finished; /**<1 once the function has returned.*/
+    int started; /**<1 once the coroutine has been resumed.*/
+    pthread_t owner; /**<The thread that started the coroutine, the only one resuming it.*/
+};
+typedef struct coroutine coroutine_t;
+
+void coroutineInit(coroutine_t *coroutine, void (*function)(void *), void *args, char *stack, size_t stackSize);
+int coroutineResume(coroutine_t *coroutine);
+void coroutineYield();
+coroutine_t *coroutineCurrent();
+void _coroutineEntry();
+
+#endif
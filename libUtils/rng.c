@@ -0,0 +1,34 @@
+#include "rng.h"
+
+
+/**
+ * \brief Seed a generator
+ * \param rng The generator
+ * \param seed The seed
+*/
+void rngSeed(rng_t *rng, uint64_t seed) {
+    rng->state = seed;
+}
+
+/**
+ * \brief Draw a number
+ * \param rng The generator
+ * \return A number uniformly distributed on 32 bits
+*/
+uint32_t rngNext(rng_t *rng) {
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (z ^ (z >> 31)) >> 32;
+}
+
+/**
+ * \brief Draw a number below a bound
+ * \param rng The generator
+ * \param bound The bound, greater than 0
+ * \return A number between 0 and bound - 1
+ * \details The draw is scaled rather than reduced modulo the bound, the bias is below bound / 2^32.
+*/
+uint32_t rngBelow(rng_t *rng, uint32_t bound) {
+    return ((uint64_t) rngNext(rng) * bound) >> 32;
+}
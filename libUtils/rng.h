@@ -0,0 +1,20 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * \struct      rng
+ * \brief       Represents a seeded random number generator.
+ * \details     The generator is splitmix64. Its whole state is the structure, so two generators seeded alike draw the same numbers on any machine, and each thread can own one.
+*/
+struct rng {
+    uint64_t state; /**<The state, advanced by each draw.*/
+};
+typedef struct rng rng_t;
+
+void rngSeed(rng_t *rng, uint64_t seed);
+uint32_t rngNext(rng_t *rng);
+uint32_t rngBelow(rng_t *rng, uint32_t bound);
+
+#endif
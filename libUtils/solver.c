@@ -0,0 +1,307 @@
+#include "solver.h"
+
+
+/**
+ * \brief Initialize a solver
+ * \param solver The solver
+ * \param nbWorkers The number of threads helping the searches, 0 for the callers to search alone
+ * \return 0 on success, -1 if the number of workers is not valid or a worker cannot be created
+ * \details The feedback table is filled if it is not yet. The memo starts empty.
+*/
+int solverInit(solver_t *solver, int nbWorkers) {
+    if (nbWorkers < 0 || nbWorkers > SOLVER_MAX_WORKERS) {
+        return -1;
+    }
+    codeFeedbackInit();
+    memset(solver, 0, sizeof(solver_t));
+    pthread_mutex_init(&solver->mutex, NULL);
+    pthread_cond_init(&solver->cond, NULL);
+    pthread_mutex_init(&solver->cacheMutex, NULL);
+    for (int i = 0; i < nbWorkers; i++) {
+        solver->workers[i].solver = solver;
+        solver->workers[i].slot = i + 1;
+        if (pthread_create(&solver->workers[i].thread, NULL, _solverWorkerHandler, &solver->workers[i]) != 0) {
+            solverDestroy(solver);
+            return -1;
+        }
+        solver->nbWorkers++;
+    }
+    return 0;
+}
+
+/**
+ * \brief Stop the workers of a solver
+ * \param solver The solver
+ * \details No search must be running. The memo is kept, the solver can still search without its workers.
+*/
+void solverDestroy(solver_t *solver) {
+    pthread_mutex_lock(&solver->mutex);
+    solver->stop = 1;
+    pthread_cond_broadcast(&solver->cond);
+    pthread_mutex_unlock(&solver->mutex);
+    for (int i = 0; i < solver->nbWorkers; i++) {
+        pthread_join(solver->workers[i].thread, NULL);
+    }
+    solver->nbWorkers = 0;
+}
+
+/**
+ * \brief Find the minimax guess of a set of candidates
+ * \param solver The solver
+ * \param candidates The codes still possible, in increasing order
+ * \param nbCandidates The number of candidates, greater than 0
+ * \param origin The code the ties are broken from
+ * \param worstCase Where the worst case of the guess is stored, or NULL
+ * \return The guess
+ * \details Every code is tried and the guesses with the smallest worst case, the largest group of candidates sharing a score, are the best ones. If some of them are candidates, only those are kept. The guess returned is the first best one from the origin, so it does not depend on the number of threads, and the callers drawing their origin do not all play the same guess. Below three candidates, the first one is optimal.
+ *          The best guesses of a set are memoized, a set met again is answered without a search whatever the origin.
+*/
+code_t solverBestGuess(solver_t *solver, const code_t *candidates, int nbCandidates, code_t origin, int *worstCase) {
+    solverEntry_t *entry;
+    solverEntry_t found = {0};
+    uint64_t hash;
+    code_t guess;
+
+    if (nbCandidates <= 2) {
+        if (worstCase != NULL) {
+            *worstCase = 1;
+        }
+        return candidates[0];
+    }
+    hash = _solverHash(candidates, nbCandidates);
+    entry = &solver->cache[hash & (SOLVER_CACHE_SIZE - 1)];
+    pthread_mutex_lock(&solver->cacheMutex);
+    if (entry->hash == hash && entry->nbCandidates == (uint32_t) nbCandidates) {
+        found = *entry;
+    }
+    pthread_mutex_unlock(&solver->cacheMutex);
+    if (found.hash != 0) {
+        __atomic_add_fetch(&solver->nbMemoized, 1, __ATOMIC_RELAXED);
+    } else {
+        _solverSearch(solver, candidates, nbCandidates, &found);
+        found.hash = hash;
+        pthread_mutex_lock(&solver->cacheMutex);
+        *entry = found;
+        pthread_mutex_unlock(&solver->cacheMutex);
+    }
+
+    // There is always a best guess, the loop ends on it
+    for (guess = origin; !(found.best[guess / 64] >> (guess % 64) & 1); guess = (guess + 1) % NB_CODES);
+    if (worstCase != NULL) {
+        *worstCase = found.worstCase;
+    }
+    return guess;
+}
+
+/**
+ * \brief Search the best guesses of a set of candidates
+ * \param solver The solver
+ * \param candidates The candidates
+ * \param nbCandidates The number of candidates
+ * \param result Where the worst case and the best guesses are stored
+ * \details A guess is dropped as soon as one of its parts exceeds the best worst case found by any thread, so most guesses are dropped after a few candidates. The workers are offered the searches large enough to be worth waking them, the caller searching with them.
+*/
+void _solverSearch(solver_t *solver, const code_t *candidates, int nbCandidates, solverEntry_t *result) {
+    solverJob_t job;
+    solverJob_t **previous;
+    uint8_t isCandidate[NB_CODES] = {0};
+    int parallel;
+    int bestIsCandidate = 0;
+
+    job.candidates = candidates;
+    job.nbCandidates = nbCandidates;
+    job.bound = nbCandidates;
+    job.nbActive = 0;
+    parallel = solver->nbWorkers > 0 && nbCandidates * NB_CODES >= SOLVER_PARALLEL_WORK;
+    job.nbDeques = parallel ? solver->nbWorkers + 1 : 1;
+    // Each thread starts with a contiguous share of the guesses
+    for (int i = 0; i < job.nbDeques; i++) {
+        job.deques[i] = ((uint64_t) (i * SOLVER_NB_TASKS / job.nbDeques) << 32) | (uint64_t) ((i + 1) * SOLVER_NB_TASKS / job.nbDeques);
+    }
+
+    if (parallel) {
+        pthread_mutex_lock(&solver->mutex);
+        job.next = solver->jobs;
+        solver->jobs = &job;
+        pthread_cond_broadcast(&solver->cond);
+        pthread_mutex_unlock(&solver->mutex);
+        __atomic_add_fetch(&solver->nbParallel, 1, __ATOMIC_RELAXED);
+    }
+    _solverWork(&job, 0);
+    if (parallel) {
+        pthread_mutex_lock(&solver->mutex);
+        for (previous = &solver->jobs; *previous != &job; previous = &(*previous)->next);
+        *previous = job.next;
+        pthread_mutex_unlock(&solver->mutex);
+        // No worker joins the search once it is withdrawn, the ones in it are finishing their last task
+        while (__atomic_load_n(&job.nbActive, __ATOMIC_ACQUIRE) > 0) {
+            sched_yield();
+        }
+    }
+    __atomic_add_fetch(&solver->nbSearches, 1, __ATOMIC_RELAXED);
+
+    result->nbCandidates = nbCandidates;
+    result->worstCase = job.bound;
+    for (int i = 0; i < nbCandidates; i++) {
+        isCandidate[candidates[i]] = 1;
+        bestIsCandidate |= job.worstCases[candidates[i]] == job.bound;
+    }
+    memset(result->best, 0, sizeof(result->best));
+    for (int guess = 0; guess < NB_CODES; guess++) {
+        if (job.worstCases[guess] == job.bound && (isCandidate[guess] || !bestIsCandidate)) {
+            result->best[guess / 64] |= 1ULL << (guess % 64);
+        }
+    }
+}
+
+/**
+ * \brief List the codes consistent with the rounds played
+ * \param guesses The guesses of the rounds
+ * \param scores The scores of the guesses
+ * \param nbRound The number of rounds
+ * \param candidates The buffer where the codes are stored, NB_CODES codes
+ * \return The number of codes, in increasing order
+*/
+int solverCandidates(const code_t *guesses, const score_t *scores, int nbRound, code_t *candidates) {
+    int nbCandidates = 0;
+    int round;
+    for (int code = 0; code < NB_CODES; code++) {
+        for (round = 0; round < nbRound && CODE_FEEDBACK(guesses[round], code) == scores[round]; round++);
+        if (round == nbRound) {
+            candidates[nbCandidates++] = code;
+        }
+    }
+    return nbCandidates;
+}
+
+/**
+ * \brief Run a worker of the pool
+ * \param args The worker
+ * \return NULL
+ * \details The worker sleeps until a search with tasks left is offered, takes part in it, then looks for another one. A worker takes part in one search at a time, always with its own deque.
+*/
+void *_solverWorkerHandler(void *args) {
+    solverWorker_t *worker = args;
+    solver_t *solver = worker->solver;
+    solverJob_t *job;
+    int remaining;
+
+    pthread_mutex_lock(&solver->mutex);
+    while (!solver->stop) {
+        for (job = solver->jobs; job != NULL; job = job->next) {
+            remaining = 0;
+            for (int i = 0; i < job->nbDeques && !remaining; i++) {
+                uint64_t deque = __atomic_load_n(&job->deques[i], __ATOMIC_ACQUIRE);
+                remaining = (deque >> 32) < (deque & 0xFFFFFFFF);
+            }
+            if (remaining) {
+                break;
+            }
+        }
+        if (job == NULL) {
+            pthread_cond_wait(&solver->cond, &solver->mutex);
+            continue;
+        }
+        __atomic_add_fetch(&job->nbActive, 1, __ATOMIC_ACQ_REL);
+        pthread_mutex_unlock(&solver->mutex);
+        _solverWork(job, worker->slot);
+        __atomic_sub_fetch(&job->nbActive, 1, __ATOMIC_RELEASE);
+        pthread_mutex_lock(&solver->mutex);
+    }
+    pthread_mutex_unlock(&solver->mutex);
+    return NULL;
+}
+
+/**
+ * \brief Take part in a search
+ * \param job The search
+ * \param slot The deque of the thread
+ * \details The thread runs the tasks of its deque, then the tasks it steals from the others, until no task is left.
+*/
+void _solverWork(solverJob_t *job, int slot) {
+    int task;
+    while ((task = _solverTake(job, slot, 0)) != -1 || (task = _solverTake(job, slot, 1)) != -1) {
+        _solverTask(job, task);
+    }
+}
+
+/**
+ * \brief Take a task of a search
+ * \param job The search
+ * \param slot The deque of the thread
+ * \param steal 0 to take from the front of the thread's deque, 1 to steal from the back of another deque
+ * \return The task, -1 if there is none
+ * \details The deques are tried from the next one, so the thieves spread over the deques.
+*/
+int _solverTake(solverJob_t *job, int slot, int steal) {
+    uint64_t deque;
+    uint32_t head, tail;
+    int victim;
+    for (int i = steal; i < (steal ? job->nbDeques : 1); i++) {
+        victim = (slot + i) % job->nbDeques;
+        deque = __atomic_load_n(&job->deques[victim], __ATOMIC_ACQUIRE);
+        do {
+            head = deque >> 32;
+            tail = deque & 0xFFFFFFFF;
+            if (head >= tail) {
+                break;
+            }
+        } while (!__atomic_compare_exchange_n(&job->deques[victim], &deque,
+                                              steal ? ((uint64_t) head << 32) | (tail - 1) : ((uint64_t) (head + 1) << 32) | tail,
+                                              0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+        if (head < tail) {
+            return steal ? (int) tail - 1 : (int) head;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \brief Run a task of a search
+ * \param job The search
+ * \param task The task, its guesses are the next SOLVER_TASK_SIZE codes
+ * \details Each guess splits the candidates by score. The bound is shared, a thread lowering it prunes the guesses of the others.
+*/
+void _solverTask(solverJob_t *job, int task) {
+    const code_t *candidates = job->candidates;
+    int nbCandidates = job->nbCandidates;
+    int parts[NB_SCORES];
+    int end = MIN((task + 1) * SOLVER_TASK_SIZE, NB_CODES);
+    int bound, worstCase, i;
+    const score_t *feedback;
+
+    for (int guess = task * SOLVER_TASK_SIZE; guess < end; guess++) {
+        bound = __atomic_load_n(&job->bound, __ATOMIC_RELAXED);
+        feedback = codeFeedback[guess];
+        memset(parts, 0, sizeof(parts));
+        worstCase = 0;
+        for (i = 0; i < nbCandidates && worstCase <= bound; i++) {
+            // MAX would increment the part twice
+            if (++parts[feedback[candidates[i]]] > worstCase) {
+                worstCase = parts[feedback[candidates[i]]];
+            }
+        }
+        if (worstCase > bound) {
+            job->worstCases[guess] = SOLVER_PRUNED;
+            continue;
+        }
+        job->worstCases[guess] = worstCase;
+        while (worstCase < bound && !__atomic_compare_exchange_n(&job->bound, &bound, worstCase, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+}
+
+/**
+ * \brief Hash a set of candidates
+ * \param candidates The candidates
+ * \param nbCandidates The number of candidates
+ * \return The hash, never 0
+ * \details The hash is FNV-1a over the size and the codes.
+*/
+uint64_t _solverHash(const code_t *candidates, int nbCandidates) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = (hash ^ (uint32_t) nbCandidates) * 0x100000001B3ULL;
+    for (int i = 0; i < nbCandidates; i++) {
+        hash = (hash ^ candidates[i]) * 0x100000001B3ULL;
+    }
+    return hash != 0 ? hash : 1;
+}
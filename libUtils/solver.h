@@ -0,0 +1,91 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "code.h"
+#include "serverData.h"
+
+#define SOLVER_MAX_WORKERS 64
+#define SOLVER_TASK_SIZE 32 // The guesses of a task, the unit of work stolen between the threads
+#define SOLVER_NB_TASKS ((NB_CODES + SOLVER_TASK_SIZE - 1) / SOLVER_TASK_SIZE)
+#define SOLVER_PARALLEL_WORK (1 << 16) // The guesses times the candidates below which the caller searches alone, waking the workers would cost more
+#define SOLVER_CACHE_SIZE 16384 // The entries of the memo, a power of 2
+#define SOLVER_NB_WORDS ((NB_CODES + 63) / 64) // The words of a set of codes
+#define SOLVER_PRUNED UINT16_MAX // The worst case of a guess dropped by the search
+
+/**
+ * \struct      solverEntry
+ * \brief       Represents the best guesses memoized for a set of candidates.
+ * \details     The sets are told apart by their hash and their size. All the best guesses are kept, so the memo answers whatever the code the ties are broken from.
+*/
+struct solverEntry {
+    uint64_t hash; /**<The hash of the candidates, 0 for an empty entry.*/
+    uint32_t nbCandidates; /**<The number of candidates.*/
+    int worstCase; /**<The largest part of the candidates left by the best guesses.*/
+    uint64_t best[SOLVER_NB_WORDS]; /**<The best guesses, a bit per code.*/
+};
+typedef struct solverEntry solverEntry_t;
+
+/**
+ * \struct      solverJob
+ * \brief       Represents a search being run.
+ * \details     The guesses are split into tasks. Each thread taking part in the search owns a deque of tasks: it takes its tasks from the front and, once its deque is empty, steals from the back of the others. The deque packs its head and tail in one word, so a take and a steal are each a compare and swap.
+*/
+struct solverJob {
+    const code_t *candidates; /**<The candidates.*/
+    int nbCandidates; /**<The number of candidates.*/
+    uint64_t deques[SOLVER_MAX_WORKERS + 1]; /**<The tasks left to each thread, the head in the high half and the tail in the low half.*/
+    int nbDeques; /**<The number of deques, the caller's first.*/
+    int bound; /**<The smallest worst case found, a guess is dropped as soon as one of its parts exceeds it.*/
+    uint16_t worstCases[NB_CODES]; /**<The worst case of each guess, SOLVER_PRUNED for the guesses dropped.*/
+    int nbActive; /**<The number of workers taking part in the search.*/
+    struct solverJob *next; /**<The next search offered to the workers.*/
+};
+typedef struct solverJob solverJob_t;
+
+/**
+ * \struct      solverWorker
+ * \brief       Represents a thread of the pool.
+*/
+struct solverWorker {
+    struct solver *solver; /**<The solver of the thread.*/
+    int slot; /**<The deque of the thread in the searches it takes part in.*/
+    pthread_t thread; /**<The thread.*/
+};
+typedef struct solverWorker solverWorker_t;
+
+/**
+ * \struct      solver
+ * \brief       Represents a minimax solver and its pool of workers.
+ * \details     The solver is shared by all the threads of a process: each search is run by its caller, helped by the workers that are free. The memo is shared too, so a set of candidates met by several players is searched once.
+*/
+struct solver {
+    solverWorker_t workers[SOLVER_MAX_WORKERS]; /**<The workers.*/
+    int nbWorkers; /**<The number of workers.*/
+    solverJob_t *jobs; /**<The searches offered to the workers.*/
+    int stop; /**<1 once the workers must exit.*/
+    pthread_mutex_t mutex; /**<Protects the searches offered and stop.*/
+    pthread_cond_t cond; /**<Signaled when a search is offered.*/
+    solverEntry_t cache[SOLVER_CACHE_SIZE]; /**<The memo, indexed by the hash of the candidates.*/
+    pthread_mutex_t cacheMutex; /**<Protects the memo.*/
+    long nbSearches; /**<The number of searches run.*/
+    long nbParallel; /**<The number of searches the workers were offered.*/
+    long nbMemoized; /**<The number of searches answered by the memo.*/
+};
+typedef struct solver solver_t;
+
+int solverInit(solver_t *solver, int nbWorkers);
+void solverDestroy(solver_t *solver);
+code_t solverBestGuess(solver_t *solver, const code_t *candidates, int nbCandidates, code_t origin, int *worstCase);
+int solverCandidates(const code_t *guesses, const score_t *scores, int nbRound, code_t *candidates);
+void _solverSearch(solver_t *solver, const code_t *candidates, int nbCandidates, solverEntry_t *result);
+void *_solverWorkerHandler(void *args);
+void _solverWork(solverJob_t *job, int slot);
+int _solverTake(solverJob_t *job, int slot, int steal);
+void _solverTask(solverJob_t *job, int task);
+uint64_t _solverHash(const code_t *candidates, int nbCandidates);
+
+#endif
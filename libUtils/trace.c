@@ -0,0 +1,222 @@
+#include "trace.h"
+
+int traceEnabled = 0;
+static char traceProcessName[32];
+static char *tracePath = NULL;
+static uint64_t *traceTags = NULL;
+static traceBuffer_t *traceBuffers = NULL;
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread traceBuffer_t *traceLocal = NULL;
+
+/**
+ * \brief Enable the trace if it is asked for
+ * \param processName The name of the process in the trace viewer
+ * \details The trace is enabled when the TRACE_ENV environment variable is set. The events are written at exit to the file named after its value and the PID, in the Chrome trace event format.
+*/
+void traceInit(const char *processName) {
+    const char *prefix = getenv(TRACE_ENV);
+    if (prefix == NULL || prefix[0] == '\0') {
+        return;
+    }
+    traceTags = calloc(TRACE_QUEUE_SLOTS, sizeof(uint64_t));
+    tracePath = malloc(strlen(prefix) + 32);
+    if (traceTags == NULL || tracePath == NULL) {
+        perror("Error: could not enable the trace");
+        return;
+    }
+    sprintf(tracePath, "%s.%d.json", prefix, getpid());
+    strncpy(traceProcessName, processName, sizeof(traceProcessName) - 1);
+    traceEnabled = 1;
+    atexit(traceWrite);
+}
+
+/**
+ * \brief Tag the events of a queue with a session and a player
+ * \param msgid The message queue
+ * \param session The session, or TRACE_NO_TAG
+ * \param player The player, or TRACE_NO_TAG
+ * \details The tag is kept until the queue is tagged again. A later queue with the same index replaces it. Sessions are tagged modulo 2^24.
+*/
+void traceTagQueue(int msgid, int session, int player) {
+    uint64_t tag;
+    if (!traceEnabled) {
+        return;
+    }
+    // The tag is one word so recording an event reads it without lock, the queue is stored plus one so an empty slot matches no queue
+    tag = ((uint64_t)(uint32_t)(msgid + 1) << 32) | ((uint64_t)(session & TRACE_SESSION_MASK) << 8) | (uint8_t) player;
+    __atomic_store_n(&traceTags[(uint32_t) msgid % TRACE_QUEUE_SLOTS], tag, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Get the time of the trace
+ * \return The monotonic time in nanoseconds, the same in every process of the machine, or 0 when the trace is disabled
+*/
+long traceClock() {
+    struct timespec now;
+    if (!traceEnabled) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+ * \brief Record an event lasting from the given start until now
+ * \param name The name of the event, a string literal
+ * \param start The start of the event, given by traceClock
+ * \param msgid The message queue
+ * \param code The validation code of the exchange
+ * \param data The data exchanged, or NULL
+*/
+void traceComplete(const char *name, long start, int msgid, int code, const char *data) {
+    if (traceEnabled) {
+        _traceRecord(name, start, traceClock() - start, msgid, code, data);
+    }
+}
+
+/**
+ * \brief Record an instant event
+ * \param name The name of the event, a string literal
+ * \param msgid The message queue
+ * \param code The validation code of the exchange
+ * \param data The data exchanged, or NULL
+*/
+void traceInstant(const char *name, int msgid, int code, const char *data) {
+    if (traceEnabled) {
+        _traceRecord(name, traceClock(), -1, msgid, code, data);
+    }
+}
+
+/**
+ * \brief Write the trace
+ * \details The events of every thread are written to the trace file as a Chrome trace event JSON object. The traces of the processes of a game can be merged by concatenating their traceEvents arrays.
+*/
+void traceWrite() {
+    FILE *file;
+    int count;
+    if (!traceEnabled) {
+        return;
+    }
+    if ((file = fopen(tracePath, "w")) == NULL) {
+        perror("Error: could not write the trace");
+        return;
+    }
+    pthread_mutex_lock(&traceMutex);
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(file, "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"%s %d\"}}", getpid(), traceProcessName, getpid());
+    for (traceBuffer_t *buffer = traceBuffers; buffer != NULL; buffer = buffer->next) {
+        for (traceChunk_t *chunk = buffer->first; chunk != NULL; chunk = chunk->next) {
+            count = __atomic_load_n(&chunk->count, __ATOMIC_ACQUIRE);
+            for (int i = 0; i < count; i++) {
+                traceEvent_t *event = &chunk->events[i];
+                fprintf(file, ",\n  {\"name\": \"%s\", \"cat\": \"ipc\", \"ts\": %.3f, ", event->name, event->start / 1000.0);
+                if (event->duration < 0) {
+                    fprintf(file, "\"ph\": \"i\", \"s\": \"t\", ");
+                } else {
+                    fprintf(file, "\"ph\": \"X\", \"dur\": %.3f, ", event->duration / 1000.0);
+                }
+                fprintf(file, "\"pid\": %d, \"tid\": %ld, \"args\": {\"msgid\": %d, \"code\": %d, \"session\": %d, \"player\": %d, \"data\": ",
+                        getpid(), buffer->tid, event->msgid, event->code, event->session, event->player);
+                _traceWriteString(file, event->data, TRACE_DATA_SIZE);
+                fprintf(file, "}}");
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    pthread_mutex_unlock(&traceMutex);
+    fclose(file);
+}
+
+/**
+ * \brief Record an event in the buffer of the calling thread
+ * \param name The name of the event
+ * \param start The start of the event
+ * \param duration The duration of the event, or -1 for an instant event
+ * \param msgid The message queue
+ * \param code The validation code of the exchange
+ * \param data The data exchanged, or NULL
+ * \details The event is counted once it is filled, so a trace written meanwhile never reads it half written.
+*/
+void _traceRecord(const char *name, long start, long duration, int msgid, int code, const char *data) {
+    traceEvent_t *event;
+    uint64_t tag;
+    if ((event = _traceNewEvent()) == NULL) {
+        return;
+    }
+    event->start = start;
+    event->duration = duration;
+    event->name = name;
+    event->msgid = msgid;
+    event->code = code;
+    event->session = TRACE_NO_TAG;
+    event->player = TRACE_NO_TAG;
+    // The lanes of a shared queue have negative ids
+    if (msgid != -1) {
+        tag = __atomic_load_n(&traceTags[(uint32_t) msgid % TRACE_QUEUE_SLOTS], __ATOMIC_RELAXED);
+        if ((int)(tag >> 32) == msgid + 1) {
+            event->session = (tag >> 8) & TRACE_SESSION_MASK;
+            event->session = event->session == TRACE_SESSION_MASK ? TRACE_NO_TAG : event->session;
+            event->player = (int8_t)(tag & 0xFF);
+        }
+    }
+    memset(event->data, 0, TRACE_DATA_SIZE);
+    if (data != NULL) {
+        strncpy(event->data, data, TRACE_DATA_SIZE);
+    }
+    __atomic_store_n(&traceLocal->last->count, traceLocal->last->count + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief Get a free event in the buffer of the calling thread
+ * \return The event, or NULL if the memory is exhausted
+ * \details The buffer of the thread is created and registered on its first event, and grows by chunks.
+*/
+traceEvent_t *_traceNewEvent() {
+    traceChunk_t *chunk;
+    if (traceLocal == NULL) {
+        if ((traceLocal = calloc(1, sizeof(traceBuffer_t))) == NULL) {
+            return NULL;
+        }
+        traceLocal->tid = syscall(SYS_gettid);
+        pthread_mutex_lock(&traceMutex);
+        traceLocal->next = traceBuffers;
+        traceBuffers = traceLocal;
+        pthread_mutex_unlock(&traceMutex);
+    }
+    if (traceLocal->last == NULL || traceLocal->last->count == TRACE_CHUNK_EVENTS) {
+        if ((chunk = calloc(1, sizeof(traceChunk_t))) == NULL) {
+            return NULL;
+        }
+        // The chunk is linked under the mutex, traceWrite may be walking the buffer
+        pthread_mutex_lock(&traceMutex);
+        if (traceLocal->last == NULL) {
+            traceLocal->first = chunk;
+        } else {
+            traceLocal->last->next = chunk;
+        }
+        traceLocal->last = chunk;
+        pthread_mutex_unlock(&traceMutex);
+    }
+    return &traceLocal->last->events[traceLocal->last->count];
+}
+
+/**
+ * \brief Write a JSON string
+ * \param file The trace file
+ * \param string The string, not necessarily terminated
+ * \param size The maximum size of the string
+ * \details The protocol sends some numbers as raw bytes, the bytes that are not printable are escaped.
+*/
+void _traceWriteString(FILE *file, const char *string, size_t size) {
+    fputc('"', file);
+    for (size_t i = 0; i < size && string[i] != '\0'; i++) {
+        if (string[i] == '"' || string[i] == '\\') {
+            fprintf(file, "\\%c", string[i]);
+        } else if (string[i] < ' ' || string[i] > '~') {
+            fprintf(file, "\\u%04x", (unsigned char) string[i]);
+        } else {
+            fputc(string[i], file);
+        }
+    }
+    fputc('"', file);
+}
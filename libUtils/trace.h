@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+#define TRACE_ENV "MASTERMIND_TRACE"
+#define TRACE_CHUNK_EVENTS 1024
+#define TRACE_DATA_SIZE 8
+#define TRACE_QUEUE_SLOTS 32768 // Queue ids are an index below this bound plus a sequence multiple of it
+#define TRACE_NO_TAG -1
+#define TRACE_SESSION_MASK 0xFFFFFF // The session is tagged on 24 bits, the player on 8 bits
+
+/**
+ * \struct      traceEvent
+ * \brief       Represents a message event.
+ * \details     An event with a duration covers a wait, from the send or the start of the receive to the ack. An event without duration is instant.
+*/
+struct traceEvent {
+    long start; /**<The monotonic time of the event, in nanoseconds.*/
+    long duration; /**<The duration in nanoseconds, or -1 for an instant event.*/
+    const char *name; /**<The name of the event, a string literal.*/
+    int msgid; /**<The message queue.*/
+    int code; /**<The validation code of the exchange.*/
+    int session; /**<The session tagged on the queue, or TRACE_NO_TAG.*/
+    int player; /**<The player tagged on the queue, or TRACE_NO_TAG.*/
+    char data[TRACE_DATA_SIZE]; /**<The beginning of the data.*/
+};
+typedef struct traceEvent traceEvent_t;
+
+/**
+ * \struct      traceChunk
+ * \brief       Represents a chunk of the event buffer of a thread.
+*/
+struct traceChunk {
+    traceEvent_t events[TRACE_CHUNK_EVENTS]; /**<The events.*/
+    int count; /**<The number of events of the chunk.*/
+    struct traceChunk *next; /**<The next chunk, in the order of the events.*/
+};
+typedef struct traceChunk traceChunk_t;
+
+/**
+ * \struct      traceBuffer
+ * \brief       Represents the event buffer of a thread.
+ * \details     Only its thread writes to the buffer, so recording an event takes no lock. The buffer is kept once the thread has exited, until the trace is written.
+*/
+struct traceBuffer {
+    long tid; /**<The thread id.*/
+    traceChunk_t *first; /**<The first chunk.*/
+    traceChunk_t *last; /**<The chunk being filled.*/
+    struct traceBuffer *next; /**<The next buffer of the process.*/
+};
+typedef struct traceBuffer traceBuffer_t;
+
+extern int traceEnabled;
+
+void traceInit(const char *processName);
+void traceTagQueue(int msgid, int session, int player);
+long traceClock();
+void traceComplete(const char *name, long start, int msgid, int code, const char *data);
+void traceInstant(const char *name, int msgid, int code, const char *data);
+void traceWrite();
+void _traceRecord(const char *name, long start, long duration, int msgid, int code, const char *data);
+traceEvent_t *_traceNewEvent();
+void _traceWriteString(FILE *file, const char *string, size_t size);
+
+#endif
@@ -0,0 +1,394 @@
+#include "transport.h"
+
+const transport_t transportSysV = {
+    .name = "sysv",
+    .send = _sysvSend,
+    .receive = _sysvReceive,
+    .create = _sysvCreate,
+    .remove = _sysvRemove,
+};
+const transport_t transportLoopback = {
+    .name = "loopback",
+    .send = _loopbackSend,
+    .receive = _loopbackReceive,
+    .create = _loopbackCreate,
+    .remove = _loopbackRemove,
+};
+__thread const transport_t *transport = &transportSysV;
+static __thread int transportIdentity = TRANSPORT_SELF;
+static __thread loopbackQueue_t *loopbackQueues = NULL;
+static transportLane_t transportLanes[TRANSPORT_MAX_LANES];
+static pthread_mutex_t transportLanesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * \brief Choose the transport of the calling thread
+ * \param newTransport The transport, transportSysV or transportLoopback
+ * \details The queues of a transport only make sense to it, a thread switches before creating its queues.
+*/
+void transportUse(const transport_t *newTransport) {
+    transport = newTransport;
+}
+
+/**
+ * \brief Take the identity of a peer
+ * \param identity The PID the calling thread acts as, or TRANSPORT_SELF to act as its process again
+ * \details The ack type and the data type of a message depend on the PID of its sender. A thread playing both the server and the clients on the loopback transport assumes the identity of the side it plays before each exchange.
+*/
+void transportAssume(int identity) {
+    transportIdentity = identity;
+}
+
+/**
+ * \brief Get the identity of the calling thread
+ * \return The identity the thread has assumed, or the PID of its process
+*/
+int transportSelf() {
+    return transportIdentity != TRANSPORT_SELF ? transportIdentity : getpid();
+}
+
+/**
+ * \brief Send a message on a SysV queue
+ * \param msgid The message queue
+ * \param buffer The message
+ * \param flags The msgsnd flags
+ * \return 0 on success, -1 on failure
+ * \details A message on a lane goes to the other side of the lane, a deadline to the side posting it. A message streamed to the owner goes with the streams of the other lanes.
+*/
+int _sysvSend(int msgid, const mbuf_t *buffer, int flags) {
+    transportLane_t lane;
+    mbuf_t message;
+    if (msgid >= -1) {
+        return msgsnd(msgid, buffer, MBUF_SIZE, flags);
+    }
+    if (_transportLane(msgid, &lane) == -1) {
+        return -1;
+    }
+    // A deadline is posted by a process on its own side of the lane
+    message = *buffer;
+    message.mtype = _transportLaneType(&lane, buffer->mtype, buffer->ackType == MTYPE_DEADLINE ? lane.owner : !lane.owner);
+    // A stream is never acknowledged, so its ack type carries the lane it comes from
+    if (!lane.owner && buffer->ackType == MTYPE_NO_ACK) {
+        message.mtype = TRANSPORT_STREAM_TYPE;
+        message.ackType = lane.lane;
+    }
+    return msgsnd(lane.msgid, &message, MBUF_SIZE, flags);
+}
+
+/**
+ * \brief Receive a message from a SysV queue
+ * \param msgid The message queue
+ * \param buffer The buffer where the message will be stored
+ * \param mtype The type of the message, 0 for any
+ * \param flags The msgrcv flags
+ * \return 0 on success, -1 on failure
+ * \details A lane only receives the messages sent to its side, of the given type, the owner gets the streams of its lanes with transportReceiveStream. Once the peer has removed its side, the lane fails with EIDRM like a removed queue, after the messages sent before.
+*/
+int _sysvReceive(int msgid, mbuf_t *buffer, long mtype, int flags) {
+    transportLane_t lane;
+    if (msgid >= -1) {
+        return msgrcv(msgid, buffer, MBUF_SIZE, mtype, flags) == -1 ? -1 : 0;
+    }
+    if (_transportLane(msgid, &lane) == -1) {
+        return -1;
+    }
+    // The messages of the other lanes share the queue, a lane only receives a given type
+    if (mtype <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (msgrcv(lane.msgid, buffer, MBUF_SIZE, _transportLaneType(&lane, mtype, lane.owner), flags) == -1) {
+        return -1;
+    }
+    if (buffer->ackType == MTYPE_HANGUP) {
+        errno = EIDRM;
+        return -1;
+    }
+    buffer->mtype = mtype;
+    return 0;
+}
+
+/**
+ * \brief Create a private SysV queue
+ * \return The id of the queue, -1 on failure
+*/
+int _sysvCreate() {
+    return msgget(IPC_PRIVATE, TRANSPORT_QUEUE_MODE | IPC_CREAT);
+}
+
+/**
+ * \brief Remove a SysV queue
+ * \param msgid The message queue
+ * \return 0 on success, -1 on failure
+ * \details Removing a lane tells its peer, the shared queue itself is removed with the last lane of its owner.
+*/
+int _sysvRemove(int msgid) {
+    transportLane_t *entry;
+    transportLane_t lane;
+    mbuf_t hangup;
+    int last = 1;
+    if (msgid >= -1) {
+        return msgctl(msgid, IPC_RMID, NULL);
+    }
+    pthread_mutex_lock(&transportLanesMutex);
+    if ((entry = _transportLaneEntry(msgid)) == NULL) {
+        pthread_mutex_unlock(&transportLanesMutex);
+        return -1;
+    }
+    // The entry may be reused as soon as it is released
+    lane = *entry;
+    entry->used = 0;
+    for (int i = 0; i < TRANSPORT_MAX_LANES && lane.owner; i++) {
+        if (transportLanes[i].used && transportLanes[i].owner && transportLanes[i].msgid == lane.msgid) {
+            last = 0;
+        }
+    }
+    pthread_mutex_unlock(&transportLanesMutex);
+    if (lane.owner && last) {
+        return msgctl(lane.msgid, IPC_RMID, NULL);
+    }
+    // The peer may be waiting for data or for an ack, it is told on both
+    hangup.ackType = MTYPE_HANGUP;
+    hangup.mtext[0] = '\0';
+    hangup.mtype = _transportLaneType(&lane, MTYPE_DATA, !lane.owner);
+    msgsnd(lane.msgid, &hangup, MBUF_SIZE, IPC_NOWAIT);
+    hangup.mtype = _transportLaneType(&lane, MTYPE_ACK_BASE, !lane.owner);
+    msgsnd(lane.msgid, &hangup, MBUF_SIZE, IPC_NOWAIT);
+    return 0;
+}
+
+/**
+ * \brief Create a SysV queue shared by TRANSPORT_LANES lanes
+ * \param ids Where the ids of the lanes will be stored, TRANSPORT_LANES of them
+ * \return The number of lanes created, -1 on failure
+ * \details The calling process owns the queue: it plays one side of every lane and the queue is removed with its last lane. Each lane is handed to a peer with its index, the peer opens it with transportOpenLane.
+*/
+int transportCreateLanes(int *ids) {
+    int msgid;
+    int nbLanes = 0;
+    if ((msgid = msgget(IPC_PRIVATE, TRANSPORT_QUEUE_MODE | IPC_CREAT)) == -1) {
+        return -1;
+    }
+    pthread_mutex_lock(&transportLanesMutex);
+    for (int i = 0; i < TRANSPORT_MAX_LANES && nbLanes < TRANSPORT_LANES; i++) {
+        if (!transportLanes[i].used) {
+            transportLanes[i] = (transportLane_t) {.msgid = msgid, .lane = nbLanes, .owner = 1, .used = 1};
+            ids[nbLanes++] = TRANSPORT_LANE_ID(i);
+        }
+    }
+    if (nbLanes < TRANSPORT_LANES) {
+        for (int i = 0; i < nbLanes; i++) {
+            transportLanes[-2 - ids[i]].used = 0;
+        }
+    }
+    pthread_mutex_unlock(&transportLanesMutex);
+    if (nbLanes < TRANSPORT_LANES) {
+        msgctl(msgid, IPC_RMID, NULL);
+        errno = ENOSPC;
+        return -1;
+    }
+    return nbLanes;
+}
+
+/**
+ * \brief Open the peer side of a lane
+ * \param msgid The shared queue
+ * \param lane The index of the lane in the queue
+ * \return The id of the lane, -1 with ENOSPC if the process has TRANSPORT_MAX_LANES lanes open already
+*/
+int transportOpenLane(int msgid, int lane) {
+    int id = -1;
+    pthread_mutex_lock(&transportLanesMutex);
+    for (int i = 0; i < TRANSPORT_MAX_LANES && id == -1; i++) {
+        if (!transportLanes[i].used) {
+            transportLanes[i] = (transportLane_t) {.msgid = msgid, .lane = lane, .owner = 0, .used = 1};
+            id = TRANSPORT_LANE_ID(i);
+        }
+    }
+    pthread_mutex_unlock(&transportLanesMutex);
+    if (id == -1) {
+        errno = ENOSPC;
+    }
+    return id;
+}
+
+/**
+ * \brief Find the queue behind an id
+ * \param id The id of a queue or of a lane
+ * \param msgid Where the SysV queue carrying the id will be stored
+ * \return The index of the lane in the queue, -1 if the id is a queue of its own
+*/
+int transportLaneOf(int id, int *msgid) {
+    transportLane_t lane;
+    if (id >= -1 || _transportLane(id, &lane) == -1) {
+        *msgid = id;
+        return -1;
+    }
+    *msgid = lane.msgid;
+    return lane.lane;
+}
+
+/**
+ * \brief Receive the oldest message streamed to the owner of a shared queue
+ * \param msgid The shared queue
+ * \param buffer The buffer where the message will be stored
+ * \param flags The msgrcv flags
+ * \return The index of the lane the message was streamed on, -1 on failure
+ * \details The streams of all the lanes share one type, so they are received in the order they reached the queue, whichever lane they come from.
+*/
+int transportReceiveStream(int msgid, mbuf_t *buffer, int flags) {
+    int lane;
+    if (msgrcv(msgid, buffer, MBUF_SIZE, TRANSPORT_STREAM_TYPE, flags) == -1) {
+        return -1;
+    }
+    lane = buffer->ackType;
+    buffer->mtype = MTYPE_DATA;
+    buffer->ackType = MTYPE_NO_ACK;
+    return lane;
+}
+
+/**
+ * \brief Forget a lane without telling its peer
+ * \param id The id of the lane, a queue of its own is left as is
+ * \details A process which only relayed the lane, or whose peer is gone, frees the entry of the lane.
+*/
+void transportCloseLane(int id) {
+    transportLane_t *lane;
+    pthread_mutex_lock(&transportLanesMutex);
+    if (id < -1 && (lane = _transportLaneEntry(id)) != NULL) {
+        lane->used = 0;
+    }
+    pthread_mutex_unlock(&transportLanesMutex);
+}
+
+/**
+ * \brief Get the lane of an id
+ * \param id The id of the lane
+ * \param lane Where a copy of the lane will be stored
+ * \return 0 on success, -1 with EINVAL if the lane is not open
+ * \details The lane is copied under the lock, so the entry can be released and reused by another thread meanwhile.
+*/
+int _transportLane(int id, transportLane_t *lane) {
+    transportLane_t *entry;
+    pthread_mutex_lock(&transportLanesMutex);
+    if ((entry = _transportLaneEntry(id)) != NULL) {
+        *lane = *entry;
+    }
+    pthread_mutex_unlock(&transportLanesMutex);
+    return entry == NULL ? -1 : 0;
+}
+
+/**
+ * \brief Get the entry of the lane of an id
+ * \param id The id of the lane
+ * \return The entry of the lane, NULL with EINVAL if the lane is not open
+ * \details The caller holds the lock of the lanes.
+*/
+transportLane_t *_transportLaneEntry(int id) {
+    int index = -2 - id;
+    if (index < 0 || index >= TRANSPORT_MAX_LANES || !transportLanes[index].used) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return &transportLanes[index];
+}
+
+/**
+ * \brief Get the type of a message on the shared queue
+ * \param lane The lane
+ * \param mtype The type of the message on the lane
+ * \param toOwner 1 for a message to the owner of the queue, 0 for a message to the peer
+ * \return The type of the message on the shared queue
+ * \details Each lane has four types: the data and the acks, each way. The PID in an ack type is not needed anymore, the peers of a lane are the only ones taking its acks.
+*/
+long _transportLaneType(const transportLane_t *lane, long mtype, int toOwner) {
+    return 1 + lane->lane * 4 + toOwner * 2 + (mtype >= MTYPE_ACK_BASE);
+}
+
+/**
+ * \brief Send a message on a loopback queue
+ * \param msgid The loopback queue
+ * \param buffer The message
+ * \param flags Unused, a loopback queue never blocks
+ * \return 0 on success, -1 with EAGAIN if the queue is full or EINVAL if it does not exist
+ * \details Nobody else could empty the queue of the thread, so a full queue fails instead of blocking forever.
+*/
+int _loopbackSend(int msgid, const mbuf_t *buffer, int flags) {
+    loopbackQueue_t *queue;
+    (void) flags;
+    if (loopbackQueues == NULL || msgid < 0 || msgid >= LOOPBACK_MAX_QUEUES || !loopbackQueues[msgid].used) {
+        errno = EINVAL;
+        return -1;
+    }
+    queue = &loopbackQueues[msgid];
+    if (queue->count == LOOPBACK_QUEUE_SIZE) {
+        errno = EAGAIN;
+        return -1;
+    }
+    queue->messages[queue->count++] = *buffer;
+    return 0;
+}
+
+/**
+ * \brief Receive a message from a loopback queue
+ * \param msgid The loopback queue
+ * \param buffer The buffer where the message will be stored
+ * \param mtype The type of the message, 0 for any
+ * \param flags Unused, a loopback queue never blocks
+ * \return 0 on success, -1 with ENOMSG if no message of the type is waiting or EINVAL if the queue does not exist
+ * \details The oldest message of the type is taken, like msgrcv does.
+*/
+int _loopbackReceive(int msgid, mbuf_t *buffer, long mtype, int flags) {
+    loopbackQueue_t *queue;
+    (void) flags;
+    if (loopbackQueues == NULL || msgid < 0 || msgid >= LOOPBACK_MAX_QUEUES || !loopbackQueues[msgid].used) {
+        errno = EINVAL;
+        return -1;
+    }
+    queue = &loopbackQueues[msgid];
+    for (int i = 0; i < queue->count; i++) {
+        if (mtype == 0 || queue->messages[i].mtype == mtype) {
+            *buffer = queue->messages[i];
+            memmove(&queue->messages[i], &queue->messages[i + 1], (queue->count - i - 1) * sizeof(mbuf_t));
+            queue->count--;
+            return 0;
+        }
+    }
+    errno = ENOMSG;
+    return -1;
+}
+
+/**
+ * \brief Create a loopback queue
+ * \return The id of the queue, -1 with ENOSPC if the thread has LOOPBACK_MAX_QUEUES queues already
+ * \details The ids are the lowest free ones, so a run creating its queues in the same order gets the same ids.
+*/
+int _loopbackCreate() {
+    if (loopbackQueues == NULL && (loopbackQueues = calloc(LOOPBACK_MAX_QUEUES, sizeof(loopbackQueue_t))) == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < LOOPBACK_MAX_QUEUES; i++) {
+        if (!loopbackQueues[i].used) {
+            loopbackQueues[i].used = 1;
+            loopbackQueues[i].count = 0;
+            return i;
+        }
+    }
+    errno = ENOSPC;
+    return -1;
+}
+
+/**
+ * \brief Remove a loopback queue
+ * \param msgid The loopback queue
+ * \return 0 on success, -1 with EINVAL if the queue does not exist
+ * \details The messages left on the queue are dropped.
+*/
+int _loopbackRemove(int msgid) {
+    if (loopbackQueues == NULL || msgid < 0 || msgid >= LOOPBACK_MAX_QUEUES || !loopbackQueues[msgid].used) {
+        errno = EINVAL;
+        return -1;
+    }
+    loopbackQueues[msgid].used = 0;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <pthread.h>
+
+#define MSG_SIZE 24
+#define TRANSPORT_QUEUE_MODE 0766 // The permissions of the private queues of the game, the execute bit of the owner, meaningless for a queue, marks them
+#define MTYPE_DATA 1 // Data received by the server
+#define MTYPE_REPLY 2 // Data received by a client
+#define MTYPE_ACK_BASE 3
+#define MTYPE_DEADLINE 0
+#define MTYPE_NO_ACK -1 // The ackType of a streamed message, which is never acknowledged
+#define MTYPE_HANGUP -2 // The ackType of the message a lane leaves its peer when it is removed
+#define LOOPBACK_MAX_QUEUES 64
+#define LOOPBACK_QUEUE_SIZE 64 // The messages a loopback queue holds, more than a game ever has in flight on one queue
+#define TRANSPORT_SELF 0 // The identity of a thread that has not assumed one, its process
+#define TRANSPORT_LANES 4 // The lanes of a shared queue, one per player of a session
+#define TRANSPORT_MAX_LANES 4096 // The lanes a process has open at once
+#define TRANSPORT_LANE_ID(index) (-2 - (index)) // The id of a lane, negative so it never meets a SysV id nor -1
+#define TRANSPORT_STREAM_TYPE (1 + TRANSPORT_LANES * 4) // The type of the messages streamed to the owner of a shared queue, past the types of the lanes
+
+/**
+ * \struct      mbuf
+ * \brief       Represents a message exchanged on a message queue.
+ * \details     Both peers share the same queue, so the data sent to the server and the data sent to a client have their own mtype, and the sender tells the receiver which mtype to use for the ack. Each process waits on its own ack type and can never consume the ack it sent to its peer. A message whose ackType is MTYPE_DEADLINE is a deadline expiry posted by a timer, its text holds the deadline stamp.
+*/
+struct mbuf {
+    long mtype;
+    long ackType; /**<The mtype the receiver must use to acknowledge this message.*/
+    char mtext[MSG_SIZE];
+}; typedef struct mbuf mbuf_t;
+
+#define MBUF_SIZE (sizeof(mbuf_t) - sizeof(long))
+
+/**
+ * \struct      transport
+ * \brief       Represents the queues the messages are exchanged on.
+ * \details     The operations follow msgsnd, msgrcv, msgget and msgctl: they return -1 and set errno on failure, ENOMSG when no message of the type is waiting and EAGAIN when the queue is full. Each thread uses the transport it has chosen, SysV by default.
+*/
+struct transport {
+    const char *name; /**<The name of the transport.*/
+    int (*send)(int msgid, const mbuf_t *buffer, int flags); /**<Appends a message to a queue, returns 0 on success.*/
+    int (*receive)(int msgid, mbuf_t *buffer, long mtype, int flags); /**<Takes the first message of the type, or of any type for 0, returns 0 on success.*/
+    int (*create)(); /**<Creates a private queue, returns its id.*/
+    int (*remove)(int msgid); /**<Removes a queue, returns 0 on success.*/
+};
+typedef struct transport transport_t;
+
+/**
+ * \struct      loopbackQueue
+ * \brief       Represents a queue of the loopback transport.
+ * \details     The messages are kept in the order they were sent. The loopback queues belong to the thread that created them, so they need no lock and a run replays exactly.
+*/
+struct loopbackQueue {
+    mbuf_t messages[LOOPBACK_QUEUE_SIZE]; /**<The messages, the oldest first.*/
+    int count; /**<The number of messages.*/
+    int used; /**<1 while the queue exists.*/
+};
+typedef struct loopbackQueue loopbackQueue_t;
+
+/**
+ * \struct      transportLane
+ * \brief       Represents a lane of a shared SysV queue.
+ * \details     A shared queue carries the exchanges of TRANSPORT_LANES pairs of peers, its owner and a peer per lane. Each lane has its own mtypes, one per direction and per kind of message, data or ack, so the peers of a lane never take the messages of another lane. The messages the peers stream to the owner are the exception: they share one type, so the owner receives the streams of all the lanes in the order they were sent. A lane is used like a queue, through an id of its own. The lanes of a process are kept in a table under a lock, and the operations on a lane work on a copy of its entry.
+*/
+struct transportLane {
+    int msgid; /**<The shared queue.*/
+    int lane; /**<The index of the lane in the queue.*/
+    int owner; /**<1 on the side of the process which created the queue and removes it with its last lane.*/
+    int used; /**<1 while the lane is open.*/
+};
+typedef struct transportLane transportLane_t;
+
+extern const transport_t transportSysV;
+extern const transport_t transportLoopback;
+extern __thread const transport_t *transport;
+
+void transportUse(const transport_t *newTransport);
+void transportAssume(int identity);
+int transportSelf();
+int _sysvSend(int msgid, const mbuf_t *buffer, int flags);
+int _sysvReceive(int msgid, mbuf_t *buffer, long mtype, int flags);
+int _sysvCreate();
+int _sysvRemove(int msgid);
+int transportCreateLanes(int *ids);
+int transportOpenLane(int msgid, int lane);
+int transportLaneOf(int id, int *msgid);
+int transportReceiveStream(int msgid, mbuf_t *buffer, int flags);
+void transportCloseLane(int id);
+int _transportLane(int id, transportLane_t *lane);
+transportLane_t *_transportLaneEntry(int id);
+long _transportLaneType(const transportLane_t *lane, long mtype, int toOwner);
+int _loopbackSend(int msgid, const mbuf_t *buffer, int flags);
+int _loopbackReceive(int msgid, mbuf_t *buffer, long mtype, int flags);
+int _loopbackCreate();
+int _loopbackRemove(int msgid);
+
+#endif
@@ -1,9 +1,6 @@
 #include "utils.h"
 
 
-extern int serverPID;
-extern int clientPIDs[MAX_PLAYERS];
-
 /**
  * \brief Get user input from stdin
  * \param buffer The buffer where the input will be stored
@@ -36,14 +33,9 @@ void clearBuffer () {
  * \details This function will send the data to the server using the given socket. It will then receive the response code from the server and check if it matches the expected code. If the response code does not match the expected code, an error message will be displayed.
 */
 void sendData(int msgid, char *data, int expectedCode) {
-    mbuf_t buffer;
-    strcpy(buffer.mtext, data);
-    buffer.mtype = 1;
-    int receivedCode;
-    CHECK(msgsnd(msgid, &buffer, sizeof(buffer), 0), "Error: could not send validation code to server");
-    CHECK(msgrcv(msgid, &buffer, sizeof(buffer), 2, 0), "Error: could not receive data from server");
-    sscanf(buffer.mtext, "ok:%d", &receivedCode);
-    CHECK((receivedCode == expectedCode) -1, "Error: code received from server is not the expected one. Bad client-server synchronization");
+    if (sendDataBefore(msgid, data, expectedCode, NO_DEADLINE) == -1) {
+        exit(-1);
+    }
 }
 
 /**
@@ -54,42 +46,384 @@ void sendData(int msgid, char *data, int expectedCode) {
  * \details This function will receive data from the server using the given socket and store it in the data buffer. It will then send the validation code to the server.
 */
 void receiveData(int msgid, char *data, int validationCode) {
+    if (receiveDataBefore(msgid, data, validationCode, NO_DEADLINE) == -1) {
+        exit(-1);
+    }
+}
+
+/**
+ * \brief Send data and check the response code unless a deadline expires
+ * \param msgid The message queue to send the data to
+ * \param data The data to send
+ * \param expectedCode The expected response code
+ * \param deadline The stamp of the deadline armed on the ack type of this process, or NO_DEADLINE
+ * \return 0 on success, -1 if the deadline expired or the exchange failed
+ * \details This function works like sendData but reports failures instead of exiting. Deadline messages carrying another stamp are stale and are discarded.
+*/
+int sendDataBefore(int msgid, char *data, int expectedCode, int deadline) {
+    mbuf_t buffer;
+    long start = traceClock();
+    int status = -1;
+    if (postData(msgid, data) == 0 && _receiveMessage(msgid, &buffer, ACK_TYPE, deadline, 0) == 1) {
+        status = checkAcknowledgement(&buffer, expectedCode);
+    }
+    traceComplete(status == 0 ? "sendData" : "sendDataFailed", start, msgid, expectedCode, data);
+    return status;
+}
+
+/**
+ * \brief Send data without waiting for the response code
+ * \param msgid The message queue to send the data to
+ * \param data The data to send
+ * \return 0 on success, -1 if the queue failed
+ * \details The response code is sent on the ack type of this process, the caller gets it with pollMessage and checks it with checkAcknowledgement.
+*/
+int postData(int msgid, char *data) {
+    mbuf_t buffer;
+    strcpy(buffer.mtext, data);
+    buffer.mtype = PEER_DATA_TYPE;
+    buffer.ackType = ACK_TYPE;
+    if (_sendMessage(msgid, &buffer) == -1) {
+        perror("Error: could not send data");
+        return -1;
+    }
+    traceInstant("post", msgid, -1, data);
+    return 0;
+}
+
+/**
+ * \brief Send data that is never acknowledged
+ * \param msgid The message queue to send the data to
+ * \param data The data to send
+ * \return 0 on success, -1 if the queue failed
+ * \details The streams of the race games are answered by data, not by acks, so their messages carry MTYPE_NO_ACK. The sender must bound the messages in flight so the queue never fills up with the answers.
+*/
+int streamData(int msgid, char *data) {
+    mbuf_t buffer;
+    strcpy(buffer.mtext, data);
+    buffer.mtype = PEER_DATA_TYPE;
+    buffer.ackType = MTYPE_NO_ACK;
+    if (_sendMessage(msgid, &buffer) == -1) {
+        perror("Error: could not stream data");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Encode the new rows of the history of a player
+ * \param data The buffer where the delta is stored, MSG_SIZE bytes
+ * \param revision The number of rows the receiver already has
+ * \param scores The rows following the revision
+ * \param nbRows The number of new rows
+ * \return The number of rows encoded, SYNC_MAX_ROWS at most
+ * \details The delta is the revision on SYNC_REVISION_WIDTH decimal digits followed by the good places and the good colors of each row. The receiver appends the rows if the revision is the number of rows it has, so the rows left out go with the next delta.
+*/
+int syncEncode(char *data, int revision, const score_t *scores, int nbRows) {
+    nbRows = MIN(nbRows, SYNC_MAX_ROWS);
+    sprintf(data, "%0*d", SYNC_REVISION_WIDTH, revision);
+    for (int i = 0; i < nbRows; i++) {
+        data[SYNC_REVISION_WIDTH + i * RESULT_WIDTH] = SCORE_GOOD_PLACE(scores[i]) + '0';
+        data[SYNC_REVISION_WIDTH + i * RESULT_WIDTH + 1] = SCORE_GOOD_COLOR(scores[i]) + '0';
+    }
+    data[SYNC_REVISION_WIDTH + nbRows * RESULT_WIDTH] = '\0';
+    return nbRows;
+}
+
+/**
+ * \brief Check the response code of an ack
+ * \param buffer The ack
+ * \param expectedCode The expected response code
+ * \return 0 if the code is the expected one, -1 otherwise
+*/
+int checkAcknowledgement(mbuf_t *buffer, int expectedCode) {
+    int receivedCode = -1;
+    sscanf(buffer->mtext, "ok:%d", &receivedCode);
+    if (receivedCode != expectedCode) {
+        traceInstant("badAck", -1, expectedCode, buffer->mtext);
+        fprintf(stderr, "Error: code received is not the expected one. Bad client-server synchronization\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Receive a message if one is available
+ * \param msgid The message queue
+ * \param buffer The buffer where the message will be stored
+ * \param mtype The type of the message, DATA_TYPE for data or ACK_TYPE for the acks of this process
+ * \return 1 if a message was received, 0 if none is available, -1 if the queue failed
+ * \details Data received this way is not acknowledged, the caller sends the validation code with acknowledgeData once it knows what the data is.
+*/
+int pollMessage(int msgid, mbuf_t *buffer, long mtype) {
+    return _receiveMessage(msgid, buffer, mtype, NO_DEADLINE, IPC_NOWAIT);
+}
+
+/**
+ * \brief Send the validation code of received data
+ * \param msgid The message queue
+ * \param buffer The received data, overwritten by the ack
+ * \param validationCode The validation code to send back
+ * \return 0 on success, -1 if the queue failed
+*/
+int acknowledgeData(int msgid, mbuf_t *buffer, int validationCode) {
+    traceInstant("ack", msgid, validationCode, buffer->mtext);
+    sprintf(buffer->mtext, "ok:%d", validationCode);
+    buffer->mtype = buffer->ackType;
+    if (_sendMessage(msgid, buffer) == -1) {
+        perror("Error: could not send validation code");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Receive data and send a validation code unless a deadline expires
+ * \param msgid The message queue to receive the data from
+ * \param data The buffer where the received data will be stored
+ * \param validationCode The validation code to send back
+ * \param deadline The stamp of the deadline armed on DATA_TYPE, or NO_DEADLINE
+ * \return 0 on success, -1 if the deadline expired or the exchange failed
+ * \details This function works like receiveData but reports failures instead of exiting. Deadline messages carrying another stamp are stale and are discarded.
+*/
+int receiveDataBefore(int msgid, char *data, int validationCode, int deadline) {
+    return _receiveData(msgid, data, validationCode, deadline, 0) == 1 ? 0 : -1;
+}
+
+/**
+ * \brief Receive data and send a validation code
+ * \param msgid The message queue to receive the data from
+ * \param data The buffer where the received data will be stored
+ * \param validationCode The validation code to send back
+ * \param deadline The stamp of the deadline armed on DATA_TYPE, or NO_DEADLINE
+ * \param flags The msgrcv flags, IPC_NOWAIT to return when no data is available
+ * \return 1 if data was received, 0 if no data is available, -1 if the deadline expired or the exchange failed
+ * \details Inside a coroutine, waiting for the data yields the coroutine instead of blocking the thread.
+*/
+int _receiveData(int msgid, char *data, int validationCode, int deadline, int flags) {
     mbuf_t buffer;
-    CHECK(msgrcv(msgid, &buffer, sizeof(buffer), 1, 0), "Error: could not receive data from server");
+    long start = traceClock();
+    int status = _receiveMessage(msgid, &buffer, DATA_TYPE, deadline, flags);
+    if (status != 1) {
+        if (status == -1) {
+            traceComplete("receiveDataFailed", start, msgid, validationCode, NULL);
+        }
+        return status;
+    }
     strcpy(data, buffer.mtext);
-    sprintf(buffer.mtext, "ok:%d", validationCode);
-    buffer.mtype = 2;
-    CHECK(msgsnd(msgid, &buffer, sizeof(buffer), 0), "Error: could not send validation code to server");
+    if (acknowledgeData(msgid, &buffer, validationCode) == -1) {
+        return -1;
+    }
+    traceComplete("receiveData", start, msgid, validationCode, data);
+    return 1;
+}
+
+/**
+ * \brief Send a message
+ * \param msgid The message queue
+ * \param buffer The message
+ * \return 0 on success, -1 if the queue failed
+ * \details The message goes through the transport of the thread. Inside a coroutine, waiting for room in a full queue yields the coroutine instead of blocking the thread.
+*/
+int _sendMessage(int msgid, mbuf_t *buffer) {
+    int inCoroutine = coroutineCurrent() != NULL;
+    while (transport->send(msgid, buffer, inCoroutine ? IPC_NOWAIT : 0) == -1) {
+        if (!inCoroutine || errno != EAGAIN) {
+            return -1;
+        }
+        coroutineYield();
+    }
+    return 0;
 }
 
-int acceptClient(int msgid) {
-    char buffer[10];
-    int clientPID;
+/**
+ * \brief Receive a message of the given type, skipping stale deadline messages
+ * \param msgid The message queue
+ * \param buffer The buffer where the message will be stored
+ * \param mtype The type of the message to receive
+ * \param deadline The stamp of the deadline to honour, or NO_DEADLINE
+ * \param flags The msgrcv flags, IPC_NOWAIT to return when no message is available
+ * \return 1 if a message was received, 0 if no message is available, -1 if the deadline expired or the queue failed
+ * \details The message comes through the transport of the thread. Inside a coroutine, waiting for the message yields the coroutine instead of blocking the thread. A queue removed before or while waiting, EIDRM or EINVAL, is not reported: the callers stop on it, a listenning thread when its process shuts down and a peer when the other side left.
+*/
+int _receiveMessage(int msgid, mbuf_t *buffer, long mtype, int deadline, int flags) {
+    int yield = coroutineCurrent() != NULL && !(flags & IPC_NOWAIT);
+    int stamp;
+    while (1) {
+        if (transport->receive(msgid, buffer, mtype, yield ? flags | IPC_NOWAIT : flags) == -1) {
+            if (errno == ENOMSG && yield) {
+                coroutineYield();
+                continue;
+            }
+            if (errno == ENOMSG) {
+                return 0;
+            }
+            if (errno != EIDRM && errno != EINVAL) {
+                perror("Error: could not receive data");
+            }
+            return -1;
+        }
+        if (buffer->ackType != MTYPE_DEADLINE) {
+            return 1;
+        }
+        sscanf(buffer->mtext, "%d", &stamp);
+        if (deadline != NO_DEADLINE && stamp == deadline) {
+            traceInstant("deadline", msgid, stamp, NULL);
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+}
+
+/**
+ * \brief Accept a client on the listenning queue
+ * \param msgid The listenning message queue
+ * \param clientPID Where the PID of the accepted client will be stored, 0 for a virtual client
+ * \param clientMsgid The message queue handed to the client, created beforehand by the server
+ * \param flags The msgrcv flags, IPC_NOWAIT to return when no client is connecting
+ * \return 1 if a client was accepted, 0 if no client is connecting, -1 if the request could not be answered
+ * \details This function will receive the request of a connecting client and reply with the server PID and the queue the client will share with the server. The reply goes back on the listenning queue, on the type the request asked for, so the handshake is one round trip. The queue is only handed out if 1 is returned.
+*/
+int acceptClient(int msgid, int *clientPID, int clientMsgid, int flags) {
+    mbuf_t request;
+    int status;
+
+    if ((status = receiveConnection(msgid, &request, clientPID, flags)) != 1) {
+        return status;
+    }
+    if (answerConnection(msgid, &request, getpid(), clientMsgid) == -1) {
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * \brief Receive the request of a connecting client
+ * \param msgid The listenning message queue
+ * \param request Where the request will be stored, to be answered later
+ * \param clientPID Where the PID of the client will be stored, 0 for a virtual client
+ * \param flags The msgrcv flags, IPC_NOWAIT to return when no client is connecting
+ * \return 1 if a request was received, 0 if no client is connecting, -1 if the request is not valid
+ * \details A process handing the client to another server receives the request, gets a queue from that server and answers the request with it.
+*/
+int receiveConnection(int msgid, mbuf_t *request, int *clientPID, int flags) {
+    int status;
+
+    if ((status = _receiveMessage(msgid, request, MTYPE_DATA, NO_DEADLINE, flags)) != 1) {
+        return status;
+    }
+    if (sscanf(request->mtext, "%d", clientPID) != 1 || request->ackType < MTYPE_ACK_BASE) {
+        fprintf(stderr, "Error: bad connection request\n");
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * \brief Answer the request of a connecting client
+ * \param msgid The listenning message queue the request was received on
+ * \param request The request
+ * \param serverPID The PID of the server the client will play with
+ * \param clientMsgid The message queue the client will share with that server, or -1 to refuse the connection
+ * \return 0 on success, -1 on failure
+ * \details A refused client gets a reply it cannot parse, so its connection fails instead of waiting forever. A lane of a shared queue is handed out as the queue and the index of the lane.
+*/
+int answerConnection(int msgid, mbuf_t *request, int serverPID, int clientMsgid) {
+    int sharedMsgid;
+    int lane;
+    request->mtype = request->ackType;
+    request->ackType = MTYPE_DATA;
+    if (clientMsgid == -1) {
+        strcpy(request->mtext, "refused");
+    } else if ((lane = transportLaneOf(clientMsgid, &sharedMsgid)) != -1) {
+        sprintf(request->mtext, "%d:%d:%d", serverPID, sharedMsgid, lane);
+    } else {
+        sprintf(request->mtext, "%d:%d", serverPID, clientMsgid);
+    }
+    if (_sendMessage(msgid, request) == -1) {
+        perror("Error: could not answer the connection request");
+        return -1;
+    }
+    traceInstant("accept", clientMsgid, -1, NULL);
+    return 0;
+}
+
+/**
+ * \brief Connect to the server listenning on the given key
+ * \param serverKey The key of the server listenning queue
+ * \param pid The PID the server signals when it stops the game, 0 for a virtual client which must not be signalled
+ * \param serverPID Where the PID of the server will be stored
+ * \return The message queue shared with the server
+ * \details This function will send the PID to the server and receive the server PID and the queue handed out by the server, in one round trip on a listenning queue. The server may listen on several queues, the request goes to the one picked by the thread so the connections spread over them. Each connection gets its own queue, so one process can open as many connections as it needs. The listenning queues are found by their keys, so the handshake always goes through SysV queues. The process exits if the connection fails.
+*/
+int connectToServer(key_t serverKey, int pid, int *serverPID) {
     int clientMsgid;
-    int i;
-
-    receiveData(msgid, buffer, 0);
-    sscanf(buffer, "%d", &clientPID);
-    for (i = 0; clientPIDs[i] != 0; i++);
-    clientPIDs[i] = clientPID;
-    CHECK(clientMsgid = msgget(ftok("client", clientPID), 0666 | IPC_CREAT), "Error: could not connect to client");
-    sprintf(buffer, "%d", getpid());
-    sendData(clientMsgid, buffer, 0);
+
+    if ((clientMsgid = requestConnection(serverKey, pid, serverPID, 0)) == -1) {
+        fprintf(stderr, "Error: could not connect to server\n");
+        exit(-1);
+    }
     return clientMsgid;
 }
 
-int connectToServer(key_t serverKey) {
-    char buffer[10];
+/**
+ * \brief Request a connection to the server listenning on the given key
+ * \param serverKey The key of the server listenning queue
+ * \param pid The PID the server signals when it stops the game, 0 for a virtual client which must not be signalled
+ * \param serverPID Where the PID of the server will be stored
+ * \param timeout The time in milliseconds to wait for the reply, 0 to wait as long as it takes
+ * \return The message queue shared with the server, -1 if there is no server, the connection was refused or the reply did not come in time
+ * \details The handshake of connectToServer, for a process that must survive a server going away. A lane of a shared queue is opened, and used through its id like a queue.
+*/
+int requestConnection(key_t serverKey, int pid, int *serverPID, int timeout) {
+    long replyType = CONNECT_REPLY_TYPE;
+    long start = traceClock();
+    mbuf_t message;
     int serverMsgid;
     int clientMsgid;
-    CHECK(serverMsgid = msgget(serverKey, 0666), "Error: no server found");
-    sprintf(buffer, "%d", getpid());
-    sendData(serverMsgid, buffer, 0);
-    CHECK(clientMsgid = msgget(ftok("client", getpid()), 0666 | IPC_CREAT), "Error: could not connect to server");
-    receiveData(clientMsgid, buffer, 0);
-    sscanf(buffer, "%d", &serverPID);
-    if (serverPID == getpid()) {
-        msgctl(clientMsgid, IPC_RMID, NULL);
+    int lane;
+    int nbFields;
+    int status;
+
+    if (msgget(serverKey, 0666) == -1
+        || (serverMsgid = msgget(LISTENNING_QUEUE_KEY(serverKey, replyType % countListenningQueues(serverKey)), 0666)) == -1) {
+        return -1;
+    }
+    // A reply left by a dead thread with the same id would answer the wrong request
+    while (pollMessage(serverMsgid, &message, replyType) == 1);
+    message.mtype = MTYPE_DATA;
+    message.ackType = replyType;
+    sprintf(message.mtext, "%d", pid);
+    if (_sendMessage(serverMsgid, &message) == -1) {
+        return -1;
+    }
+    if (timeout == 0) {
+        status = _receiveMessage(serverMsgid, &message, replyType, NO_DEADLINE, 0);
+    } else {
+        for (int waited = 0; (status = pollMessage(serverMsgid, &message, replyType)) == 0 && waited < timeout * 1000; waited += CONNECT_POLL_US) {
+            usleep(CONNECT_POLL_US);
+        }
+    }
+    if (status != 1 || (nbFields = sscanf(message.mtext, "%d:%d:%d", serverPID, &clientMsgid, &lane)) < 2) {
+        return -1;
+    }
+    if (nbFields == 3 && (clientMsgid = transportOpenLane(clientMsgid, lane)) == -1) {
+        return -1;
     }
+    traceComplete("connect", start, clientMsgid, -1, NULL);
     return clientMsgid;
-}
\ No newline at end of file
+}
+
+/**
+ * \brief Count the listenning queues of a server
+ * \param serverKey The key of the first listenning queue of the server
+ * \return The number of listenning queues, 1 if the server only has the first one
+ * \details The queues of a server have consecutive indexes, the count stops at the first index without queue.
+*/
+int countListenningQueues(key_t serverKey) {
+    int nbQueues = 1;
+    while (nbQueues < MAX_LISTENNING_QUEUES && msgget(LISTENNING_QUEUE_KEY(serverKey, nbQueues), 0666) != -1) {
+        nbQueues++;
+    }
+    return nbQueues;
+}
@@ -1,3 +1,6 @@
+#ifndef UTILS_H
+#define UTILS_H
+
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
@@ -5,25 +8,58 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include "serverData.h"
 #include "clientData.h"
+#include "coroutine.h"
+#include "trace.h"
+#include "transport.h"
 
 
 #define CHECK(sts, msg) if ((sts)==-1) {perror(msg); exit(-1);}
 #define PAUSE(msg)	printf("%s [Appuyez sur entrée pour continuer]", msg); getchar();
 
 
-#define MSG_SIZE 10
+#define NO_DEADLINE 0
+#define ACK_TYPE (MTYPE_ACK_BASE + transportSelf())
+#define DATA_TYPE (serverPID == transportSelf() ? MTYPE_DATA : MTYPE_REPLY)
+#define PEER_DATA_TYPE (serverPID == transportSelf() ? MTYPE_REPLY : MTYPE_DATA)
+#define MAX_LISTENNING_QUEUES 16
+#define LISTENNING_QUEUE_STRIDE 0x10000 // Spaces the keys of the listenning queues of a server so they never meet the keys next to its base key
+#define LISTENNING_QUEUE_KEY(key, index) ((key) + (index) * LISTENNING_QUEUE_STRIDE)
+#define ADMIN_QUEUE_KEY(key) LISTENNING_QUEUE_KEY(key, MAX_LISTENNING_QUEUES) // The admin queue of a server, past its listenning queues so the clients never count it
+#define RACE_GUESSES_PER_MESSAGE ((MSG_SIZE - 1) / BOARD_WIDTH) // The guesses streamed in one message of a race game
+#define SUMMARY_ROW_WIDTH (RESULT_WIDTH + 1) // The good places, the good colors and 1 if the player played the round, for each player of a lockstep round summary
+#define SYNC_REVISION_WIDTH 2 // The decimal digits of the revision a history delta starts from
+#define SYNC_MAX_ROWS ((MSG_SIZE - 1 - SYNC_REVISION_WIDTH) / RESULT_WIDTH) // The rows of a history delta, the newer rows go with the next delta
+#define LOBBY_CLASSIC '-' // The mode of a classic game in the announcement of a session, printable so the flag after it is not cut off
+#define LOBBY_MOVE '+' // Follows the mode in the announcement of a session when the player moves to a lane of the queue of the session
+#define CONNECT_POLL_US 1000 // The polling period of a connection waiting for its reply with a timeout
+#define CONNECT_REPLY_TYPE (MTYPE_ACK_BASE + syscall(SYS_gettid)) // The threads of a process connect on the same listenning queue, each waits for its reply on its own type
 
-struct mbuf {
-    long mtype;
-    char mtext[MSG_SIZE];
-}; typedef struct mbuf mbuf_t;
+extern int serverPID;
 
 void getUserInput(char *buffer, size_t size);
 void clearBuffer ();
 
 void sendData(int msgid, char *data, int expectedCode);
 void receiveData(int msgid, char *data, int validationCode);
-int acceptClient(int msgid);
-int connectToServer(key_t serverKey);
\ No newline at end of file
+int sendDataBefore(int msgid, char *data, int expectedCode, int deadline);
+int receiveDataBefore(int msgid, char *data, int validationCode, int deadline);
+int postData(int msgid, char *data);
+int streamData(int msgid, char *data);
+int syncEncode(char *data, int revision, const score_t *scores, int nbRows);
+int checkAcknowledgement(mbuf_t *buffer, int expectedCode);
+int pollMessage(int msgid, mbuf_t *buffer, long mtype);
+int acknowledgeData(int msgid, mbuf_t *buffer, int validationCode);
+int _receiveData(int msgid, char *data, int validationCode, int deadline, int flags);
+int _sendMessage(int msgid, mbuf_t *buffer);
+int _receiveMessage(int msgid, mbuf_t *buffer, long mtype, int deadline, int flags);
+int acceptClient(int msgid, int *clientPID, int clientMsgid, int flags);
+int receiveConnection(int msgid, mbuf_t *request, int *clientPID, int flags);
+int answerConnection(int msgid, mbuf_t *request, int serverPID, int clientMsgid);
+int connectToServer(key_t serverKey, int pid, int *serverPID);
+int requestConnection(key_t serverKey, int pid, int *serverPID, int timeout);
+int countListenningQueues(key_t serverKey);
+
+#endif
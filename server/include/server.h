@@ -2,40 +2,42 @@
  *	\file		server.c
  *	\brief		Defines the main server logic for the game.
  *
- *	\details	This file defines the main server logic for the game, including the main function, the game loop, and the functions for creating the secret code, starting the game, checking the player's choice, ending the game, and handling the client threads.
+ *	\details	This file defines the main server logic for the game, including the main function, the game loop, and the functions for creating the secret code, starting the game and running the players' coroutines. The rules of the turns are in serverGame.c.
  */
 #ifndef SERVER_H
 #define SERVER_H
 
 #include "serverData.h"
 #include "serverCommunication.h"
+#include "serverGame.h"
 #include "serverInit.h"
+#include "serverConfig.h"
+#include "serverTimer.h"
+#include "serverSlab.h"
+#include "serverScheduler.h"
+#include "serverAnalysis.h"
+#include "serverRace.h"
+#include "serverLockstep.h"
+#include "serverBots.h"
+#include "serverAdmin.h"
+#include "serverIpc.h"
 #include <stdlib.h>
 #include <signal.h>
+#include <time.h>
 
 /**
- * \def         MAX(a,b)
- * \brief       Returns the maximum of two values.
+ * \fn          void endSession(gameData_t *gameData)
+ * \brief       Ends a game session.
+ * \param       gameData : The game data structure.
+ * \details     This function is called by the last player coroutine of the session. It ends the game, removes the message queues of the players that are not bots, queues the analysis of the game and gives the game data back to the session slab cache.
  */
-#define MIN(a,b) (((a) < (b)) ? (a) : (b))
-
-/**
- * \struct      clientThreadHandlerArgs
- * \brief       Represents the arguments for the client thread handler.
-*/
-struct clientThreadHandlerArgs
-{
-    gameData_t *gameData; /**<The game data structure.*/
-    int playerIndex; /**<The index of the player.*/
-};
-typedef struct clientThreadHandlerArgs clientThreadHandlerArgs_t;
-
+void endSession(gameData_t *gameData);
 
 /**
  * \fn          void createCombinations(gameData_t *gameData)
  * \brief       Creates the secret code.
  * \param       gameData : The game data structure.
- * \details     This function generates a random secret code and stores it in the gameData's secretCode array.
+ * \details     This function draws a random secret code among the NB_CODES codes and stores it packed in the game data.
  */
 void createCombinations(gameData_t *gameData);
 
@@ -43,40 +45,23 @@ void createCombinations(gameData_t *gameData);
  * \fn          void startGame(gameData_t *gameData)
  * \brief       Starts the game and manages client threads.
  * \param       gameData : The game data structure.
- * \details     This function starts the game by creating a new thread for each player to handle their game session.
+ * \details     This function starts the game by assigning the session to a worker shard, which plays the turns of each player. If no shard can take the session, it is refused: its players are disconnected and the game data is given back to the session slab cache.
  */
 void startGame(gameData_t *gameData);
 
 /**
- * \fn          void checkChoice(gameData_t *gameData, int playerIndex)
- * \brief       Checks the player's choice.
- * \param       gameData : The game data structure.
- * \param       playerIndex : The index of the player.
- * \details     This function checks the player's choice against the secret code and updates the player's result in the game data.
- */
-void checkChoice(gameData_t *gameData, int playerIndex);
-
-/**
- * \fn          void endGame(gameData_t *gameData)
- * \brief       Ends the game.
- * \param       gameData : The game data structure.
- * \details     This function ends the game by determining the winner and sending the result to all players.
- */
-void endGame(gameData_t *gameData);
-
-/**
- * \fn          void *clientThreadHandler(void *args)
- * \brief       Handles the client threads.
- * \param       args : The arguments for the client thread handler.
- * \details     This function handles the player's game session. The player's choice is checked, and the result is sent to the player. The thread ends when the player has reached the maximum number of rounds or when the game has a winner.
+ * \fn          void clientCoroutineHandler(void *args)
+ * \brief       Handles the player coroutines.
+ * \param       args : The turn task of the player.
+ * \details     This function handles the player's game session on the player's coroutine. In a race game, the player's race is played, and in a lockstep game the player's rounds are played in step with the other players. The turns of a bot are played by the bot, or by the round barrier in a lockstep game. Otherwise the player's turns are played one after the other. Waiting for the player yields the coroutine, so the shard plays the other players meanwhile. The coroutine ends when the player has reached the maximum number of rounds, when the game has a winner or when the player has been evicted. The last coroutine of the session ends the game.
  */
-void *clientThreadHandler(void *args);
+void clientCoroutineHandler(void *args);
 
 /**
  *	\fn			void signalHandlerRegister (game_t game)
  *	\brief		Registers the signal handlers.
  *	\param 		game : The game state.
- *	\details		Registers the signal handlers for SIGINT and SIGUSR1.
+ *	\details		Registers the signal handlers for SIGINT and the other exit signals. SIGUSR1, sent by a client leaving its game, is ignored.
  */
 void signalHandlerRegister ();
 
@@ -0,0 +1,74 @@
+/**
+ * \file        serverAdmin.c
+ * \brief       Contains the admin channel of the server.
+ * \details     This file includes the admin queue, a local endpoint separate from the listenning queues, and the thread answering it. The admin tool sends one command per message and the server answers with one line per message, the last one empty. The channel reports the sessions, the clients, the depths of the queues and the latencies measured by the server, and changes the log level, the matchmaking, the deadlines and the number of shards without restarting the server.
+ */
+#ifndef SERVERADMIN_H
+#define SERVERADMIN_H
+
+#include "serverData.h"
+#include "serverStats.h"
+#include "serverConfig.h"
+#include "utils.h"
+#include <pthread.h>
+#include <time.h>
+
+extern int adminMsgid;
+
+/**
+ * \fn          void adminInit()
+ * \brief       Opens the admin channel.
+ * \details     This function creates the admin queue, with the key ADMIN_QUEUE_KEY of the listenning key, and the thread answering it. A queue left by a previous server on the key is reused. The queue is registered, it is removed with the other queues of the server.
+ */
+void adminInit();
+
+/**
+ * \fn          void *_adminThreadHandler(void *args)
+ * \brief       Handles the admin thread.
+ * \param       args : Unused.
+ * \details     This function receives the commands on the admin queue and answers each of them on the type the command asked for. The commands are stats, get, set with a name and a value, and reset, which clears the latencies. An unknown command is answered with an error line.
+ */
+void *_adminThreadHandler(void *args);
+
+/**
+ * \fn          void _adminShowStats(mbuf_t *reply)
+ * \brief       Answers the stats command.
+ * \param       reply : The reply, its type set.
+ * \details     The lines give the sessions being played, the clients connected, the players on the shards, the players waiting for a game, the turn tasks queued on the shards, the messages and the pooled queues of the listenning queues, the queues of the server and of the host, and the count, the mean and the maximum of each latency.
+ */
+void _adminShowStats(mbuf_t *reply);
+
+/**
+ * \fn          void _adminShowConfig(mbuf_t *reply)
+ * \brief       Answers the get command.
+ * \param       reply : The reply, its type set.
+ * \details     The lines give the value of each setting the set command changes.
+ */
+void _adminShowConfig(mbuf_t *reply);
+
+/**
+ * \fn          int _adminSet(const char *name, int value)
+ * \brief       Changes a setting.
+ * \param       name : The name of the setting: loglevel, size, wait, lobby, turn or shards.
+ * \param       value : The new value, in the range of the matching command line option.
+ * \details     A new matchmaking size or wait wakes the matchmaker, the deadlines apply from the next one armed and the shards from the next session. Returns 0, or -1 if the name or the value is not valid.
+ */
+int _adminSet(const char *name, int value);
+
+/**
+ * \fn          void _adminClear(adminLatency_t *latency)
+ * \brief       Clears a latency.
+ * \param       latency : The latency.
+ * \details     Each field is cleared with an atomic store, the shards recording their measures meanwhile.
+ */
+void _adminClear(adminLatency_t *latency);
+
+/**
+ * \fn          void _adminReply(mbuf_t *reply, const char *format, ...)
+ * \brief       Sends a line of a reply.
+ * \param       reply : The reply, its type set.
+ * \param       format : The format of the line, which must fit in a message.
+ */
+void _adminReply(mbuf_t *reply, const char *format, ...);
+
+#endif
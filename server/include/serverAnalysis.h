@@ -0,0 +1,138 @@
+/**
+ * \file        serverAnalysis.c
+ * \brief       Contains the post-game analysis of the server.
+ * \details     This file includes the analysts replaying the finished games. Each player of a finished session becomes a job queued for a pool of low priority threads, which replays the player's guesses against the candidates left by the previous rounds and compares each guess with the minimax-optimal one, using the feedback table. The sessions never wait for the analysts: a job that does not fit in the queue is dropped and counted.
+ */
+#ifndef SERVERANALYSIS_H
+#define SERVERANALYSIS_H
+
+#include "serverData.h"
+#include "serverSlab.h"
+#include <pthread.h>
+
+#define MAX_ANALYSTS 16
+#define ANALYSTS 1
+#define ANALYSIS_QUEUE_SIZE 1024
+#define ANALYSIS_NICE 10
+
+/**
+ * \struct      analysisJob
+ * \brief       Represents the game of a player to analyse.
+*/
+struct analysisJob {
+    int sessionId; /**<The session of the game.*/
+    int playerIndex; /**<The index of the player.*/
+    int nbRound; /**<The number of rounds played by the player.*/
+    code_t secretCode; /**<The secret code.*/
+    code_t guesses[MAX_ROUND]; /**<The guesses of the player.*/
+    score_t scores[MAX_ROUND]; /**<The scores of the guesses.*/
+};
+typedef struct analysisJob analysisJob_t;
+
+/**
+ * \struct      analysisGuess
+ * \brief       Represents the analysis of a guess.
+ * \details     A guess splits the candidates left by its score. The worst case of a guess is its largest part, the minimax-optimal guess has the smallest worst case.
+*/
+struct analysisGuess {
+    int remaining; /**<The number of candidates consistent with the score of the guess.*/
+    int worstCase; /**<The worst case of the guess.*/
+    int optimalWorstCase; /**<The worst case of the minimax-optimal guess.*/
+};
+typedef struct analysisGuess analysisGuess_t;
+
+/**
+ * \struct      analysis
+ * \brief       Represents the analysts and their statistics.
+ * \details     The job queue is a circular buffer. The statistics are summed over the analysed players.
+*/
+struct analysis {
+    pthread_t threads[MAX_ANALYSTS]; /**<The analyst threads.*/
+    int nbThreads; /**<The number of analyst threads, 0 if the analysis is disabled.*/
+    pthread_mutex_t mutex; /**<Protects the job queue.*/
+    pthread_cond_t cond; /**<Signals a queued job.*/
+    analysisJob_t *jobs[ANALYSIS_QUEUE_SIZE]; /**<The job queue.*/
+    int head; /**<The index of the first job.*/
+    int count; /**<The number of jobs in the queue.*/
+    int openingWorstCase; /**<The worst case of the minimax-optimal first guess, the same for every game.*/
+    long players; /**<The number of players analysed.*/
+    long dropped; /**<The number of players not analysed because the queue was full.*/
+    long guesses; /**<The number of guesses analysed.*/
+    long worstCases; /**<The sum of the worst cases of the guesses.*/
+    long optimalWorstCases; /**<The sum of the worst cases of the minimax-optimal guesses.*/
+    long remaining; /**<The sum of the candidates left by the guesses.*/
+};
+typedef struct analysis analysis_t;
+
+extern slabCache_t analysisCache;
+
+/**
+ * \fn          void analysisInit(int nbThreads)
+ * \brief       Starts the analysts.
+ * \param       nbThreads : The number of analyst threads, 0 to disable the analysis.
+ * \details     This function fills the feedback table, computes the worst case of the optimal first guess and creates the analyst threads.
+ */
+void analysisInit(int nbThreads);
+
+/**
+ * \fn          void analysisSubmitSession(gameData_t *gameData)
+ * \brief       Queues the analysis of a finished session.
+ * \param       gameData : The game data structure.
+ * \details     This function copies the guesses and the scores of each player of the session into a job and queues it without waiting. The jobs that do not fit in the queue are dropped. It does nothing if the analysis is disabled.
+ */
+void analysisSubmitSession(gameData_t *gameData);
+
+/**
+ * \fn          void analysisShowStats()
+ * \brief       Displays the analysis statistics.
+ * \details     This function prints the number of players analysed and dropped, the mean number of candidates left by a guess, and the efficiency of the guesses: the sum of the worst cases of the optimal guesses over the sum of the worst cases of the guesses played, 1 if every guess was optimal.
+ */
+void analysisShowStats();
+
+/**
+ * \fn          void *_analystThreadHandler(void *args)
+ * \brief       Handles an analyst thread.
+ * \param       args : Unused.
+ * \details     This function lowers the priority of the thread so the analysis never competes with the shards, then analyses the jobs as they are queued.
+ */
+void *_analystThreadHandler(void *args);
+
+/**
+ * \fn          void _analysePlayer(analysisJob_t *job)
+ * \brief       Analyses the game of a player.
+ * \param       job : The game of the player.
+ * \details     This function replays the guesses of the player. Before each guess, the candidates are the codes consistent with the scores of the previous guesses. The candidates left by each guess and the efficiency of the player are logged and added to the statistics.
+ */
+void _analysePlayer(analysisJob_t *job);
+
+/**
+ * \fn          void _analyseGuess(code_t *candidates, int nbCandidates, code_t guess, score_t score, analysisGuess_t *result)
+ * \brief       Analyses a guess.
+ * \param       candidates : The candidates before the guess, narrowed down to the candidates consistent with the score of the guess.
+ * \param       nbCandidates : The number of candidates.
+ * \param       guess : The guess.
+ * \param       score : The score of the guess.
+ * \param       result : The analysis of the guess.
+ */
+void _analyseGuess(code_t *candidates, int nbCandidates, code_t guess, score_t score, analysisGuess_t *result);
+
+/**
+ * \fn          int _worstCase(code_t *candidates, int nbCandidates, code_t guess)
+ * \brief       Computes the worst case of a guess.
+ * \param       candidates : The candidates.
+ * \param       nbCandidates : The number of candidates.
+ * \param       guess : The guess.
+ * \details     This function splits the candidates by their score against the guess and returns the size of the largest part.
+ */
+int _worstCase(code_t *candidates, int nbCandidates, code_t guess);
+
+/**
+ * \fn          int _optimalWorstCase(code_t *candidates, int nbCandidates)
+ * \brief       Computes the worst case of the minimax-optimal guess.
+ * \param       candidates : The candidates.
+ * \param       nbCandidates : The number of candidates.
+ * \details     This function tries every code as a guess, candidate or not, and returns the smallest worst case. A search stops as soon as its worst case reaches the best one found.
+ */
+int _optimalWorstCase(code_t *candidates, int nbCandidates);
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * \file        serverBots.c
+ * \brief       Contains the bots played by the server.
+ * \details     This file includes the bot players filling the sessions formed with fewer players than wanted. A bot is a player slot without a queue nor a process: its turns are played by its coroutine on the session's shard, like the turns of the other players, and its guesses never leave the server. A bot plays the opening book if one is given, then the minimax guess of the solver over the codes consistent with all its scores. A bot never plays ahead of the players, it waits for every connected player to have played the round before playing it.
+ */
+#ifndef SERVERBOTS_H
+#define SERVERBOTS_H
+
+#include "serverData.h"
+#include "serverConfig.h"
+#include "book.h"
+#include "solver.h"
+#include "utils.h"
+
+extern book_t botsBook;
+extern solver_t botsSolver;
+extern long botSeats;
+extern long botWins;
+
+/**
+ * \fn          void botsInit()
+ * \brief       Prepares the bots.
+ * \details     This function starts the solver of the bots with the workers of the configuration and maps the opening book of the configuration, if any. The bots play without the book if it cannot be opened, and search their guesses on their shards if the workers cannot be started. It does nothing if the sessions are not filled with bots.
+ */
+void botsInit();
+
+/**
+ * \fn          void botsFillSession(playerList_t *playerList)
+ * \brief       Fills a session with bots.
+ * \param       playerList : The players of the session formed by the matchmaking.
+ * \details     This function appends bots to the player list until it has the number of players of the configuration. Race games are not filled, a bot would find the code before the first guesses of the players are read.
+ */
+void botsFillSession(playerList_t *playerList);
+
+/**
+ * \fn          void botPlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the turns of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function plays the rounds of the bot until the game has a winner or the bot has played the maximum number of rounds. Each guess is scored like the guesses of the other players.
+ */
+void botPlayer(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          void botsSubmitRound(gameData_t *gameData)
+ * \brief       Submits the guesses of the bots for the next round of a lockstep game.
+ * \param       gameData : The game data structure.
+ * \details     This function chooses the next guess of each connected bot and marks it submitted, so the bots play the round being scored. In a lockstep game the bots have no turns of their own.
+ */
+void botsSubmitRound(gameData_t *gameData);
+
+/**
+ * \fn          int _botWaitRound(gameData_t *gameData, int playerIndex)
+ * \brief       Waits for the players to play the next round of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function yields the coroutine until every connected player that is not a bot has played more rounds than the bot. It returns 0 when the bot can play and -1 if the game has a winner.
+ */
+int _botWaitRound(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          code_t _botGuess(gameData_t *gameData, int playerIndex)
+ * \brief       Chooses the next guess of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function returns the guess of the opening book while the game stays in the book. Otherwise it returns the minimax guess over the codes consistent with every score of the bot, its ties broken from a code drawn for the session and the bot, so the bots of a session do not play the same guesses.
+ */
+code_t _botGuess(gameData_t *gameData, int playerIndex);
+
+#endif
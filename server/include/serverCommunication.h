@@ -8,75 +8,207 @@
 
 #include "serverData.h"
 #include "utils.h"
+#include "serverMatchmaking.h"
+#include "serverConfig.h"
+#include "serverBots.h"
+#include "serverTimer.h"
+#include "serverSlab.h"
+#include "serverStats.h"
+#include "serverIpc.h"
+#include <signal.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
 #include <string.h>
+#include <time.h>
 
+#define BROADCAST_MAX_MESSAGES 2
+#define BROADCAST_POLL_US 500
+#define QUEUE_POOL_SIZE 32
 
-/**
- * \struct      listenningThreadHandlerArgs
- * \brief       Represents the arguments for the listenning thread handler.
-*/
-struct listenningThreadHandlerArgs {
-    gameData_t *gameData; /**<The game data structure.*/
-    pthread_t *threadClients; /**<The client threads.*/
-    int *gameStarted; /**<The game started flag.*/
-};
-typedef struct listenningThreadHandlerArgs listenningThreadHandlerArgs_t;
+extern int clientPIDs[MAX_CLIENTS];
 
 /**
  * \struct      clientReadyThreadHandlerArgs
  * \brief       Represents the arguments for the client ready thread handler.
 */
 struct clientReadyThreadHandlerArgs {
-    gameData_t *gameData; /**<The game data structure.*/
-    int playerIndex; /**<The index of the player.*/
+    int msgid; /**<The client's message queue id.*/
+    int pid; /**<The PID of the client process.*/
 };
 typedef struct clientReadyThreadHandlerArgs clientReadyThreadHandlerArgs_t;
 
+/**
+ * \struct      listenner
+ * \brief       Represents a listenning queue and the client queues it hands out.
+ * \details     The client queues are created in advance while the listenning thread is idle, so accepting a client creates no queue.
+*/
+struct listenner {
+    int msgid; /**<The listenning queue.*/
+    int pool[QUEUE_POOL_SIZE]; /**<The client queues created in advance.*/
+    int nbPooled; /**<The number of queues in the pool.*/
+};
+typedef struct listenner listenner_t;
+
+extern listenner_t listenners[MAX_LISTENNING_QUEUES];
+
+/**
+ * \struct      broadcast
+ * \brief       Represents messages sent to all the players of a session at once.
+ * \details     Each player gets nbMessages messages, in order. Message j of every player expects the code expectedCodes[j].
+*/
+struct broadcast {
+    char data[MAX_PLAYERS][BROADCAST_MAX_MESSAGES][MSG_SIZE]; /**<The messages of each player.*/
+    int expectedCodes[BROADCAST_MAX_MESSAGES]; /**<The code expected for each message.*/
+    int nbMessages; /**<The number of messages of each player.*/
+    int nbAcks[MAX_PLAYERS]; /**<The number of messages each player has acknowledged.*/
+};
+typedef struct broadcast broadcast_t;
+
+/**
+ * \fn          void startListenning()
+ * \brief       Starts accepting clients.
+ * \details     This function creates the listenning queues and one listenning thread per queue, so a burst of connections is accepted in parallel. The queues left by a previous server beyond the configured number are removed, the clients would count them. Clients are accepted for the whole life of the server, whether games are running or not.
+ */
+void startListenning();
+
 /**
  * \fn          void clientRegistration(gameData_t *gameData)
  * \brief       Handles client registration.
  * \param       gameData : The game data structure.
- * \details     This function waits for players to connect and creates a new thread for each player. It also sends the number of players and their respective IDs to each player.
+ * \details     This function waits for the matchmaking queue to form the next session and moves its players into the game data, filling the session with bots if the configuration asks for it. The session is then announced to its players.
  */
 void clientRegistration(gameData_t *gameData);
 
 /**
- * \fn          void getPlayerChoice(gameData_t *gameData, int playerIndex)
+ * \fn          void announceSession(gameData_t *gameData)
+ * \brief       Announces a session to its players.
+ * \param       gameData : The game data structure, its players set.
+ * \details     This function sends the number of players, followed by the mode of the game, and their respective IDs to each player that is not a bot. When the players are multiplexed, a shared queue is created for the session and each player is moved to its lane before getting its ID, so the whole session plays on one queue. If the shared queue cannot be created, the players keep their own queues.
+ */
+void announceSession(gameData_t *gameData);
+
+/**
+ * \fn          int receiveReady(int msgid, int pid)
+ * \brief       Waits for a client to be ready.
+ * \param       msgid : The client's message queue id.
+ * \param       pid : The PID of the client process.
+ * \details     This function receives the messages of the client until it sends "ready". The client is disconnected if it is not ready before the lobby deadline, or if no timer is left to arm the deadline. It returns 0 if the client is ready and -1 if it was disconnected.
+ */
+int receiveReady(int msgid, int pid);
+
+/**
+ * \fn          int sendPlayerData(player_t *player, char *data, int expectedCode)
+ * \brief       Sends data to a player before the turn deadline.
+ * \param       player : The player.
+ * \param       data : The data to send.
+ * \param       expectedCode : The expected response code from the player.
+ * \details     This function sends the data and waits for the player's ack until the turn deadline. The player is evicted if the deadline expires, if no timer is left to arm it or if the exchange fails. The round trip of an exchange that succeeds is recorded. It returns 0 on success and -1 if the player is not connected anymore.
+ */
+int sendPlayerData(player_t *player, char *data, int expectedCode);
+
+/**
+ * \fn          int broadcastPlayerData(playerList_t *playerList, broadcast_t *broadcast, int timeout)
+ * \brief       Sends messages to all the players at once.
+ * \param       playerList : The players.
+ * \param       broadcast : The messages of each player and the codes expected for them.
+ * \param       timeout : The time in seconds the players have to acknowledge all their messages, 0 for no timeout.
+ * \details     This function posts all the messages of all the connected players without waiting, then collects the acks of every player as they come, until every player has acknowledged all its messages or the timeout expires. A slow player does not delay the others. The players that fail an ack or miss the timeout are evicted. The bots are skipped. Waiting for the acks yields the coroutine, or sleeps BROADCAST_POLL_US outside of a coroutine. It returns the number of players that acknowledged all their messages.
+ */
+int broadcastPlayerData(playerList_t *playerList, broadcast_t *broadcast, int timeout);
+
+/**
+ * \fn          void evictPlayer(player_t *player)
+ * \brief       Evicts a player from its game.
+ * \param       player : The player.
+ * \details     This function marks the player as disconnected and disconnects its client. The other players of the game go on playing.
+ */
+void evictPlayer(player_t *player);
+
+/**
+ * \fn          void disconnectClient(int msgid, int pid)
+ * \brief       Disconnects a client.
+ * \param       msgid : The client's message queue id.
+ * \param       pid : The PID of the client process.
+ * \details     This function tells the client the game is stopped, unregisters it and removes its message queue, so a stuck or crashed client does not keep any server resource. A virtual client, with the PID 0, is not signalled and notices the removal of its queue.
+ */
+void disconnectClient(int msgid, int pid);
+
+/**
+ * \fn          void registerClient(int pid)
+ * \brief       Registers a connected client.
+ * \param       pid : The PID of the client process.
+ * \details     This function stores the client PID so the client can be stopped when the server exits. Virtual clients, connected with the PID 0, are not registered.
+ */
+void registerClient(int pid);
+
+/**
+ * \fn          void unregisterClient(int pid)
+ * \brief       Unregisters a client.
+ * \param       pid : The PID of the client process.
+ * \details     This function removes the client PID once its game session has ended.
+ */
+void unregisterClient(int pid);
+
+/**
+ * \fn          int getPlayerChoice(gameData_t *gameData, int playerIndex)
  * \brief       Receives the player's choice.
  * \param       gameData : The game data structure.
  * \param       playerIndex : The index of the player in the player list.
- * \details     This function waits for a specific player to send their choice and then updates the player's board with their choice.
+ * \details     This function waits for a specific player to send their choice before the turn deadline and then stores their choice as a packed guess. Called from the player's coroutine, the wait yields the coroutine. The wait is interrupted when another player wins. It returns 0 if the choice was received and -1 if the game has a winner or if the player missed the turn deadline, could not be given one or sent an invalid combination and was evicted.
+ */
+int getPlayerChoice(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          void interruptPlayers(gameData_t *gameData)
+ * \brief       Interrupts the players waiting for their choice.
+ * \param       gameData : The game data structure.
+ * \details     This function is called once the game has a winner. The turn deadline of each player waiting for their choice expires right away, so their turns end and the end of the game reaches every player without waiting for their next guess. Players waiting without a turn deadline are not interrupted.
  */
-void getPlayerChoice(gameData_t *gameData, int playerIndex);
+void interruptPlayers(gameData_t *gameData);
 
 /**
- * \fn          void sendResult(gameData_t *gameData, int playerIndex)
+ * \fn          int sendResult(gameData_t *gameData, int playerIndex)
  * \brief       Sends the result to the player.
  * \param       gameData : The game data structure.
  * \param       playerIndex : The index of the player in the player list.
- * \details     This function sends the result of the current round to the player and also sends the results of other players to the player.
+ * \details     This function sends the result of the current round to the player, then a delta of the history of each other player: the rows the player has not acknowledged yet. The ack of a delta acknowledges its rows, so the next delta starts after them and a player who is up to date costs a few bytes. It returns -1 if the player was evicted.
  */
-void sendResult(gameData_t *gameData, int playerIndex);
+int sendResult(gameData_t *gameData, int playerIndex);
 
 /**
  * \fn          void *_listenningThreadHandler(void *args)
  * \brief       Handles the listening thread.
- * \param       args : The arguments for the thread.
- * \details     This function listens for players to connect until the maximum number of players is reached or the game has started. It creates a new thread for each connected player.
+ * \param       args : The index of the listenning queue of the thread.
+ * \details     This function accepts the players connecting on its listenning queue, handing each of them a queue of the pool. While no player is connecting, the pool is filled up, and a queue is only created on demand when a burst has emptied it. It creates a new thread for each connected player waiting for the player to be ready.
  */
 void *_listenningThreadHandler(void *args);
 
+/**
+ * \fn          void _listennerFill(listenner_t *listenner)
+ * \brief       Adds a client queue to the pool of a listenning queue.
+ * \param       listenner : The listenning queue.
+ * \details     This function creates a client queue and registers it. The players keep their own queue in the lobby even when they are multiplexed, they only move to the shared queue of their session once it is formed.
+ */
+void _listennerFill(listenner_t *listenner);
+
 /**
  * \fn          void *_clientReadyThreadHandler(void *args)
  * \brief       Handles the client ready thread.
  * \param       args : The arguments for the thread.
- * \details     This function waits for a specific player to be ready. Once the player is ready, it updates the player's ready status in the game data.
+ * \details     This function waits for a specific player to be ready. Once the player is ready, it is added to the matchmaking queue.
  */
 void *_clientReadyThreadHandler(void *args);
 
+/**
+ * \fn          int _playerMove(player_t *player, int lane)
+ * \brief       Moves a player to a lane of the shared queue of its session.
+ * \param       player : The player.
+ * \param       lane : The lane.
+ * \details     This function sends the shared queue and the index of the lane to the player on its own queue. Once the player has acknowledged them, it plays on the lane and its own queue is removed. It returns 0 on success and -1 if the player is not connected anymore.
+ */
+int _playerMove(player_t *player, int lane);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,53 @@
+/**
+ * \file        serverConfig.c
+ * \brief       Contains the server runtime configuration.
+ * \details     This file includes the configuration structure shared by the server modules and the function parsing the command line arguments into it.
+ */
+#ifndef SERVERCONFIG_H
+#define SERVERCONFIG_H
+
+#include "serverData.h"
+#include <sys/types.h>
+
+/**
+ * \struct      serverConfig
+ * \brief       Represents the server runtime configuration.
+*/
+struct serverConfig {
+    int matchmakingTargetSize; /**<The number of ready players that immediately forms a session.*/
+    int matchmakingMaxWait; /**<The maximum time in seconds a ready player waits before a smaller session is formed.*/
+    int lobbyDeadline; /**<The time in seconds a connected player has to be ready, 0 for no deadline.*/
+    int turnDeadline; /**<The time in seconds a player has to play a turn or acknowledge a message, 0 for no deadline.*/
+    int nbShards; /**<The number of worker shards playing the turns.*/
+    int nbListenners; /**<The number of listenning queues, each with its accepting thread.*/
+    key_t listenningKey; /**<The key of the first listenning queue, another key lets several servers run on the host.*/
+    int race; /**<1 if the games are races, the players streaming their guesses.*/
+    int lockstep; /**<1 if the rounds are simultaneous, each scored once every player has played it.*/
+    int nbAnalysts; /**<The number of threads analysing the finished games, 0 to disable the analysis.*/
+    int botsFillSize; /**<The number of players the sessions are filled up to with bots, 0 to disable the bots.*/
+    const char *botsBookPath; /**<The opening book of the bots, or NULL.*/
+    int botsSolverWorkers; /**<The number of threads helping the bots search their guesses, 0 for the bots to search alone on their shards.*/
+    int multiplex; /**<1 if the players of a session share one queue, each on a lane of its own.*/
+};
+typedef struct serverConfig serverConfig_t;
+
+extern serverConfig_t serverConfig;
+
+/**
+ * \fn          void parseArguments(int argc, char *argv[])
+ * \brief       Parses the server command line arguments.
+ * \param       argc : The number of arguments.
+ * \param       argv : The arguments.
+ * \details     This function fills the server configuration with the default values and overrides them with the command line options. -s sets the matchmaking target size, -w the matchmaking maximum wait, -l the lobby deadline and -t the turn deadline, all in seconds. -j sets the number of worker shards, one per online core by default, -q the number of listenning queues, -K their key, and -a the number of analysts. -r makes the games races and -k makes the rounds simultaneous, the two modes excluding each other. -f sets the number of players the sessions are filled up to with bots, -b their opening book and -m the number of workers of their solver. -x multiplexes the players of each session over one shared queue.
+ */
+void parseArguments(int argc, char *argv[]);
+
+/**
+ * \fn          void _configUsage(char *name)
+ * \brief       Displays the server usage.
+ * \param       name : The name of the executable.
+ * \details     This function prints the available command line options and exits the server.
+ */
+void _configUsage(char *name);
+
+#endif
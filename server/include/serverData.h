@@ -2,11 +2,15 @@
 #define SERVERDATA_H
 
 #include <stdio.h>
+#include <pthread.h>
+#include "code.h"
+#include "transport.h"
 
 #define MAX_ROUND 12
 #define BOARD_WIDTH 4
 #define RESULT_WIDTH 2
 #define MAX_PLAYERS 4
+#define MAX_CLIENTS 256
 #define EMPTY -1
 #define EMPTY_SCORE -2
 #define RED 'R'
@@ -18,34 +22,57 @@
 
 #define SERVER_LISTENNING_KEY 58392
 
-#define LOG_LEVEL 2
+#define MATCHMAKING_TARGET_SIZE MAX_PLAYERS
+#define MATCHMAKING_MAX_WAIT 10
+#define LOBBY_DEADLINE 300
+#define TURN_DEADLINE 120
+#define LISTENNING_QUEUES 4
+#define RACE_BATCH 64 // The scores of a player waiting to be streamed back in a race game
+#define RACE_FAILED -1 // The replies of a race player who sent an invalid combination
+
+#define LOG_LEVEL 2 // The log level the server starts with
+extern int logLevel;
 /**
  * \def         LOG(level, fmt, ...)
  * \brief       Logs a message to the console with a specific level.
+ * \details     The messages above the current log level are dropped, the level can be changed while the server runs.
 */
-#define LOG(level, fmt, ...) if (level <= LOG_LEVEL) fprintf(stdout, fmt, ##__VA_ARGS__)
+#define LOG(level, fmt, ...) if (level <= __atomic_load_n(&logLevel, __ATOMIC_RELAXED)) fprintf(stdout, fmt, ##__VA_ARGS__)
+
+/**
+ * \def         MAX(a,b)
+ * \brief       Returns the maximum of two values.
+ */
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
 /**
  * \struct      player
- * \brief       Represents a player.
+ * \brief       Represents the connection of a player.
 */
 struct player
 {
-    char board[MAX_ROUND][BOARD_WIDTH]; /**<The player's board.*/
-    char result[MAX_ROUND][RESULT_WIDTH]; /**<The player's result.*/
-    int nbRound; /**<The number of rounds played by the player.*/
     int ready; /**<The player's ready status.*/
     int msgid; /**<The player's message queue id.*/
+    int pid; /**<The PID of the player's client process.*/
+    int deadline; /**<The stamp of the turn deadline while the server waits for the player's choice, or 0.*/
+    int connected; /**<The player's connection status, 0 once evicted.*/
+    int bot; /**<1 if the player is a bot played by the server, without a queue nor a process.*/
 };
 typedef struct player player_t;
 
 /**
  * \struct      playerList
  * \brief       Represents a list of players.
+ * \details     The game state of the players is stored as arrays indexed by player, the hot fields first, so a sweep over the players of a session reads a few bytes per player. The guesses are packed codes and the scores packed bytes. Only the rounds below the player's number of rounds are valid.
 */
 struct playerList
 {
-    player_t players[MAX_PLAYERS]; /**<The list of players.*/
+    uint8_t nbRound[MAX_PLAYERS]; /**<The number of rounds played by each player.*/
+    code_t guesses[MAX_PLAYERS][MAX_ROUND]; /**<The guesses of each player.*/
+    score_t scores[MAX_PLAYERS][MAX_ROUND]; /**<The scores of each player.*/
+    uint8_t synced[MAX_PLAYERS][MAX_PLAYERS]; /**<The rows of the history of each player each player has acknowledged, written by the coroutine of the receiver.*/
+    player_t players[MAX_PLAYERS]; /**<The connections of the players.*/
     int nbPlayers; /**<The number of players in the list.*/
 };
 typedef struct playerList playerList_t;
@@ -56,8 +83,20 @@ typedef struct playerList playerList_t;
 */
 struct gameData {
     playerList_t playerList; /**<The list of players.*/
-    char secretCode[BOARD_WIDTH]; /**<The secret code.*/
+    code_t secretCode; /**<The secret code.*/
     int gameWinner; /**<The winner of the game.*/
+    int sessionId; /**<The identifier of the game session.*/
+    int activePlayers; /**<The number of players whose turns are still scheduled.*/
+    int sharedMsgid; /**<The queue shared by the players when they are multiplexed, player i on its lane i, -1 otherwise.*/
+    long nbScored; /**<The number of guesses scored in a race game.*/
+    uint8_t nbSubmitted[MAX_PLAYERS]; /**<The number of guesses each player has submitted in a lockstep game.*/
+    int roundsClaimed; /**<The number of rounds a coroutine has started scoring in a lockstep game.*/
+    int roundsScored; /**<The number of rounds scored and broadcast in a lockstep game.*/
+    int raceReceiving; /**<1 while a coroutine of the session receives the guesses of a race game.*/
+    int raceFirst; /**<The player the next reception of a race game starts with, when the players have their own queues.*/
+    int raceNbReplies[MAX_PLAYERS]; /**<The number of scores waiting to be streamed back to each player in a race game, or RACE_FAILED.*/
+    char raceReplies[MAX_PLAYERS][RACE_BATCH][MSG_SIZE]; /**<The scores waiting to be streamed back to each player in a race game.*/
+    pthread_mutex_t mutex; /**<Protects the game winner.*/
 };
 typedef struct gameData gameData_t;
 
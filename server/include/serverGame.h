@@ -0,0 +1,41 @@
+/**
+ * \file        serverGame.c
+ * \brief       Contains the rules of a game.
+ * \details     This file includes the turns of a classic game, the scoring of a choice and the end of the game, apart from the shards and the coroutines playing them. They exchange with the players through the transport of the thread, and their waits yield the coroutine they run on, so the simulation plays its games with this code over the loopback transport.
+ */
+#ifndef SERVERGAME_H
+#define SERVERGAME_H
+
+#include "serverData.h"
+#include "serverCommunication.h"
+#include "serverLockstep.h"
+#include "serverConfig.h"
+#include "utils.h"
+
+/**
+ * \fn          int playTurn(gameData_t *gameData, int playerIndex)
+ * \brief       Plays a turn of a player.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the player's choice, checks it and sends the result to the player, then counts the round. A winning choice interrupts the other players. It returns 0 once the round is played, and -1 if the game has a winner or the player was evicted.
+ */
+int playTurn(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          void checkChoice(gameData_t *gameData, int playerIndex)
+ * \brief       Checks the player's choice.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function scores the player's packed guess against the secret code and stores the packed score of the round.
+ */
+void checkChoice(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          void endGame(gameData_t *gameData)
+ * \brief       Ends the game.
+ * \param       gameData : The game data structure.
+ * \details     This function ends the game by broadcasting the result and the secret code to all the players at once, the players having the turn deadline to acknowledge them. In a lockstep game, every player who found the code in the winning round wins.
+ */
+void endGame(gameData_t *gameData);
+
+#endif
@@ -12,7 +12,7 @@
  * \fn          void serverInit(gameData_t *gameData)
  * \brief       Initializes the game data.
  * \param       gameData : The game data structure.
- * \details     This function initializes the game data structure. It sets the number of players to 0, the game winner to EMPTY, and initializes each player's data using the _playerInit function. It also sets the secret code to EMPTY.
+ * \details     This function initializes the game data structure taken from the session slab cache. It sets the number of players to 0, the game winner and the shared queue to EMPTY, the race guesses scored and the race replies to 0, and initializes each player's data using the _playerInit function. The numbers of rounds and the revisions of the histories the players have are reset, the guesses, the scores and the secret code are not cleared, they are written before being read.
  */
 void serverInit(gameData_t *gameData);
 
@@ -20,7 +20,7 @@ void serverInit(gameData_t *gameData);
  * \fn          void _playerInit(player_t *player)
  * \brief       Initializes the player data.
  * \param       player : The player data structure.
- * \details     This function initializes the player data structure. It sets the player's ready status to 0, the number of rounds to 0, and initializes the player's board and result arrays to EMPTY and 0, respectively.
+ * \details     This function initializes the player data structure in constant time. It sets the player's ready status to 0 and leaves the player disconnected until the matchmaking or the bots fill it.
  */
 void _playerInit(player_t *player);
 
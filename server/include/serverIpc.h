@@ -0,0 +1,96 @@
+/**
+ * \file        serverIpc.c
+ * \brief       Contains the accounting of the IPC objects of the server.
+ * \details     This file includes the registry of the message queues created by the server and the reaper removing the queues left by dead processes. Every queue the server creates is registered and stamped: the server sends itself a message on it, so the kernel records the server as its last sender and receiver until a client uses it. The private queues of the game are created with TRANSPORT_QUEUE_MODE, which no other application is expected to use. A private queue with these permissions which is not registered and whose last sender and receiver are both dead is an orphan, left by a server or a client that did not clean up, and the reaper removes it. The queues of the other applications are never touched.
+ */
+#ifndef SERVERIPC_H
+#define SERVERIPC_H
+
+#include "serverData.h"
+#include "utils.h"
+#include <pthread.h>
+#include <limits.h>
+
+#define IPC_MAX_TRACKED 65536
+#define IPC_REAP_PERIOD_S 10
+#define IPC_STAMP_TYPE LONG_MAX // The type of the stamp, beyond the types the peers of a queue use
+
+/**
+ * \struct      ipcRegistry
+ * \brief       Represents the message queues created by the server.
+ * \details     A removed queue is forgotten by the next pass of the reaper. The counters are read by the admin channel without the lock.
+*/
+struct ipcRegistry {
+    int msgids[IPC_MAX_TRACKED]; /**<The queues created by the server and not known to be removed.*/
+    int nbTracked; /**<The number of queues in the registry.*/
+    long nbCreated; /**<The number of queues created by the server.*/
+    long nbReaped; /**<The number of orphans removed by the reaper.*/
+    int nbHost; /**<The number of queues on the host when they were last counted.*/
+    int maxHost; /**<The maximum number of queues on the host, msgmni.*/
+    pthread_mutex_t mutex; /**<Protects the queues of the registry.*/
+};
+typedef struct ipcRegistry ipcRegistry_t;
+
+extern ipcRegistry_t ipcRegistry;
+
+/**
+ * \fn          void ipcInit()
+ * \brief       Starts the reaper.
+ * \details     This function creates the reaper thread. Its first pass runs right away, so the orphans of a server that crashed are removed when the next one starts.
+ */
+void ipcInit();
+
+/**
+ * \fn          int ipcTrack(int msgid)
+ * \brief       Registers a queue created by the server.
+ * \param       msgid : The queue, or -1 if it could not be created.
+ * \details     This function stamps the queue and adds it to the registry. Returns the queue, so the creation can be wrapped.
+ */
+int ipcTrack(int msgid);
+
+/**
+ * \fn          void ipcClose()
+ * \brief       Removes the queues of the server.
+ * \details     This function removes every queue of the registry, the listenning queues, the pooled queues and the queues of the sessions still running.
+ */
+void ipcClose();
+
+/**
+ * \fn          int ipcCount()
+ * \brief       Counts the queues of the host.
+ * \details     This function stores the number of queues on the host and the maximum number of queues in the registry. Returns the highest index used in the table of the queues of the kernel, -1 on failure.
+ */
+int ipcCount();
+
+/**
+ * \fn          int ipcReap()
+ * \brief       Runs a pass of the reaper.
+ * \details     This function forgets the registered queues which were removed, then walks the queues of the host and removes the orphans. Only the private queues of the user of the server created with TRANSPORT_QUEUE_MODE are considered, the listenning queues of a stopped server are left for the server restarted on them. Returns the number of orphans removed.
+ */
+int ipcReap();
+
+/**
+ * \fn          void *_ipcReaperThreadHandler(void *args)
+ * \brief       Handles the reaper thread.
+ * \param       args : Unused.
+ * \details     This function runs a pass every IPC_REAP_PERIOD_S seconds.
+ */
+void *_ipcReaperThreadHandler(void *args);
+
+/**
+ * \fn          int _ipcIsOrphan(const struct msqid_ds *state)
+ * \brief       Tells whether a queue is an orphan.
+ * \param       state : The state of the queue.
+ * \details     A queue nobody ever used is left alone, its owner is unknown. Returns 1 if the last sender and the last receiver of the queue are dead, 0 otherwise.
+ */
+int _ipcIsOrphan(const struct msqid_ds *state);
+
+/**
+ * \fn          int _ipcCompare(const void *a, const void *b)
+ * \brief       Compares two queues, to sort the registry.
+ * \param       a : The first queue.
+ * \param       b : The second queue.
+ */
+int _ipcCompare(const void *a, const void *b);
+
+#endif
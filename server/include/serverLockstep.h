@@ -0,0 +1,61 @@
+/**
+ * \file        serverLockstep.c
+ * \brief       Contains the lockstep game mode of the server.
+ * \details     This file includes the turns of the lockstep games. In a lockstep game the rounds are simultaneous: the player's coroutine receives the player's guess, then waits at the round barrier until every connected player has submitted the round. The coroutine completing the round scores all its guesses at once with the feedback table, the guesses of the bots included, and broadcasts one summary of the round to every player instead of a message per result. All the players finding the code in the same round win.
+ */
+#ifndef SERVERLOCKSTEP_H
+#define SERVERLOCKSTEP_H
+
+#include "serverData.h"
+#include "serverCommunication.h"
+#include "serverConfig.h"
+#include "utils.h"
+
+extern long lockstepRounds;
+
+/**
+ * \fn          void lockstepPlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the rounds of a player in a lockstep game.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the guess of each round of the player and waits for the round to be scored, until the game has a winner, the player has played the maximum number of rounds or the player is evicted.
+ */
+void lockstepPlayer(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          int lockstepCoWinner(gameData_t *gameData, int playerIndex)
+ * \brief       Checks if a player shares the win of a lockstep game.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function returns 1 if the game is a lockstep game and the last guess of the player found the code, in the same round as the winner, and 0 otherwise.
+ */
+int lockstepCoWinner(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          void _lockstepWaitRound(gameData_t *gameData, int round)
+ * \brief       Waits at the barrier of a round.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function yields the coroutine until the round is scored. The first coroutine to find every connected player's guess submitted claims the round and scores it, the players evicted meanwhile are not waited for.
+ */
+void _lockstepWaitRound(gameData_t *gameData, int round);
+
+/**
+ * \fn          int _lockstepRoundSubmitted(gameData_t *gameData, int round)
+ * \brief       Checks if a round can be scored.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function returns 1 if every connected player that is not a bot has submitted the guess of the round, and 0 otherwise.
+ */
+int _lockstepRoundSubmitted(gameData_t *gameData, int round);
+
+/**
+ * \fn          void _lockstepScoreRound(gameData_t *gameData, int round)
+ * \brief       Scores a round and broadcasts its summary.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function has the bots submit their guesses, scores the guesses of all the connected players in one pass, records the winner of the round, the first one in the order of the players, and counts the round for the players who played it. The summary is then broadcast to the players, who have the turn deadline to acknowledge it.
+ */
+void _lockstepScoreRound(gameData_t *gameData, int round);
+
+#endif
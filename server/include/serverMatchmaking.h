@@ -0,0 +1,83 @@
+/**
+ * \file        serverMatchmaking.c
+ * \brief       Contains the matchmaking queue of the server.
+ * \details     This file includes the queue where ready players wait for a game and the function forming game sessions from it. A session is formed as soon as the target size is reached, or with the players already waiting once the oldest one has waited the maximum wait time.
+ */
+#ifndef SERVERMATCHMAKING_H
+#define SERVERMATCHMAKING_H
+
+#include "serverData.h"
+#include "serverConfig.h"
+#include "serverStats.h"
+#include <pthread.h>
+#include <time.h>
+
+/**
+ * \struct      waitingPlayer
+ * \brief       Represents a ready player waiting for a game.
+*/
+struct waitingPlayer {
+    int msgid; /**<The player's message queue id.*/
+    int pid; /**<The PID of the player's client process.*/
+    struct timespec readyTime; /**<The time the player became ready.*/
+};
+typedef struct waitingPlayer waitingPlayer_t;
+
+/**
+ * \struct      matchmakingQueue
+ * \brief       Represents the FIFO queue of ready players.
+*/
+struct matchmakingQueue {
+    waitingPlayer_t players[MAX_CLIENTS]; /**<The circular buffer of waiting players.*/
+    int head; /**<The index of the oldest waiting player.*/
+    int count; /**<The number of waiting players.*/
+    pthread_mutex_t mutex; /**<Protects the queue.*/
+    pthread_cond_t notEmpty; /**<Signaled when a player is added.*/
+    pthread_cond_t notFull; /**<Signaled when players are removed.*/
+};
+typedef struct matchmakingQueue matchmakingQueue_t;
+
+extern matchmakingQueue_t matchmakingQueue;
+
+/**
+ * \fn          void matchmakingInit()
+ * \brief       Initializes the matchmaking queue.
+ * \details     This function initializes the queue condition variables. The notEmpty condition uses the monotonic clock so the maximum wait is not affected by system time changes.
+ */
+void matchmakingInit();
+
+/**
+ * \fn          void matchmakingEnqueue(int msgid, int pid)
+ * \brief       Adds a ready player to the matchmaking queue.
+ * \param       msgid : The player's message queue id.
+ * \param       pid : The PID of the player's client process.
+ * \details     This function appends the player at the end of the queue and wakes the matchmaker. It blocks while the queue is full.
+ */
+void matchmakingEnqueue(int msgid, int pid);
+
+/**
+ * \fn          void matchmakingNextBatch(playerList_t *playerList)
+ * \brief       Forms the next game session.
+ * \param       playerList : The player list of the new session.
+ * \details     This function blocks until a batch of players is available and moves it into the player list. A batch is available when the target size is reached, or when the oldest waiting player has waited the maximum wait time. In the latter case all the waiting players, up to MAX_PLAYERS, form the session. The wait of each player is recorded.
+ */
+void matchmakingNextBatch(playerList_t *playerList);
+
+/**
+ * \fn          void matchmakingSet(int *setting, int value)
+ * \brief       Changes a matchmaking setting.
+ * \param       setting : The target size or the maximum wait of the server configuration.
+ * \param       value : The new value.
+ * \details     This function changes the setting with the queue mutex held, the matchmaker reading the settings with it, and makes the matchmaker check again whether a batch can be formed.
+ */
+void matchmakingSet(int *setting, int value);
+
+/**
+ * \fn          int _matchmakingBatchSize(struct timespec *deadline)
+ * \brief       Computes the size of the batch that can be formed now.
+ * \param       deadline : Where the time at which the oldest player reaches the maximum wait is stored.
+ * \details     This function must be called with the queue mutex held. It returns 0 when no batch can be formed yet.
+ */
+int _matchmakingBatchSize(struct timespec *deadline);
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * \file        serverRace.c
+ * \brief       Contains the race game mode of the server.
+ * \details     This file includes the turns of the race games. In a race, the players stream their guesses without waiting for their scores. The guesses of a session are received by one coroutine of the session at a time, which scores them with the feedback table as they are received and keeps the scores for the players' coroutines, which stream them back. The first winning guess received wins the race, whichever coroutine is scheduled first. When the players are multiplexed, the whole session streams on one queue and its guesses are received in the order they were sent.
+ */
+#ifndef SERVERRACE_H
+#define SERVERRACE_H
+
+#include "serverData.h"
+#include "serverCommunication.h"
+#include "serverConfig.h"
+#include "utils.h"
+#include <time.h>
+
+extern long raceScored;
+
+/**
+ * \fn          void racePlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the race of a player.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the guesses of the session unless another coroutine of the session is receiving them, then streams the scores of the player back, until the race has a winner. The scores received before the race was won are streamed before the player leaves. Waiting for guesses yields the coroutine. A player who sends no guess for the turn deadline, an invalid combination or more messages than its replies hold is evicted.
+ */
+void racePlayer(gameData_t *gameData, int playerIndex);
+
+/**
+ * \fn          int _raceReceive(gameData_t *gameData)
+ * \brief       Receives the guesses of a race session.
+ * \param       gameData : The game data structure, its reception taken by the caller.
+ * \details     When the players share the queue of the session, this function takes the guesses of all the players in the order they reached the queue, so the first winning guess sent is the first one scored. Otherwise each player has its own queue, the order between the queues is lost and the function takes one message of each player in turn, starting with a different player each time, so no player is starved. Each message is scored as it is received and its scores are kept for the player. The reception stops at the first winning guess, or once no message is waiting. It returns the number of messages received.
+ */
+int _raceReceive(gameData_t *gameData);
+
+/**
+ * \fn          int _raceTake(gameData_t *gameData, int playerIndex, char *guesses)
+ * \brief       Scores a guess message received from a player and keeps its scores.
+ * \param       gameData : The game data structure, its reception taken by the caller.
+ * \param       playerIndex : The index of the player.
+ * \param       guesses : The text of the message, overwritten by its scores.
+ * \details     The scores wait in the replies of the player until its coroutine streams them back. A player who sent an invalid combination, or more messages than its replies hold, gets RACE_FAILED and the player's coroutine evicts it. It returns 1 if the message was scored, 0 otherwise.
+ */
+int _raceTake(gameData_t *gameData, int playerIndex, char *guesses);
+
+/**
+ * \fn          int _raceScore(gameData_t *gameData, int playerIndex, char *guesses)
+ * \brief       Scores a guess message.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \param       guesses : The text of the message, holding up to RACE_GUESSES_PER_MESSAGE guesses, overwritten by their scores.
+ * \details     The message is answered by the scores of its guesses, two digits per guess. The scoring stops at the first winning guess, the guesses after it are not answered, and the player wins the race if nobody won it before. It returns the number of guesses scored, or -1 if a guess is not a valid combination.
+ */
+int _raceScore(gameData_t *gameData, int playerIndex, char *guesses);
+
+#endif
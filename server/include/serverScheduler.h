@@ -0,0 +1,203 @@
+/**
+ * \file        serverScheduler.c
+ * \brief       Contains the session scheduler of the server.
+ * \details     This file includes the worker shards playing the game sessions. Each shard is a thread pinned to a core. A session is assigned to the least loaded shard, which keeps one turn task per player of the session. A turn task runs the player's coroutine, which yields whenever it waits for the player, so one shard multiplexes many players. A shard without ready task steals the tasks that have not started yet from the other shards. A started coroutine stays on its shard, since thread local state such as errno must not be cached across a switch of thread. The sessions are balanced when they are admitted instead: a session goes to the least loaded of the shards that are not busy, a shard being busy when it spent most of the last second running. The number of active shards can change while the server runs: the shards beyond it get no new session and finish the turns they have.
+ */
+#ifndef SERVERSCHEDULER_H
+#define SERVERSCHEDULER_H
+
+#include "serverData.h"
+#include "serverSlab.h"
+#include "coroutine.h"
+#include <pthread.h>
+
+#define MAX_SHARDS 64
+#define SHARD_INITIAL_TASKS MAX_CLIENTS
+#define SHARD_MAX_TASKS 0x10000
+#define SCHEDULER_MAX_BACKOFF_US 2000
+#define SCHEDULER_BUSY_WINDOW_NS 1000000000L
+#define SCHEDULER_BUSY_PERCENT 80
+#define TURN_WAITING 0
+#define TURN_PLAYED 1
+#define TURN_DONE 2
+
+/**
+ * \struct      turnTask
+ * \brief       Represents the turns of a player, scheduled on a shard.
+*/
+struct turnTask {
+    gameData_t *gameData; /**<The game data structure.*/
+    int playerIndex; /**<The index of the player.*/
+    int shard; /**<The shard the task belongs to.*/
+    int started; /**<1 once the coroutine has been resumed, the task cannot be stolen anymore.*/
+    coroutine_t coroutine; /**<The coroutine playing the turns of the player.*/
+    char *stack; /**<The stack of the coroutine, taken from the stack slab cache.*/
+};
+typedef struct turnTask turnTask_t;
+
+/**
+ * \struct      shard
+ * \brief       Represents a worker shard.
+ * \details     The task deque is a circular buffer. The owner and the thieves take tasks from its head and put them back at its tail. It is sized to the load of the shard: a task is reserved a slot before it is assigned to the shard, so putting it back never overflows.
+*/
+struct shard {
+    int id; /**<The index of the shard.*/
+    int cpu; /**<The core the shard is pinned to.*/
+    pthread_t thread; /**<The worker thread.*/
+    pthread_mutex_t mutex; /**<Protects the task deque.*/
+    turnTask_t **tasks; /**<The task deque.*/
+    int capacity; /**<The number of slots of the deque, at least the load of the shard.*/
+    int head; /**<The index of the first task.*/
+    int count; /**<The number of tasks in the deque.*/
+    int load; /**<The number of tasks of the sessions assigned to the shard, including the tasks being played or stolen.*/
+    long sessions; /**<The number of sessions assigned to the shard.*/
+    long turns; /**<The number of turns played by the shard.*/
+    long stolenTasks; /**<The number of tasks the shard stole from another shard.*/
+    long polls; /**<The number of coroutines resumed without a turn played.*/
+    long idleSleeps; /**<The number of times the shard slept without any ready task.*/
+    int busy; /**<The percentage of the last window the thread of the shard spent running.*/
+    long windowStart; /**<The monotonic time the window started, in nanoseconds.*/
+    long windowCpu; /**<The CPU time of the thread when the window started, in nanoseconds.*/
+} __attribute__((aligned(CACHE_LINE)));
+typedef struct shard shard_t;
+
+/**
+ * \struct      scheduler
+ * \brief       Represents the set of worker shards.
+*/
+struct scheduler {
+    shard_t shards[MAX_SHARDS]; /**<The shards.*/
+    int nbShards; /**<The number of shards started.*/
+    int nbActive; /**<The number of shards the sessions are assigned to, the first ones, the others only finish their turns.*/
+    int nbCpus; /**<The number of online cores the shards are pinned to.*/
+    pthread_mutex_t mutex; /**<Serializes the session assignments.*/
+};
+typedef struct scheduler scheduler_t;
+
+extern slabCache_t taskCache;
+extern slabCache_t stackCache;
+
+/**
+ * \fn          void schedulerInit(int nbShards)
+ * \brief       Starts the worker shards.
+ * \param       nbShards : The number of shards, each pinned to a core.
+ * \details     This function creates the shard threads. Shard i is pinned to core i modulo the number of online cores.
+ */
+void schedulerInit(int nbShards);
+
+/**
+ * \fn          int schedulerSubmitSession(gameData_t *gameData)
+ * \brief       Assigns a session to a shard.
+ * \param       gameData : The game data structure.
+ * \details     This function assigns the session to the shard with the lowest load among the shards that are not busy, or among all the shards if they are all busy, and queues a turn task for each player of the session on it. Each task gets a coroutine running clientCoroutineHandler. A shard whose deque cannot grow to the session is skipped for the next one. Returns -1 if no shard can take the session, 0 otherwise.
+ */
+int schedulerSubmitSession(gameData_t *gameData);
+
+/**
+ * \fn          int schedulerResize(int nbShards)
+ * \brief       Changes the number of active shards.
+ * \param       nbShards : The number of active shards, at most MAX_SHARDS.
+ * \details     This function starts the shards missing. The shards beyond the new number stay started, so their coroutines go on with their turns, but they get no new session and steal no task, and the active shards steal their tasks that have not started. It returns the number of active shards.
+ */
+int schedulerResize(int nbShards);
+
+/**
+ * \fn          void schedulerCount(int *nbTasks, int *nbQueued)
+ * \brief       Counts the turn tasks of the shards.
+ * \param       nbTasks : Where the number of tasks of the sessions on the shards is stored.
+ * \param       nbQueued : Where the number of tasks in the deques, the others being played, is stored.
+ */
+void schedulerCount(int *nbTasks, int *nbQueued);
+
+/**
+ * \fn          void schedulerShowStats()
+ * \brief       Displays the shard statistics.
+ * \details     This function prints, for each shard, its core, its load, its busy percentage and the sessions, turns, stolen tasks, empty polls and idle sleeps counted so far.
+ */
+void schedulerShowStats();
+
+/**
+ * \fn          void _shardStart(shard_t *shard)
+ * \brief       Starts the thread of a shard.
+ * \param       shard : The shard, its index set.
+ * \details     The shard is pinned to the core of its index modulo the number of online cores. It must be called with the scheduler mutex held or before the server accepts clients.
+ */
+void _shardStart(shard_t *shard);
+
+/**
+ * \fn          void *_shardThreadHandler(void *args)
+ * \brief       Handles a shard thread.
+ * \param       args : The shard.
+ * \details     This function pins the thread to the core of the shard, then resumes the coroutines of the shard in turn, measuring how busy the shard is after each pass. When a whole pass over the deque plays no turn, an active shard tries to steal from the other shards, and the shard sleeps with an exponential backoff if there is nothing to steal.
+ */
+void *_shardThreadHandler(void *args);
+
+/**
+ * \fn          int _shardRunTask(shard_t *shard, turnTask_t *task)
+ * \brief       Runs a turn task.
+ * \param       shard : The shard running the task.
+ * \param       task : The task.
+ * \details     This function resumes the player's coroutine until it yields. When the coroutine has finished, its stack and the task are released. It returns TURN_PLAYED if the player's round went on, TURN_WAITING if the coroutine yielded without playing and TURN_DONE if it has finished.
+ */
+int _shardRunTask(shard_t *shard, turnTask_t *task);
+
+/**
+ * \fn          void _shardMeasure(shard_t *shard)
+ * \brief       Measures how busy a shard is.
+ * \param       shard : The shard, measured by its own thread.
+ * \details     This function closes the window of the shard once it lasted SCHEDULER_BUSY_WINDOW_NS and sets the busy percentage of the shard to the CPU time its thread used during the window.
+ */
+void _shardMeasure(shard_t *shard);
+
+/**
+ * \fn          int _shardBefore(shard_t *a, shard_t *b)
+ * \brief       Tells whether a shard takes a new session before another.
+ * \param       a : The first shard.
+ * \param       b : The second shard.
+ * \details     A shard that is not busy comes before a busy one, then the least loaded shard comes first. Returns 1 if a comes before b, 0 otherwise.
+ */
+int _shardBefore(shard_t *a, shard_t *b);
+
+/**
+ * \fn          turnTask_t *_shardPop(shard_t *shard)
+ * \brief       Takes the first task of a shard.
+ * \param       shard : The shard.
+ * \details     This function returns NULL if the deque is empty.
+ */
+turnTask_t *_shardPop(shard_t *shard);
+
+/**
+ * \fn          int _shardPush(shard_t *shard, turnTask_t *task)
+ * \brief       Puts a task at the end of a shard.
+ * \param       shard : The shard.
+ * \param       task : The task, reserved on the shard.
+ * \details     Returns -1 if the deque is full, which only happens to a task that was not reserved, 0 otherwise.
+ */
+int _shardPush(shard_t *shard, turnTask_t *task);
+
+/**
+ * \fn          int _shardReserve(shard_t *shard, int nbTasks)
+ * \brief       Reserves the slots of tasks assigned to a shard.
+ * \param       shard : The shard.
+ * \param       nbTasks : The number of tasks.
+ * \details     This function adds the tasks to the load of the shard and grows the deque to the load, doubling it, up to SHARD_MAX_TASKS slots. Returns -1 if the deque cannot grow, the load being left unchanged, 0 otherwise.
+ */
+int _shardReserve(shard_t *shard, int nbTasks);
+
+/**
+ * \fn          int _shardSteal(shard_t *thief)
+ * \brief       Steals tasks from another shard.
+ * \param       thief : The idle shard.
+ * \details     This function goes through the other shards, starting with the most loaded one, and moves to the thief the tasks that have not started yet, at most half of the deque of the first shard that has some, and as many as the deque of the thief can take. It returns the number of stolen tasks.
+ */
+int _shardSteal(shard_t *thief);
+
+/**
+ * \fn          turnTask_t *_shardTakeUnstarted(shard_t *shard)
+ * \brief       Takes a task that has not started from a shard.
+ * \param       shard : The shard.
+ * \details     This function removes from the deque the first task whose coroutine has never been resumed. It returns NULL if there is none.
+ */
+turnTask_t *_shardTakeUnstarted(shard_t *shard);
+
+#endif
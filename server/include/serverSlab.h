@@ -0,0 +1,97 @@
+/**
+ * \file        serverSlab.c
+ * \brief       Contains the slab allocator of the server.
+ * \details     This file includes a slab allocator recycling fixed-size objects such as game sessions and client arguments. Free objects are kept in per-core free lists backed by a shared depot, so session churn does not go through malloc once the slabs are carved.
+ */
+#ifndef SERVERSLAB_H
+#define SERVERSLAB_H
+
+#include "serverData.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#define SLAB_MAX_CPUS 64
+#define SLAB_BATCH 8
+#define SLAB_OBJECTS 16
+#define CACHE_LINE 64
+
+/**
+ * \struct      slabObject
+ * \brief       Represents a free object, linked in a free list.
+*/
+struct slabObject {
+    struct slabObject *next; /**<The next free object.*/
+};
+typedef struct slabObject slabObject_t;
+
+/**
+ * \struct      slabFreeList
+ * \brief       Represents a list of free objects.
+ * \details     Each list is aligned on a cache line so the lists of two cores never share one.
+*/
+struct slabFreeList {
+    slabObject_t *head; /**<The first free object.*/
+    int count; /**<The number of free objects.*/
+    pthread_mutex_t mutex; /**<Protects the list.*/
+} __attribute__((aligned(CACHE_LINE)));
+typedef struct slabFreeList slabFreeList_t;
+
+/**
+ * \struct      slabCache
+ * \brief       Represents a cache of objects of the same size.
+*/
+struct slabCache {
+    const char *name; /**<The name of the cache, used in logs.*/
+    size_t objectSize; /**<The size of an object, rounded up to a cache line.*/
+    slabFreeList_t freeLists[SLAB_MAX_CPUS]; /**<The free lists of each core.*/
+    slabFreeList_t depot; /**<The shared list refilling and draining the core lists.*/
+    int nbSlabs; /**<The number of slabs carved so far.*/
+};
+typedef struct slabCache slabCache_t;
+
+extern slabCache_t sessionCache;
+extern slabCache_t clientCache;
+
+/**
+ * \fn          void slabInit(slabCache_t *cache, const char *name, size_t objectSize)
+ * \brief       Initializes a cache.
+ * \param       cache : The cache.
+ * \param       name : The name of the cache.
+ * \param       objectSize : The size of the objects of the cache.
+ * \details     This function initializes the free lists and carves a first slab of SLAB_OBJECTS objects into the depot.
+ */
+void slabInit(slabCache_t *cache, const char *name, size_t objectSize);
+
+/**
+ * \fn          void *slabAlloc(slabCache_t *cache)
+ * \brief       Allocates an object.
+ * \param       cache : The cache.
+ * \details     This function pops an object from the free list of the current core. An empty list is refilled with SLAB_BATCH objects from the depot, and a new slab is carved only when the depot is empty too. The content of the object is not reset.
+ */
+void *slabAlloc(slabCache_t *cache);
+
+/**
+ * \fn          void slabFree(slabCache_t *cache, void *object)
+ * \brief       Releases an object.
+ * \param       cache : The cache.
+ * \param       object : The object.
+ * \details     This function pushes the object on the free list of the current core. When the list holds more than two batches, one batch goes back to the depot for the other cores.
+ */
+void slabFree(slabCache_t *cache, void *object);
+
+/**
+ * \fn          void _slabGrow(slabCache_t *cache)
+ * \brief       Carves a new slab.
+ * \param       cache : The cache.
+ * \details     This function allocates SLAB_OBJECTS zeroed objects in one block and pushes them in the depot. It must be called with the depot mutex held.
+ */
+void _slabGrow(slabCache_t *cache);
+
+/**
+ * \fn          slabFreeList_t *_slabLocalList(slabCache_t *cache)
+ * \brief       Gets the free list of the current core.
+ * \param       cache : The cache.
+ */
+slabFreeList_t *_slabLocalList(slabCache_t *cache);
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * \file        serverStats.c
+ * \brief       Contains the live statistics of the server.
+ * \details     This file includes the counters and the latencies recorded by the code playing the games. They are kept apart from the admin channel reporting them, so the game code does not pull the admin thread in.
+ */
+#ifndef SERVERSTATS_H
+#define SERVERSTATS_H
+
+#include <time.h>
+
+/**
+ * \struct      adminLatency
+ * \brief       Represents a latency measured by the server.
+ * \details     The fields are updated with atomics, the admin thread reads them without a lock.
+*/
+struct adminLatency {
+    long count; /**<The number of measures.*/
+    long totalUs; /**<The sum of the measures in microseconds.*/
+    long maxUs; /**<The largest measure in microseconds.*/
+};
+typedef struct adminLatency adminLatency_t;
+
+/**
+ * \struct      adminStats
+ * \brief       Represents the live statistics of the server.
+*/
+struct adminStats {
+    long sessions; /**<The number of sessions being played.*/
+    long clients; /**<The number of clients accepted and not disconnected yet, virtual clients included.*/
+    adminLatency_t wait; /**<The time the ready players waited in the matchmaking queue.*/
+    adminLatency_t ack; /**<The round trips of the messages sent to the players, until their ack.*/
+};
+typedef struct adminStats adminStats_t;
+
+extern adminStats_t adminStats;
+
+/**
+ * \fn          void adminRecord(adminLatency_t *latency, const struct timespec *start)
+ * \brief       Records a latency.
+ * \param       latency : The latency.
+ * \param       start : The monotonic time the measure started.
+ */
+void adminRecord(adminLatency_t *latency, const struct timespec *start);
+
+#endif
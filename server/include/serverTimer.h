@@ -0,0 +1,116 @@
+/**
+ * \file        serverTimer.c
+ * \brief       Contains the deadline timers of the server.
+ * \details     This file includes a hashed timer wheel driven by a single timerfd. When a deadline expires, a deadline message is posted on the message queue of the player so the thread blocked on that queue wakes up, no thread sleeps on behalf of a player.
+ */
+#ifndef SERVERTIMER_H
+#define SERVERTIMER_H
+
+#include "serverData.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+
+#define TIMER_TICK_MS 100
+#define TIMER_WHEEL_SIZE 256
+#define TIMER_INITIAL_ENTRIES (2*MAX_CLIENTS)
+#define TIMER_MAX_ENTRIES 0x10000 // The entries the low half of a stamp can index
+#define TIMER_FAILED -1 // Returned by timerArm when no entry is left
+
+/**
+ * \struct      timerEntry
+ * \brief       Represents an armed deadline.
+*/
+struct timerEntry {
+    int stamp; /**<The stamp identifying the deadline, 0 when the entry is free.*/
+    int msgid; /**<The message queue on which the deadline message is posted.*/
+    long mtype; /**<The type of the deadline message, the type the waiting thread receives.*/
+    int rounds; /**<The number of full wheel turns left before expiry.*/
+    int slot; /**<The wheel slot of the entry.*/
+    int prev; /**<The previous entry in the slot, or -1.*/
+    int next; /**<The next entry in the slot or in the free list, or -1.*/
+};
+typedef struct timerEntry timerEntry_t;
+
+/**
+ * \struct      timerWheel
+ * \brief       Represents the timer wheel.
+*/
+struct timerWheel {
+    timerEntry_t *entries; /**<The timer entries.*/
+    int nbEntries; /**<The number of entries allocated.*/
+    int slots[TIMER_WHEEL_SIZE]; /**<The first entry of each slot, or -1.*/
+    int freeList; /**<The first free entry, or -1.*/
+    int currentSlot; /**<The slot of the current tick.*/
+    int generation; /**<The counter making the stamps unique.*/
+    int timerfd; /**<The timerfd ticking the wheel.*/
+    pthread_mutex_t mutex; /**<Protects the wheel.*/
+};
+typedef struct timerWheel timerWheel_t;
+
+/**
+ * \fn          void timerInit()
+ * \brief       Starts the timer wheel.
+ * \details     This function initializes the wheel, arms the timerfd to tick every TIMER_TICK_MS and creates the timer thread.
+ */
+void timerInit();
+
+/**
+ * \fn          int timerArm(int msgid, long mtype, int delay)
+ * \brief       Arms a deadline.
+ * \param       msgid : The message queue on which the deadline message is posted.
+ * \param       mtype : The type of the message the waiting thread receives.
+ * \param       delay : The delay in seconds, 0 disables the deadline.
+ * \details     This function returns the stamp of the deadline to pass to sendDataBefore or receiveDataBefore, or NO_DEADLINE when the delay is 0. The entries grow with the deadlines armed at once, up to TIMER_MAX_ENTRIES. It returns TIMER_FAILED if no entry is left, the caller must then drop the player rather than wait without a deadline.
+ */
+int timerArm(int msgid, long mtype, int delay);
+
+/**
+ * \fn          void timerCancel(int stamp)
+ * \brief       Cancels a deadline.
+ * \param       stamp : The stamp returned by timerArm.
+ * \details     This function releases the timer entry if the deadline has not expired yet. If it already expired, the deadline message left on the queue is stale and will be discarded by the next receive.
+ */
+void timerCancel(int stamp);
+
+/**
+ * \fn          void timerExpireNow(int stamp)
+ * \brief       Expires a deadline before its time.
+ * \param       stamp : The stamp returned by timerArm.
+ * \details     This function posts the deadline message right away and releases the timer entry, so the thread waiting with this deadline wakes up. Nothing is done if the deadline has already expired or been cancelled.
+ */
+void timerExpireNow(int stamp);
+
+/**
+ * \fn          void *_timerThreadHandler(void *args)
+ * \brief       Handles the timer thread.
+ * \param       args : The arguments for the thread.
+ * \details     This function waits for the timerfd ticks, advances the wheel and expires the deadlines of the slots it goes through.
+ */
+void *_timerThreadHandler(void *args);
+
+/**
+ * \fn          void _timerExpire(timerEntry_t *entry)
+ * \brief       Expires a deadline.
+ * \param       entry : The timer entry.
+ * \details     This function posts the deadline message on the queue of the entry. It must be called with the wheel mutex held, the entry is not released.
+ */
+void _timerExpire(timerEntry_t *entry);
+
+/**
+ * \fn          int _timerGrow()
+ * \brief       Doubles the timer entries.
+ * \details     This function reallocates the entries and puts the new ones in the free list. It must be called with the wheel mutex held. It returns 0 on success and -1 if TIMER_MAX_ENTRIES are allocated already or the memory is exhausted.
+ */
+int _timerGrow();
+
+/**
+ * \fn          void _timerUnlink(int index)
+ * \brief       Releases a timer entry.
+ * \param       index : The index of the entry.
+ * \details     This function removes the entry from its slot and puts it back in the free list. It must be called with the wheel mutex held.
+ */
+void _timerUnlink(int index);
+
+#endif
@@ -2,53 +2,86 @@
  *	\file		server.c
  *	\brief		Defines the main server logic for the game.
  *
- *	\details	This file defines the main server logic for the game, including the main function, the game loop, and the functions for creating the secret code, starting the game, checking the player's choice, ending the game, and handling the client threads.
+ *	\details	This file defines the main server logic for the game, including the main function, the game loop, and the functions for creating the secret code, starting the game and running the players' coroutines. The rules of the turns are in serverGame.c.
  */
 #include "server.h"
 
 int serverPID = 0;
-int clientPIDs[MAX_PLAYERS+1] = {0};
 
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
  /**
- * \fn          int main()
+ * \fn          int main(int argc, char *argv[])
  * \brief       Main function of the server.
- * \details     This function initializes the game data and enters the main game loop, which includes the client registration, the creation of the secret code, the start of the game, and the end of the game.
+ * \param       argc : The number of arguments.
+ * \param       argv : The arguments.
+ * \details     This function starts the worker shards, starts accepting clients and enters the matchmaking loop. Each time the matchmaking forms a session, the game data is taken from the session slab cache, initialized, and the game is started on a shard.
  */
-int main() {
-    gameData_t gameData;
-    
+int main(int argc, char *argv[]) {
+    gameData_t *gameData;
+    int sessionId = 0;
+
+    serverPID = getpid();
+    parseArguments(argc, argv);
+    traceInit("server");
     signalHandlerRegister();
+    srand(time(NULL));
+    timerInit();
+    slabInit(&sessionCache, "session", sizeof(gameData_t));
+    slabInit(&clientCache, "client", sizeof(clientReadyThreadHandlerArgs_t));
+    schedulerInit(serverConfig.nbShards);
+    analysisInit(serverConfig.nbAnalysts);
+    botsInit();
+    if (serverConfig.race || serverConfig.lockstep) {
+        codeFeedbackInit();
+    }
+    ipcInit();
+    startListenning();
+    adminInit();
     while (1) {
-        pthread_mutex_init(&mutex, NULL);
-        serverInit(&gameData);
-        clientRegistration(&gameData);
-        createCombinations(&gameData);
-        startGame(&gameData);
-        endGame(&gameData);
+        gameData = slabAlloc(&sessionCache);
+        serverInit(gameData);
+        gameData->sessionId = sessionId++;
+        clientRegistration(gameData);
+        createCombinations(gameData);
+        startGame(gameData);
     }
     return 0;
 }
 
+/**
+ * \fn          void endSession(gameData_t *gameData)
+ * \brief       Ends a game session.
+ * \param       gameData : The game data structure.
+ * \details     This function is called by the last player coroutine of the session. It ends the game, removes the message queues of the players that are not bots, queues the analysis of the game and gives the game data back to the session slab cache.
+ */
+void endSession(gameData_t *gameData) {
+    LOG(1, "All players have ended their game.\n");
+    endGame(gameData);
+    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+        if (gameData->playerList.players[i].connected && !gameData->playerList.players[i].bot) {
+            unregisterClient(gameData->playerList.players[i].pid);
+            transport->remove(gameData->playerList.players[i].msgid);
+            __atomic_sub_fetch(&adminStats.clients, 1, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_sub_fetch(&adminStats.sessions, 1, __ATOMIC_RELAXED);
+    analysisSubmitSession(gameData);
+    pthread_mutex_destroy(&gameData->mutex);
+    slabFree(&sessionCache, gameData);
+}
+
 /**
  * \fn          void createCombinations(gameData_t *gameData)
  * \brief       Creates the secret code.
  * \param       gameData : The game data structure.
- * \details     This function generates a random secret code and stores it in the gameData's secretCode array.
+ * \details     This function draws a random secret code among the NB_CODES codes and stores it packed in the game data.
  */
 void createCombinations(gameData_t *gameData) {
+    char secretCode[BOARD_WIDTH + 1] = {0};
     LOG(1, "Creating secret code...\n");
-    char * colors = "RGBCYM";
-    srand(time(NULL));
-    for (int i = 0; i < BOARD_WIDTH; i++) {
-        gameData->secretCode[i] = colors[rand() % strlen(colors)];
-    }
+    gameData->secretCode = rand() % NB_CODES;
+    codeUnpack(gameData->secretCode, secretCode);
     LOG(1, "Secret code created.\n");
-    LOG(1, "Secret code : ");
-    for (int i = 0; i < BOARD_WIDTH; i++) {
-        LOG(1, "%c", gameData->secretCode[i]);
-    }
-    LOG(1, "\n");
+    LOG(1, "Secret code : %s\n", secretCode);
 }
 
 
@@ -56,129 +89,62 @@ void createCombinations(gameData_t *gameData) {
  * \fn          void startGame(gameData_t *gameData)
  * \brief       Starts the game and manages client threads.
  * \param       gameData : The game data structure.
- * \details     This function starts the game by creating a new thread for each player to handle their game session.
+ * \details     This function starts the game by assigning the session to a worker shard, which plays the turns of each player. If no shard can take the session, it is refused: its players are disconnected and the game data is given back to the session slab cache.
  */
 void startGame(gameData_t *gameData) {
     LOG(1, "Starting game...\n");
-    pthread_t threadClients[MAX_PLAYERS];
-    clientThreadHandlerArgs_t clientThreadHandlerArgs[MAX_PLAYERS];
-    
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
-        clientThreadHandlerArgs[i].gameData = gameData;
-        clientThreadHandlerArgs[i].playerIndex = i;
-        pthread_create(&threadClients[i], 
-                        NULL, 
-                        clientThreadHandler, 
-                        &clientThreadHandlerArgs[i]);
-        LOG(1, "Thread for player %d created.\n", i);
-    }
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
-        pthread_join(threadClients[i], NULL);
-    }
-    LOG(1, "All players have ended their game.\n");
-}
-
-/**
- * \fn          void checkChoice(gameData_t *gameData, int playerIndex)
- * \brief       Checks the player's choice.
- * \param       gameData : The game data structure.
- * \param       playerIndex : The index of the player.
- * \details     This function checks the player's choice against the secret code and updates the player's result in the game data.
- */
-void checkChoice(gameData_t *gameData, int playerIndex) {
-    LOG(1, "Checking player %d choice...\n", playerIndex);
-    char colors[6] = "RBGCYM";
-    int nbcolorsCombination[6] = {0};
-    int nbcolorsPlayer[6] = {0};
-    for (int i = 0; i < BOARD_WIDTH; i++) {
-        for (int j = 0; j < 6; j++) {
-            if (gameData->secretCode[i] == colors[j]) {
-                nbcolorsCombination[j]++;
-            }
-            if (gameData->playerList.players[playerIndex].board[gameData->playerList.players[playerIndex].nbRound][i] == colors[j]) {
-                nbcolorsPlayer[j]++;
+    __atomic_add_fetch(&adminStats.sessions, 1, __ATOMIC_RELAXED);
+    if (schedulerSubmitSession(gameData) == -1) {
+        for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+            if (gameData->playerList.players[i].connected && !gameData->playerList.players[i].bot) {
+                evictPlayer(&gameData->playerList.players[i]);
             }
         }
-        if (gameData->playerList.players[playerIndex].board[gameData->playerList.players[playerIndex].nbRound][i] == gameData->secretCode[i]) {
-            gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][0]++;
-            LOG(1, "Player %d color %c is at the right place.\n", playerIndex, gameData->playerList.players[playerIndex].board[gameData->playerList.players[playerIndex].nbRound][i]);
-            LOG(1, "Player %d nb right place : %d.\n", playerIndex, gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][0]);
-        }
+        __atomic_sub_fetch(&adminStats.sessions, 1, __ATOMIC_RELAXED);
+        pthread_mutex_destroy(&gameData->mutex);
+        slabFree(&sessionCache, gameData);
     }
-    for (int i = 0; i < 6; i++) {
-        gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][1] += MIN(nbcolorsCombination[i], nbcolorsPlayer[i]);
-        LOG(1, "Player %d nb right color : %d.\n", playerIndex, gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][1]);
-    }
-    gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][1] -= gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][0];
-    pthread_mutex_lock(&mutex);
-    if (gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][0] == BOARD_WIDTH
-        && gameData->gameWinner == EMPTY) {
-        gameData->gameWinner = playerIndex;
-    }
-    pthread_mutex_unlock(&mutex);
-    LOG(1, "Player %d choice checked.\n", playerIndex);
-    LOG(1, "Player %d result : %d good place and %d good color.\n", playerIndex, gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][0], gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][1]);
 }
 
 /**
- * \fn          void endGame(gameData_t *gameData)
- * \brief       Ends the game.
- * \param       gameData : The game data structure.
- * \details     This function ends the game by determining the winner and sending the result to all players.
+ * \fn          void clientCoroutineHandler(void *args)
+ * \brief       Handles the player coroutines.
+ * \param       args : The turn task of the player.
+ * \details     This function handles the player's game session on the player's coroutine. In a race game, the player's race is played, and in a lockstep game the player's rounds are played in step with the other players. The turns of a bot are played by the bot, or by the round barrier in a lockstep game. Otherwise the player's turns are played one after the other. Waiting for the player yields the coroutine, so the shard plays the other players meanwhile. The coroutine ends when the player has reached the maximum number of rounds, when the game has a winner or when the player has been evicted. The last coroutine of the session ends the game.
  */
-void endGame(gameData_t *gameData) {
-    LOG(1, "Ending game...\n");
-    char buffer[10];
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
-        if (i == gameData->gameWinner) {
-            strcpy(buffer, "win\0");
-        } else {
-            sprintf(buffer, "loose:%d", gameData->gameWinner);
+void clientCoroutineHandler(void *args) {
+    turnTask_t *task = (turnTask_t *)args;
+    gameData_t *gameData = task->gameData;
+    int playerIndex = task->playerIndex;
+    if (serverConfig.race) {
+        racePlayer(gameData, playerIndex);
+    } else if (serverConfig.lockstep) {
+        if (!gameData->playerList.players[playerIndex].bot) {
+            lockstepPlayer(gameData, playerIndex);
         }
-        sendData(gameData->playerList.players[i].msgid, buffer, 6);
-        sendData(gameData->playerList.players[i].msgid, gameData->secretCode, 7);
+    } else if (gameData->playerList.players[playerIndex].bot) {
+        botPlayer(gameData, playerIndex);
     }
-    LOG(1, "Winner is player %d.\n", gameData->gameWinner);
-    LOG(1, "Result sent. Game ended.\n");
-
-}
-
-/**
- * \fn          void *clientThreadHandler(void *args)
- * \brief       Handles the client threads.
- * \param       args : The arguments for the client thread handler.
- * \details     This function handles the player's game session. The player's choice is checked, and the result is sent to the player. The thread ends when the player has reached the maximum number of rounds or when the game has a winner.
- */
-void *clientThreadHandler(void *args) {
-    clientThreadHandlerArgs_t *clientThreadHandlerArgs = (clientThreadHandlerArgs_t *)args;
-    while (clientThreadHandlerArgs->gameData->playerList.players[clientThreadHandlerArgs->playerIndex].nbRound < MAX_ROUND) {
-        pthread_mutex_lock(&mutex);
-        if (clientThreadHandlerArgs->gameData->gameWinner != EMPTY) {
-            pthread_mutex_unlock(&mutex);
-            break;
-        }
-        pthread_mutex_unlock(&mutex);
-        getPlayerChoice(clientThreadHandlerArgs->gameData, clientThreadHandlerArgs->playerIndex);
-        checkChoice(clientThreadHandlerArgs->gameData, clientThreadHandlerArgs->playerIndex);
-        sendResult(clientThreadHandlerArgs->gameData, clientThreadHandlerArgs->playerIndex);
-        clientThreadHandlerArgs->gameData->playerList.players[clientThreadHandlerArgs->playerIndex].nbRound++;
+    while (!serverConfig.race && !serverConfig.lockstep && !gameData->playerList.players[playerIndex].bot
+           && gameData->playerList.nbRound[playerIndex] < MAX_ROUND && playTurn(gameData, playerIndex) == 0);
+    LOG(1, "Ending turns for player %d.\n", playerIndex);
+    if (__atomic_sub_fetch(&gameData->activePlayers, 1, __ATOMIC_ACQ_REL) == 0) {
+        endSession(gameData);
     }
-    LOG(1, "Ending thread for player %d.\n", clientThreadHandlerArgs->playerIndex);
-    pthread_exit(NULL);
 }
 
-
 void signalHandlerRegister () {
     int signals[] = {
         SIGINT, SIGTERM, SIGQUIT, SIGILL, SIGABRT, SIGFPE, SIGSEGV,
-        SIGBUS, SIGSYS, SIGHUP, SIGPIPE, SIGALRM, SIGXCPU, SIGXFSZ, 
-        SIGUSR1
+        SIGBUS, SIGSYS, SIGHUP, SIGPIPE, SIGALRM, SIGXCPU, SIGXFSZ
     };
     int num_signals = sizeof(signals) / sizeof(signals[0]);
 
     for (int i = 0; i < num_signals; ++i) {
         CHECK((signal(signals[i], signalHandlerStop) != SIG_ERR) -1, "Error: failed to register signal handler.");
     }
+    // A client sends SIGUSR1 when it leaves, its game goes on without it
+    CHECK((signal(SIGUSR1, SIG_IGN) != SIG_ERR) -1, "Error: failed to register signal handler.");
     atexit(cleanup);
 }
 
@@ -186,13 +152,28 @@ void signalHandlerRegister () {
 void signalHandlerStop(int signum) {
     printf("Caught signal %d\n", signum);
     printf("Game stopped.\n");
-    for (int i = 0; clientPIDs[i] != 0 && clientPIDs[i] != getpid(); i++) {
-        kill(clientPIDs[i], SIGUSR1), "Error: failed to send signal to client.";
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clientPIDs[i] != 0) {
+            kill(clientPIDs[i], SIGUSR1);
+        }
     }
     exit(signum);
 }
 
 void cleanup() {
     printf("Cleaning up...\n");
-    msgctl(msgget(SERVER_LISTENNING_KEY, 0666), IPC_RMID, NULL);
+    schedulerShowStats();
+    analysisShowStats();
+    if (serverConfig.race) {
+        printf("%ld race guesses scored\n", raceScored);
+    }
+    if (serverConfig.lockstep) {
+        printf("%ld lockstep rounds scored\n", lockstepRounds);
+    }
+    if (serverConfig.botsFillSize > 0) {
+        printf("%ld bot seats, %ld won\n", botSeats, botWins);
+        printf("%ld bot guesses searched, %ld with the workers, %ld answered by the memo\n", botsSolver.nbSearches, botsSolver.nbParallel, botsSolver.nbMemoized);
+    }
+    printf("%ld queues created, %ld orphan queues reaped\n", ipcRegistry.nbCreated, ipcRegistry.nbReaped);
+    ipcClose();
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+/**
+ * \file        serverAdmin.c
+ * \brief       Contains the admin channel of the server.
+ * \details     This file includes the admin queue, a local endpoint separate from the listenning queues, and the thread answering it. The admin tool sends one command per message and the server answers with one line per message, the last one empty. The channel reports the sessions, the clients, the depths of the queues and the latencies measured by the server, and changes the log level, the matchmaking, the deadlines and the number of shards without restarting the server.
+ */
+#include "serverAdmin.h"
+#include "serverCommunication.h"
+#include "serverMatchmaking.h"
+#include "serverScheduler.h"
+#include <stdarg.h>
+
+int adminMsgid = -1;
+
+/**
+ * \fn          void adminInit()
+ * \brief       Opens the admin channel.
+ * \details     This function creates the admin queue, with the key ADMIN_QUEUE_KEY of the listenning key, and the thread answering it. A queue left by a previous server on the key is reused. The queue is registered, it is removed with the other queues of the server.
+ */
+void adminInit() {
+    pthread_t threadAdmin;
+    CHECK(adminMsgid = ipcTrack(msgget(ADMIN_QUEUE_KEY(serverConfig.listenningKey), 0666 | IPC_CREAT)), "Error: could not create the admin queue");
+    pthread_create(&threadAdmin,
+                    NULL,
+                    _adminThreadHandler,
+                    NULL);
+    pthread_detach(threadAdmin);
+    LOG(1, "Admin queue with key %d: %d\n", ADMIN_QUEUE_KEY(serverConfig.listenningKey), adminMsgid);
+}
+
+/**
+ * \fn          void *_adminThreadHandler(void *args)
+ * \brief       Handles the admin thread.
+ * \param       args : Unused.
+ * \details     This function receives the commands on the admin queue and answers each of them on the type the command asked for. The commands are stats, get, set with a name and a value, and reset, which clears the latencies. An unknown command is answered with an error line.
+ */
+void *_adminThreadHandler(void *args) {
+    (void) args;
+    mbuf_t request;
+    mbuf_t reply;
+    char command[MSG_SIZE];
+    char name[MSG_SIZE];
+    int value;
+    int nbFields;
+
+    while (_receiveMessage(adminMsgid, &request, MTYPE_DATA, NO_DEADLINE, 0) == 1) {
+        if (request.ackType < MTYPE_ACK_BASE) {
+            continue;
+        }
+        reply.mtype = request.ackType;
+        reply.ackType = MTYPE_DATA;
+        nbFields = sscanf(request.mtext, "%23s %23s %d", command, name, &value);
+        if (nbFields >= 1 && strcmp(command, "stats") == 0) {
+            _adminShowStats(&reply);
+        } else if (nbFields >= 1 && strcmp(command, "get") == 0) {
+            _adminShowConfig(&reply);
+        } else if (nbFields == 3 && strcmp(command, "set") == 0) {
+            if (_adminSet(name, value) == -1) {
+                _adminReply(&reply, "error: bad setting");
+            } else {
+                _adminReply(&reply, "%s %d", name, value);
+            }
+        } else if (nbFields >= 1 && strcmp(command, "reset") == 0) {
+            _adminClear(&adminStats.wait);
+            _adminClear(&adminStats.ack);
+            _adminReply(&reply, "latencies cleared");
+        } else {
+            _adminReply(&reply, "error: bad command");
+        }
+        _adminReply(&reply, "");
+        LOG(1, "Admin command: %s\n", request.mtext);
+    }
+    pthread_exit(NULL);
+}
+
+/**
+ * \fn          void _adminShowStats(mbuf_t *reply)
+ * \brief       Answers the stats command.
+ * \param       reply : The reply, its type set.
+ * \details     The lines give the sessions being played, the clients connected, the players on the shards, the players waiting for a game, the turn tasks queued on the shards, the messages and the pooled queues of the listenning queues, the queues of the server and of the host, and the count, the mean and the maximum of each latency.
+ */
+void _adminShowStats(mbuf_t *reply) {
+    adminLatency_t *latencies[] = {&adminStats.wait, &adminStats.ack};
+    const char *names[] = {"wait", "ack"};
+    struct msqid_ds state;
+    long nbMessages = 0;
+    int nbPooled = 0;
+    int nbTasks;
+    int nbQueued;
+    long count;
+
+    schedulerCount(&nbTasks, &nbQueued);
+    for (int i = 0; i < serverConfig.nbListenners; i++) {
+        if (msgctl(listenners[i].msgid, IPC_STAT, &state) != -1) {
+            nbMessages += state.msg_qnum;
+        }
+        nbPooled += listenners[i].nbPooled;
+    }
+    _adminReply(reply, "sessions %ld", __atomic_load_n(&adminStats.sessions, __ATOMIC_RELAXED));
+    _adminReply(reply, "clients %ld", __atomic_load_n(&adminStats.clients, __ATOMIC_RELAXED));
+    _adminReply(reply, "players %d", nbTasks);
+    _adminReply(reply, "waiting %d", __atomic_load_n(&matchmakingQueue.count, __ATOMIC_RELAXED));
+    _adminReply(reply, "tasks.queued %d", nbQueued);
+    _adminReply(reply, "listen.depth %ld", nbMessages);
+    _adminReply(reply, "listen.pooled %d", nbPooled);
+    _adminReply(reply, "ipc.queues %d", __atomic_load_n(&ipcRegistry.nbTracked, __ATOMIC_RELAXED));
+    _adminReply(reply, "ipc.created %ld", __atomic_load_n(&ipcRegistry.nbCreated, __ATOMIC_RELAXED));
+    _adminReply(reply, "ipc.reaped %ld", __atomic_load_n(&ipcRegistry.nbReaped, __ATOMIC_RELAXED));
+    ipcCount();
+    _adminReply(reply, "ipc.host %d/%d", __atomic_load_n(&ipcRegistry.nbHost, __ATOMIC_RELAXED), __atomic_load_n(&ipcRegistry.maxHost, __ATOMIC_RELAXED));
+    for (int i = 0; i < 2; i++) {
+        count = __atomic_load_n(&latencies[i]->count, __ATOMIC_RELAXED);
+        _adminReply(reply, "%s.count %ld", names[i], count);
+        _adminReply(reply, "%s.avg.us %ld", names[i], count ? __atomic_load_n(&latencies[i]->totalUs, __ATOMIC_RELAXED) / count : 0);
+        _adminReply(reply, "%s.max.us %ld", names[i], __atomic_load_n(&latencies[i]->maxUs, __ATOMIC_RELAXED));
+    }
+}
+
+/**
+ * \fn          void _adminShowConfig(mbuf_t *reply)
+ * \brief       Answers the get command.
+ * \param       reply : The reply, its type set.
+ * \details     The lines give the value of each setting the set command changes.
+ */
+void _adminShowConfig(mbuf_t *reply) {
+    _adminReply(reply, "loglevel %d", __atomic_load_n(&logLevel, __ATOMIC_RELAXED));
+    _adminReply(reply, "size %d", __atomic_load_n(&serverConfig.matchmakingTargetSize, __ATOMIC_RELAXED));
+    _adminReply(reply, "wait %d", __atomic_load_n(&serverConfig.matchmakingMaxWait, __ATOMIC_RELAXED));
+    _adminReply(reply, "lobby %d", __atomic_load_n(&serverConfig.lobbyDeadline, __ATOMIC_RELAXED));
+    _adminReply(reply, "turn %d", __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED));
+    _adminReply(reply, "shards %d", serverConfig.nbShards);
+}
+
+/**
+ * \fn          int _adminSet(const char *name, int value)
+ * \brief       Changes a setting.
+ * \param       name : The name of the setting: loglevel, size, wait, lobby, turn or shards.
+ * \param       value : The new value, in the range of the matching command line option.
+ * \details     A new matchmaking size or wait wakes the matchmaker, the deadlines apply from the next one armed and the shards from the next session. Returns 0, or -1 if the name or the value is not valid.
+ */
+int _adminSet(const char *name, int value) {
+    if (strcmp(name, "loglevel") == 0 && value >= 0) {
+        __atomic_store_n(&logLevel, value, __ATOMIC_RELAXED);
+    } else if (strcmp(name, "size") == 0 && value >= 1 && value <= MAX_PLAYERS) {
+        matchmakingSet(&serverConfig.matchmakingTargetSize, value);
+    } else if (strcmp(name, "wait") == 0 && value >= 0) {
+        matchmakingSet(&serverConfig.matchmakingMaxWait, value);
+    } else if (strcmp(name, "lobby") == 0 && value >= 0) {
+        __atomic_store_n(&serverConfig.lobbyDeadline, value, __ATOMIC_RELAXED);
+    } else if (strcmp(name, "turn") == 0 && value >= 0) {
+        __atomic_store_n(&serverConfig.turnDeadline, value, __ATOMIC_RELAXED);
+    } else if (strcmp(name, "shards") == 0 && value >= 1 && value <= MAX_SHARDS) {
+        serverConfig.nbShards = schedulerResize(value);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \fn          void _adminClear(adminLatency_t *latency)
+ * \brief       Clears a latency.
+ * \param       latency : The latency.
+ * \details     Each field is cleared with an atomic store, the shards recording their measures meanwhile.
+ */
+void _adminClear(adminLatency_t *latency) {
+    __atomic_store_n(&latency->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&latency->totalUs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&latency->maxUs, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn          void _adminReply(mbuf_t *reply, const char *format, ...)
+ * \brief       Sends a line of a reply.
+ * \param       reply : The reply, its type set.
+ * \param       format : The format of the line, which must fit in a message.
+ */
+void _adminReply(mbuf_t *reply, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(reply->mtext, MSG_SIZE, format, args);
+    va_end(args);
+    // The admin tool may be gone, the reply is dropped rather than blocking the channel
+    if (transport->send(adminMsgid, reply, IPC_NOWAIT) == -1) {
+        LOG(1, "Admin reply dropped.\n");
+    }
+}
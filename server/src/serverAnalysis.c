@@ -0,0 +1,241 @@
+/**
+ * \file        serverAnalysis.c
+ * \brief       Contains the post-game analysis of the server.
+ * \details     This file includes the analysts replaying the finished games. Each player of a finished session becomes a job queued for a pool of low priority threads, which replays the player's guesses against the candidates left by the previous rounds and compares each guess with the minimax-optimal one, using the feedback table. The sessions never wait for the analysts: a job that does not fit in the queue is dropped and counted.
+ */
+#include "serverAnalysis.h"
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+analysis_t analysis = {
+    .nbThreads = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+slabCache_t analysisCache;
+
+/**
+ * \fn          void analysisInit(int nbThreads)
+ * \brief       Starts the analysts.
+ * \param       nbThreads : The number of analyst threads, 0 to disable the analysis.
+ * \details     This function fills the feedback table, computes the worst case of the optimal first guess and creates the analyst threads.
+ */
+void analysisInit(int nbThreads) {
+    static code_t codes[NB_CODES];
+    if (nbThreads <= 0) {
+        return;
+    }
+    codeFeedbackInit();
+    for (int i = 0; i < NB_CODES; i++) {
+        codes[i] = i;
+    }
+    analysis.openingWorstCase = _optimalWorstCase(codes, NB_CODES);
+    slabInit(&analysisCache, "analysis", sizeof(analysisJob_t));
+    analysis.nbThreads = MIN(nbThreads, MAX_ANALYSTS);
+    for (int i = 0; i < analysis.nbThreads; i++) {
+        pthread_create(&analysis.threads[i],
+                        NULL,
+                        _analystThreadHandler,
+                        NULL);
+        pthread_detach(analysis.threads[i]);
+    }
+    LOG(1, "%d analysts started.\n", analysis.nbThreads);
+}
+
+/**
+ * \fn          void analysisSubmitSession(gameData_t *gameData)
+ * \brief       Queues the analysis of a finished session.
+ * \param       gameData : The game data structure.
+ * \details     This function copies the guesses and the scores of each player of the session into a job and queues it without waiting. The jobs that do not fit in the queue are dropped. It does nothing if the analysis is disabled.
+ */
+void analysisSubmitSession(gameData_t *gameData) {
+    playerList_t *playerList = &gameData->playerList;
+    analysisJob_t *job;
+    if (analysis.nbThreads == 0) {
+        return;
+    }
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (playerList->nbRound[i] == 0) {
+            continue;
+        }
+        job = slabAlloc(&analysisCache);
+        job->sessionId = gameData->sessionId;
+        job->playerIndex = i;
+        job->nbRound = playerList->nbRound[i];
+        job->secretCode = gameData->secretCode;
+        memcpy(job->guesses, playerList->guesses[i], job->nbRound * sizeof(code_t));
+        memcpy(job->scores, playerList->scores[i], job->nbRound * sizeof(score_t));
+        pthread_mutex_lock(&analysis.mutex);
+        if (analysis.count < ANALYSIS_QUEUE_SIZE) {
+            analysis.jobs[(analysis.head + analysis.count++) % ANALYSIS_QUEUE_SIZE] = job;
+            job = NULL;
+            pthread_cond_signal(&analysis.cond);
+        } else {
+            analysis.dropped++;
+        }
+        pthread_mutex_unlock(&analysis.mutex);
+        if (job != NULL) {
+            slabFree(&analysisCache, job);
+        }
+    }
+}
+
+/**
+ * \fn          void analysisShowStats()
+ * \brief       Displays the analysis statistics.
+ * \details     This function prints the number of players analysed and dropped, the mean number of candidates left by a guess, and the efficiency of the guesses: the sum of the worst cases of the optimal guesses over the sum of the worst cases of the guesses played, 1 if every guess was optimal.
+ */
+void analysisShowStats() {
+    if (analysis.nbThreads == 0) {
+        return;
+    }
+    pthread_mutex_lock(&analysis.mutex);
+    printf("analysed  dropped  guesses  remaining  efficiency\n");
+    printf("%8ld  %7ld  %7ld  %9.1f  %10.2f\n",
+            analysis.players, analysis.dropped, analysis.guesses,
+            analysis.guesses ? (double) analysis.remaining / analysis.guesses : 0.0,
+            analysis.worstCases ? (double) analysis.optimalWorstCases / analysis.worstCases : 1.0);
+    pthread_mutex_unlock(&analysis.mutex);
+}
+
+/**
+ * \fn          void *_analystThreadHandler(void *args)
+ * \brief       Handles an analyst thread.
+ * \param       args : Unused.
+ * \details     This function lowers the priority of the thread so the analysis never competes with the shards, then analyses the jobs as they are queued.
+ */
+void *_analystThreadHandler(void *args) {
+    analysisJob_t *job;
+    (void) args;
+    // On Linux the nice value is per thread
+    if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), ANALYSIS_NICE) == -1) {
+        LOG(1, "An analyst could not lower its priority.\n");
+    }
+    while (1) {
+        pthread_mutex_lock(&analysis.mutex);
+        while (analysis.count == 0) {
+            pthread_cond_wait(&analysis.cond, &analysis.mutex);
+        }
+        job = analysis.jobs[analysis.head];
+        analysis.head = (analysis.head + 1) % ANALYSIS_QUEUE_SIZE;
+        analysis.count--;
+        pthread_mutex_unlock(&analysis.mutex);
+        _analysePlayer(job);
+        slabFree(&analysisCache, job);
+    }
+    return NULL;
+}
+
+/**
+ * \fn          void _analysePlayer(analysisJob_t *job)
+ * \brief       Analyses the game of a player.
+ * \param       job : The game of the player.
+ * \details     This function replays the guesses of the player. Before each guess, the candidates are the codes consistent with the scores of the previous guesses. The candidates left by each guess and the efficiency of the player are logged and added to the statistics.
+ */
+void _analysePlayer(analysisJob_t *job) {
+    code_t candidates[NB_CODES];
+    analysisGuess_t result;
+    char trail[MAX_ROUND * 6 + 1] = "";
+    int nbCandidates = NB_CODES;
+    long worstCases = 0;
+    long optimalWorstCases = 0;
+    long remaining = 0;
+
+    for (int i = 0; i < NB_CODES; i++) {
+        candidates[i] = i;
+    }
+    for (int round = 0; round < job->nbRound; round++) {
+        _analyseGuess(candidates, nbCandidates, job->guesses[round], job->scores[round], &result);
+        worstCases += result.worstCase;
+        optimalWorstCases += result.optimalWorstCase;
+        remaining += result.remaining;
+        nbCandidates = result.remaining;
+        sprintf(trail + strlen(trail), " %d", result.remaining);
+    }
+    LOG(2, "Session %d: player %d played %d guesses, candidates left%s, efficiency %.2f.\n",
+        job->sessionId, job->playerIndex, job->nbRound, job->nbRound ? trail : " none",
+        worstCases ? (double) optimalWorstCases / worstCases : 1.0);
+    pthread_mutex_lock(&analysis.mutex);
+    analysis.players++;
+    analysis.guesses += job->nbRound;
+    analysis.worstCases += worstCases;
+    analysis.optimalWorstCases += optimalWorstCases;
+    analysis.remaining += remaining;
+    pthread_mutex_unlock(&analysis.mutex);
+}
+
+/**
+ * \fn          void _analyseGuess(code_t *candidates, int nbCandidates, code_t guess, score_t score, analysisGuess_t *result)
+ * \brief       Analyses a guess.
+ * \param       candidates : The candidates before the guess, narrowed down to the candidates consistent with the score of the guess.
+ * \param       nbCandidates : The number of candidates.
+ * \param       guess : The guess.
+ * \param       score : The score of the guess.
+ * \param       result : The analysis of the guess.
+ */
+void _analyseGuess(code_t *candidates, int nbCandidates, code_t guess, score_t score, analysisGuess_t *result) {
+    result->worstCase = _worstCase(candidates, nbCandidates, guess);
+    if (nbCandidates == NB_CODES) {
+        result->optimalWorstCase = analysis.openingWorstCase;
+    } else {
+        result->optimalWorstCase = _optimalWorstCase(candidates, nbCandidates);
+    }
+    result->remaining = 0;
+    for (int i = 0; i < nbCandidates; i++) {
+        if (CODE_FEEDBACK(guess, candidates[i]) == score) {
+            candidates[result->remaining++] = candidates[i];
+        }
+    }
+}
+
+/**
+ * \fn          int _worstCase(code_t *candidates, int nbCandidates, code_t guess)
+ * \brief       Computes the worst case of a guess.
+ * \param       candidates : The candidates.
+ * \param       nbCandidates : The number of candidates.
+ * \param       guess : The guess.
+ * \details     This function splits the candidates by their score against the guess and returns the size of the largest part.
+ */
+int _worstCase(code_t *candidates, int nbCandidates, code_t guess) {
+    int parts[NB_SCORES] = {0};
+    int worstCase = 0;
+    for (int i = 0; i < nbCandidates; i++) {
+        // MAX would increment the part twice
+        if (++parts[CODE_FEEDBACK(guess, candidates[i])] > worstCase) {
+            worstCase = parts[CODE_FEEDBACK(guess, candidates[i])];
+        }
+    }
+    return worstCase;
+}
+
+/**
+ * \fn          int _optimalWorstCase(code_t *candidates, int nbCandidates)
+ * \brief       Computes the worst case of the minimax-optimal guess.
+ * \param       candidates : The candidates.
+ * \param       nbCandidates : The number of candidates.
+ * \details     This function tries every code as a guess, candidate or not, and returns the smallest worst case. A search stops as soon as its worst case reaches the best one found.
+ */
+int _optimalWorstCase(code_t *candidates, int nbCandidates) {
+    int parts[NB_SCORES];
+    int best = nbCandidates;
+    int worstCase;
+    int i;
+    // Below three candidates, guessing one of them is optimal
+    if (nbCandidates <= 2) {
+        return 1;
+    }
+    for (int guess = 0; guess < NB_CODES && best > 1; guess++) {
+        memset(parts, 0, sizeof(parts));
+        worstCase = 0;
+        for (i = 0; i < nbCandidates && worstCase < best; i++) {
+            if (++parts[CODE_FEEDBACK(guess, candidates[i])] > worstCase) {
+                worstCase = parts[CODE_FEEDBACK(guess, candidates[i])];
+            }
+        }
+        if (i == nbCandidates && worstCase < best) {
+            best = worstCase;
+        }
+    }
+    return best;
+}
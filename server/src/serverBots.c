@@ -0,0 +1,145 @@
+/**
+ * \file        serverBots.c
+ * \brief       Contains the bots played by the server.
+ * \details     This file includes the bot players filling the sessions formed with fewer players than wanted. A bot is a player slot without a queue nor a process: its turns are played by its coroutine on the session's shard, like the turns of the other players, and its guesses never leave the server. A bot plays the opening book if one is given, then the minimax guess of the solver over the codes consistent with all its scores. A bot never plays ahead of the players, it waits for every connected player to have played the round before playing it. In a lockstep game, the bots submit their guesses when the round is scored.
+ */
+#include "serverBots.h"
+#include "server.h"
+
+book_t botsBook = {0};
+solver_t botsSolver;
+long botSeats = 0;
+long botWins = 0;
+
+/**
+ * \fn          void botsInit()
+ * \brief       Prepares the bots.
+ * \details     This function starts the solver of the bots with the workers of the configuration and maps the opening book of the configuration, if any. The bots play without the book if it cannot be opened, and search their guesses on their shards if the workers cannot be started. It does nothing if the sessions are not filled with bots.
+ */
+void botsInit() {
+    if (serverConfig.botsFillSize == 0) {
+        return;
+    }
+    if (solverInit(&botsSolver, serverConfig.botsSolverWorkers) == -1) {
+        LOG(1, "Could not start the %d workers of the solver, the bots search alone.\n", serverConfig.botsSolverWorkers);
+        solverInit(&botsSolver, 0);
+    }
+    if (serverConfig.botsBookPath != NULL && bookOpen(&botsBook, serverConfig.botsBookPath) == -1) {
+        LOG(1, "%s is not an opening book for these rules, the bots play without it.\n", serverConfig.botsBookPath);
+    }
+    LOG(1, "Sessions filled with bots up to %d players.\n", serverConfig.botsFillSize);
+}
+
+/**
+ * \fn          void botsFillSession(playerList_t *playerList)
+ * \brief       Fills a session with bots.
+ * \param       playerList : The players of the session formed by the matchmaking.
+ * \details     This function appends bots to the player list until it has the number of players of the configuration. Race games are not filled, a bot would find the code before the first guesses of the players are read.
+ */
+void botsFillSession(playerList_t *playerList) {
+    player_t *player;
+    if (serverConfig.race) {
+        return;
+    }
+    while (playerList->nbPlayers < serverConfig.botsFillSize) {
+        player = &playerList->players[playerList->nbPlayers++];
+        player->bot = 1;
+        player->ready = 1;
+        player->connected = 1;
+        __atomic_add_fetch(&botSeats, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * \fn          void botPlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the turns of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function plays the rounds of the bot until the game has a winner or the bot has played the maximum number of rounds. Each guess is scored like the guesses of the other players.
+ */
+void botPlayer(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    while (playerList->nbRound[playerIndex] < MAX_ROUND) {
+        if (_botWaitRound(gameData, playerIndex) == -1) {
+            break;
+        }
+        playerList->guesses[playerIndex][playerList->nbRound[playerIndex]] = _botGuess(gameData, playerIndex);
+        checkChoice(gameData, playerIndex);
+        if (gameData->gameWinner == playerIndex) {
+            __atomic_add_fetch(&botWins, 1, __ATOMIC_RELAXED);
+            interruptPlayers(gameData);
+        }
+        __atomic_add_fetch(&playerList->nbRound[playerIndex], 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * \fn          void botsSubmitRound(gameData_t *gameData)
+ * \brief       Submits the guesses of the bots for the next round of a lockstep game.
+ * \param       gameData : The game data structure.
+ * \details     This function chooses the next guess of each connected bot and marks it submitted, so the bots play the round being scored. In a lockstep game the bots have no turns of their own.
+ */
+void botsSubmitRound(gameData_t *gameData) {
+    playerList_t *playerList = &gameData->playerList;
+    int nbRound;
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (!playerList->players[i].bot || !playerList->players[i].connected || (nbRound = playerList->nbRound[i]) == MAX_ROUND) {
+            continue;
+        }
+        playerList->guesses[i][nbRound] = _botGuess(gameData, i);
+        __atomic_store_n(&gameData->nbSubmitted[i], nbRound + 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * \fn          int _botWaitRound(gameData_t *gameData, int playerIndex)
+ * \brief       Waits for the players to play the next round of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function yields the coroutine until every connected player that is not a bot has played more rounds than the bot. It returns 0 when the bot can play and -1 if the game has a winner.
+ */
+int _botWaitRound(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    int nbRound = playerList->nbRound[playerIndex];
+    int waiting;
+    while (__atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY) {
+        waiting = 0;
+        for (int i = 0; i < playerList->nbPlayers && !waiting; i++) {
+            // The other coroutines evict their players and play their rounds meanwhile
+            waiting = !playerList->players[i].bot
+                      && __atomic_load_n(&playerList->players[i].connected, __ATOMIC_ACQUIRE)
+                      && __atomic_load_n(&playerList->nbRound[i], __ATOMIC_ACQUIRE) <= nbRound;
+        }
+        if (!waiting) {
+            return 0;
+        }
+        coroutineYield();
+    }
+    return -1;
+}
+
+/**
+ * \fn          code_t _botGuess(gameData_t *gameData, int playerIndex)
+ * \brief       Chooses the next guess of a bot.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the bot.
+ * \details     This function returns the guess of the opening book while the game stays in the book. Otherwise it returns the minimax guess over the codes consistent with every score of the bot, its ties broken from a code drawn for the session and the bot, so the bots of a session do not play the same guesses.
+ */
+code_t _botGuess(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    code_t *guesses = playerList->guesses[playerIndex];
+    score_t *scores = playerList->scores[playerIndex];
+    int nbRound = playerList->nbRound[playerIndex];
+    unsigned int seed = gameData->sessionId * MAX_PLAYERS + playerIndex;
+    code_t origin = rand_r(&seed) % NB_CODES;
+    code_t candidates[NB_CODES];
+    int nbCandidates;
+    code_t guess;
+
+    if (botsBook.header != NULL && bookLookup(&botsBook, guesses, scores, nbRound, &guess) == 0) {
+        return guess;
+    }
+    // The secret code is always consistent, there is at least one candidate
+    nbCandidates = solverCandidates(guesses, scores, nbRound, candidates);
+    return solverBestGuess(&botsSolver, candidates, nbCandidates, origin, NULL);
+}
@@ -5,110 +5,392 @@
  */
 #include "serverCommunication.h"
 
-pthread_mutex_t mutexListenning = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutexClients = PTHREAD_MUTEX_INITIALIZER;
+listenner_t listenners[MAX_LISTENNING_QUEUES];
+int clientPIDs[MAX_CLIENTS] = {0};
 
 
+/**
+ * \fn          void startListenning()
+ * \brief       Starts accepting clients.
+ * \details     This function creates the listenning queues and one listenning thread per queue, so a burst of connections is accepted in parallel. The queues left by a previous server beyond the configured number are removed, the clients would count them. Clients are accepted for the whole life of the server, whether games are running or not.
+ */
+void startListenning() {
+    pthread_t threadListenning;
+    int msgid;
+    matchmakingInit();
+    for (int i = serverConfig.nbListenners; i < MAX_LISTENNING_QUEUES; i++) {
+        if ((msgid = msgget(LISTENNING_QUEUE_KEY(serverConfig.listenningKey, i), 0666)) != -1) {
+            msgctl(msgid, IPC_RMID, NULL);
+        }
+    }
+    for (int i = 0; i < serverConfig.nbListenners; i++) {
+        CHECK(listenners[i].msgid = ipcTrack(msgget(LISTENNING_QUEUE_KEY(serverConfig.listenningKey, i), 0666 | IPC_CREAT)), "Error: could not create the listenning queue");
+        listenners[i].nbPooled = 0;
+    }
+    LOG(1, "Listening for players with key %d on %d queues\n", serverConfig.listenningKey, serverConfig.nbListenners);
+    for (intptr_t i = 0; i < serverConfig.nbListenners; i++) {
+        pthread_create(&threadListenning, 
+                        NULL, 
+                        _listenningThreadHandler, 
+                        (void *) i);
+        pthread_detach(threadListenning);
+    }
+}
+
 /**
  * \fn          void clientRegistration(gameData_t *gameData)
  * \brief       Handles client registration.
  * \param       gameData : The game data structure.
- * \details     This function waits for players to connect and creates a new thread for each player. It also sends the number of players and their respective IDs to each player.
+ * \details     This function waits for the matchmaking queue to form the next session and moves its players into the game data, filling the session with bots if the configuration asks for it. The session is then announced to its players.
  */
 void clientRegistration(gameData_t *gameData) {
-    LOG(1, "Waiting for players to connect...\n");
-    pthread_mutex_init(&mutexListenning, NULL);
-    pthread_t threadListenning;
-    pthread_t threadClients[MAX_PLAYERS];
-    int gameStarted = 0;
+    LOG(1, "Waiting for players to be ready...\n");
+    matchmakingNextBatch(&gameData->playerList);
+    botsFillSession(&gameData->playerList);
+    LOG(1, "Session %d: %d players are ready.\n", gameData->sessionId, gameData->playerList.nbPlayers);
+    announceSession(gameData);
+}
+
+/**
+ * \fn          void announceSession(gameData_t *gameData)
+ * \brief       Announces a session to its players.
+ * \param       gameData : The game data structure, its players set.
+ * \details     This function sends the number of players, followed by the mode of the game, and their respective IDs to each player that is not a bot. When the players are multiplexed, a shared queue is created for the session and each player is moved to its lane before getting its ID, so the whole session plays on one queue. If the shared queue cannot be created, the players keep their own queues.
+ */
+void announceSession(gameData_t *gameData) {
+    playerList_t *playerList = &gameData->playerList;
+    int lanes[TRANSPORT_LANES];
+    int nbLanes = -1;
     char buffer[6];
-    listenningThreadHandlerArgs_t listenningThreadHandlerArgs;
-    listenningThreadHandlerArgs.gameData = gameData;
-    listenningThreadHandlerArgs.threadClients = threadClients;
-    listenningThreadHandlerArgs.gameStarted = &gameStarted;
-    pthread_create(&threadListenning, 
-                    NULL, 
-                    _listenningThreadHandler, 
-                    &listenningThreadHandlerArgs);
-    
-    while (gameData->playerList.nbPlayers == 0){
-        sleep(1);
-    }
-    LOG(1, "At least one player is connected. Game can start.\n");
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
-        pthread_join(threadClients[i], NULL);
-        LOG(1, "Thread for player %d joined.\n", i);
-        LOG(1, "nbPlayers: %d\n", gameData->playerList.nbPlayers);
-    }
-    pthread_mutex_lock(&mutexListenning);
-    gameStarted = 1;
-    pthread_mutex_unlock(&mutexListenning);
-    // Send a connection to exit the thread
-    connectToServer(SERVER_LISTENNING_KEY);
-    
-
-    pthread_join(threadListenning, NULL);
-    LOG(1, "All players are ready.\n");
-    buffer[0] = gameData->playerList.nbPlayers;
-    buffer[1] = '\0';
+    if (serverConfig.multiplex && (nbLanes = transportCreateLanes(lanes)) == -1) {
+        perror("Error: could not create the shared queue of the session");
+    }
+    if (nbLanes != -1) {
+        transportLaneOf(lanes[0], &gameData->sharedMsgid);
+        ipcTrack(gameData->sharedMsgid);
+    }
+    buffer[0] = playerList->nbPlayers;
+    // A race or a lockstep game is announced after the number of players
+    buffer[1] = serverConfig.race ? 'r' : serverConfig.lockstep ? 'l' : LOBBY_CLASSIC;
+    buffer[2] = nbLanes != -1 ? LOBBY_MOVE : '\0';
     buffer[3] = '\0';
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
-        sendData(gameData->playerList.players[i].msgid, buffer, 2);
-        buffer[2] = i;
-        sendData(gameData->playerList.players[i].msgid, buffer+2, 8);
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (playerList->players[i].bot) {
+            continue;
+        }
+        traceTagQueue(playerList->players[i].msgid, gameData->sessionId, i);
+        if (sendPlayerData(&playerList->players[i], buffer, 2) == -1) {
+            continue;
+        }
+        if (nbLanes != -1 && _playerMove(&playerList->players[i], lanes[i]) == -1) {
+            continue;
+        }
+        traceTagQueue(playerList->players[i].msgid, gameData->sessionId, i);
+        buffer[4] = i;
+        buffer[5] = '\0';
+        sendPlayerData(&playerList->players[i], buffer+4, 8);
+    }
+    // The lanes of the bots and of the players evicted before their move are never used
+    for (int i = 0; i < nbLanes; i++) {
+        if (i >= playerList->nbPlayers || playerList->players[i].msgid != lanes[i]) {
+            transport->remove(lanes[i]);
+        }
     }
 }
 
 /**
- * \fn          void getPlayerChoice(gameData_t *gameData, int playerIndex)
+ * \fn          int receiveReady(int msgid, int pid)
+ * \brief       Waits for a client to be ready.
+ * \param       msgid : The client's message queue id.
+ * \param       pid : The PID of the client process.
+ * \details     This function receives the messages of the client until it sends "ready". The client is disconnected if it is not ready before the lobby deadline, or if no timer is left to arm the deadline. It returns 0 if the client is ready and -1 if it was disconnected.
+ */
+int receiveReady(int msgid, int pid) {
+    LOG(1, "Waiting for player %d to be ready...\n", pid);
+    char buffer[MSG_SIZE];
+    int deadline = timerArm(msgid, MTYPE_DATA, __atomic_load_n(&serverConfig.lobbyDeadline, __ATOMIC_RELAXED));
+    do {
+        if (deadline == TIMER_FAILED || receiveDataBefore(msgid, buffer, 1, deadline) == -1) {
+            LOG(1, "Player %d missed the lobby deadline.\n", pid);
+            timerCancel(deadline);
+            disconnectClient(msgid, pid);
+            return -1;
+        }
+    } while (strcmp(buffer, "ready") != 0);
+    timerCancel(deadline);
+    LOG(1, "Player %d is ready.\n", pid);
+    return 0;
+}
+
+/**
+ * \fn          int sendPlayerData(player_t *player, char *data, int expectedCode)
+ * \brief       Sends data to a player before the turn deadline.
+ * \param       player : The player.
+ * \param       data : The data to send.
+ * \param       expectedCode : The expected response code from the player.
+ * \details     This function sends the data and waits for the player's ack until the turn deadline. The player is evicted if the deadline expires, if no timer is left to arm it or if the exchange fails. The round trip of an exchange that succeeds is recorded. It returns 0 on success and -1 if the player is not connected anymore.
+ */
+int sendPlayerData(player_t *player, char *data, int expectedCode) {
+    if (!player->connected) {
+        return -1;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int deadline = timerArm(player->msgid, ACK_TYPE, __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED));
+    int status = deadline == TIMER_FAILED ? -1 : sendDataBefore(player->msgid, data, expectedCode, deadline);
+    timerCancel(deadline);
+    if (status == 0) {
+        adminRecord(&adminStats.ack, &start);
+    }
+    if (status == -1) {
+        evictPlayer(player);
+    }
+    return status;
+}
+
+/**
+ * \fn          int broadcastPlayerData(playerList_t *playerList, broadcast_t *broadcast, int timeout)
+ * \brief       Sends messages to all the players at once.
+ * \param       playerList : The players.
+ * \param       broadcast : The messages of each player and the codes expected for them.
+ * \param       timeout : The time in seconds the players have to acknowledge all their messages, 0 for no timeout.
+ * \details     This function posts all the messages of all the connected players without waiting, then collects the acks of every player as they come, until every player has acknowledged all its messages or the timeout expires. A slow player does not delay the others. The players that fail an ack or miss the timeout are evicted. The bots are skipped. Waiting for the acks yields the coroutine, or sleeps BROADCAST_POLL_US outside of a coroutine. It returns the number of players that acknowledged all their messages.
+ */
+int broadcastPlayerData(playerList_t *playerList, broadcast_t *broadcast, int timeout) {
+    struct timespec now, deadline;
+    player_t *player;
+    mbuf_t ack;
+    int nbPending = 0;
+    int nbDone = 0;
+    int progress;
+    int status;
+
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        player = &playerList->players[i];
+        broadcast->nbAcks[i] = 0;
+        if (player->bot) {
+            continue;
+        }
+        for (int j = 0; j < broadcast->nbMessages && player->connected; j++) {
+            if (postData(player->msgid, broadcast->data[i][j]) == -1) {
+                evictPlayer(player);
+            }
+        }
+        nbPending += player->connected;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout;
+    while (nbPending > 0) {
+        progress = 0;
+        for (int i = 0; i < playerList->nbPlayers; i++) {
+            player = &playerList->players[i];
+            if (player->bot || !player->connected || broadcast->nbAcks[i] == broadcast->nbMessages) {
+                continue;
+            }
+            // The acks of a player come in the order of its messages
+            if ((status = pollMessage(player->msgid, &ack, ACK_TYPE)) == 0) {
+                continue;
+            }
+            progress = 1;
+            if (status == -1 || checkAcknowledgement(&ack, broadcast->expectedCodes[broadcast->nbAcks[i]]) == -1) {
+                evictPlayer(player);
+                nbPending--;
+            } else if (++broadcast->nbAcks[i] == broadcast->nbMessages) {
+                nbDone++;
+                nbPending--;
+            }
+        }
+        if (progress) {
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timeout > 0 && (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))) {
+            break;
+        }
+        if (coroutineCurrent() != NULL) {
+            coroutineYield();
+        } else {
+            usleep(BROADCAST_POLL_US);
+        }
+    }
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (!playerList->players[i].bot && playerList->players[i].connected && broadcast->nbAcks[i] < broadcast->nbMessages) {
+            LOG(1, "Player %d missed the broadcast deadline.\n", i);
+            evictPlayer(&playerList->players[i]);
+        }
+    }
+    return nbDone;
+}
+
+/**
+ * \fn          void evictPlayer(player_t *player)
+ * \brief       Evicts a player from its game.
+ * \param       player : The player.
+ * \details     This function marks the player as disconnected and disconnects its client. The other players of the game go on playing.
+ */
+void evictPlayer(player_t *player) {
+    player->connected = 0;
+    disconnectClient(player->msgid, player->pid);
+}
+
+/**
+ * \fn          void disconnectClient(int msgid, int pid)
+ * \brief       Disconnects a client.
+ * \param       msgid : The client's message queue id.
+ * \param       pid : The PID of the client process.
+ * \details     This function tells the client the game is stopped, unregisters it and removes its message queue, so a stuck or crashed client does not keep any server resource. A virtual client, with the PID 0, is not signalled and notices the removal of its queue.
+ */
+void disconnectClient(int msgid, int pid) {
+    LOG(1, "Player %d evicted.\n", pid);
+    // A virtual client has no process of its own, it notices the removal of its queue
+    if (pid > 0) {
+        kill(pid, SIGUSR1);
+    }
+    unregisterClient(pid);
+    transport->remove(msgid);
+    __atomic_sub_fetch(&adminStats.clients, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn          void registerClient(int pid)
+ * \brief       Registers a connected client.
+ * \param       pid : The PID of the client process.
+ * \details     This function stores the client PID so the client can be stopped when the server exits. Virtual clients, connected with the PID 0, are not registered.
+ */
+void registerClient(int pid) {
+    if (pid <= 0) {
+        return;
+    }
+    pthread_mutex_lock(&mutexClients);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clientPIDs[i] == 0) {
+            clientPIDs[i] = pid;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mutexClients);
+}
+
+/**
+ * \fn          void unregisterClient(int pid)
+ * \brief       Unregisters a client.
+ * \param       pid : The PID of the client process.
+ * \details     This function removes the client PID once its game session has ended.
+ */
+void unregisterClient(int pid) {
+    pthread_mutex_lock(&mutexClients);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clientPIDs[i] == pid) {
+            clientPIDs[i] = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mutexClients);
+}
+
+/**
+ * \fn          int getPlayerChoice(gameData_t *gameData, int playerIndex)
  * \brief       Receives the player's choice.
  * \param       gameData : The game data structure.
  * \param       playerIndex : The index of the player in the player list.
- * \details     This function waits for a specific player to send their choice and then updates the player's board with their choice.
+ * \details     This function waits for a specific player to send their choice before the turn deadline and then stores their choice as a packed guess. Called from the player's coroutine, the wait yields the coroutine. The wait is interrupted when another player wins. It returns 0 if the choice was received and -1 if the game has a winner or if the player missed the turn deadline, could not be given one or sent an invalid combination and was evicted.
  */
-void getPlayerChoice(gameData_t *gameData, int playerIndex) {
+int getPlayerChoice(gameData_t *gameData, int playerIndex) {
+    player_t *player = &gameData->playerList.players[playerIndex];
+    char buffer[MSG_SIZE];
+    int deadline;
+    int status;
+    if (!player->connected) {
+        return -1;
+    }
     LOG(1, "Waiting for player %d to send his choice...\n", playerIndex);
-    receiveData(gameData->playerList.players[playerIndex].msgid, gameData->playerList.players[playerIndex].board[gameData->playerList.players[playerIndex].nbRound], 3);
-    LOG(1, "Player %d sent his choice :%s\n", playerIndex, gameData->playerList.players[playerIndex].board[gameData->playerList.players[playerIndex].nbRound]);
+    // Armed under the game mutex so a winner found meanwhile either sees the deadline or is seen here
+    pthread_mutex_lock(&gameData->mutex);
+    if (gameData->gameWinner != EMPTY) {
+        pthread_mutex_unlock(&gameData->mutex);
+        return -1;
+    }
+    if ((deadline = timerArm(player->msgid, MTYPE_DATA, __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED))) == TIMER_FAILED) {
+        pthread_mutex_unlock(&gameData->mutex);
+        evictPlayer(player);
+        return -1;
+    }
+    __atomic_store_n(&player->deadline, deadline, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&gameData->mutex);
+    status = receiveDataBefore(player->msgid, buffer, 3, deadline);
+    __atomic_store_n(&player->deadline, NO_DEADLINE, __ATOMIC_RELEASE);
+    timerCancel(deadline);
+    if (status == -1 && gameData->gameWinner != EMPTY) {
+        LOG(1, "Player %d turn interrupted, the game has a winner.\n", playerIndex);
+        return -1;
+    }
+    if (status == -1) {
+        LOG(1, "Player %d missed the turn deadline.\n", playerIndex);
+        evictPlayer(player);
+        return -1;
+    }
+    if (codePack(buffer, &gameData->playerList.guesses[playerIndex][gameData->playerList.nbRound[playerIndex]]) == -1) {
+        LOG(1, "Player %d sent an invalid combination.\n", playerIndex);
+        evictPlayer(player);
+        return -1;
+    }
+    LOG(1, "Player %d sent his choice :%.4s\n", playerIndex, buffer);
+    return 0;
+}
+
+/**
+ * \fn          void interruptPlayers(gameData_t *gameData)
+ * \brief       Interrupts the players waiting for their choice.
+ * \param       gameData : The game data structure.
+ * \details     This function is called once the game has a winner. The turn deadline of each player waiting for their choice expires right away, so their turns end and the end of the game reaches every player without waiting for their next guess. Players waiting without a turn deadline are not interrupted.
+ */
+void interruptPlayers(gameData_t *gameData) {
+    pthread_mutex_lock(&gameData->mutex);
+    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+        timerExpireNow(__atomic_load_n(&gameData->playerList.players[i].deadline, __ATOMIC_ACQUIRE));
+    }
+    pthread_mutex_unlock(&gameData->mutex);
 }
 
 /**
- * \fn          void sendResult(gameData_t *gameData, int playerIndex)
+ * \fn          int sendResult(gameData_t *gameData, int playerIndex)
  * \brief       Sends the result to the player.
  * \param       gameData : The game data structure.
  * \param       playerIndex : The index of the player in the player list.
- * \details     This function sends the result of the current round to the player and also sends the results of other players to the player.
+ * \details     This function sends the result of the current round to the player, then a delta of the history of each other player: the rows the player has not acknowledged yet. The ack of a delta acknowledges its rows, so the next delta starts after them and a player who is up to date costs a few bytes. It returns -1 if the player was evicted.
  */
-void sendResult(gameData_t *gameData, int playerIndex) {
+int sendResult(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    uint8_t *synced = playerList->synced[playerIndex];
+    char buffer[MSG_SIZE];
+    score_t score;
+    int nbRound;
+    int nbRows;
     LOG(1, "Sending result to player %d...\n", playerIndex);
     //send result to the player and send other player result to the player
-    char buffer[RESULT_WIDTH+2];
-    
-    for (int i = 0; i < RESULT_WIDTH; i++) {
-        buffer[i] = gameData->playerList.players[playerIndex].result[gameData->playerList.players[playerIndex].nbRound][i]+'0';
-    }
+    score = playerList->scores[playerIndex][playerList->nbRound[playerIndex]];
+    buffer[0] = SCORE_GOOD_PLACE(score)+'0';
+    buffer[1] = SCORE_GOOD_COLOR(score)+'0';
     buffer[RESULT_WIDTH] = '\0';
-    sendData(gameData->playerList.players[playerIndex].msgid, buffer, 4);
+    if (sendPlayerData(&playerList->players[playerIndex], buffer, 4) == -1) {
+        return -1;
+    }
     LOG(1, "Result sent to player %d : good place %c, good color %c\n", playerIndex, buffer[0], buffer[1]);
     LOG(1, "Sending other players result to player %d...\n", playerIndex);
-    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+    for (int i = 0; i < playerList->nbPlayers; i++) {
         if (i != playerIndex) {
-            if (gameData->playerList.players[i].nbRound == 0) {
-                buffer[0] = '0';
-                buffer[1] = '0';
-                buffer[2] = '0';
-                buffer[3] = '\0';
-                sendData(gameData->playerList.players[playerIndex].msgid, buffer, 5);
-            } else {
-                for (int j = 0; j < RESULT_WIDTH; j++) {
-                    buffer[j] = gameData->playerList.players[i].result[gameData->playerList.players[i].nbRound-1][j]+'0';
-                }
-                buffer[RESULT_WIDTH] = gameData->playerList.players[i].nbRound+'0';
-                buffer[RESULT_WIDTH+1] = '\0';
-                sendData(gameData->playerList.players[playerIndex].msgid, buffer, 5);
+            // The other player's coroutine may be playing, its scores are written before its number of rounds
+            nbRound = __atomic_load_n(&playerList->nbRound[i], __ATOMIC_ACQUIRE);
+            nbRows = syncEncode(buffer, synced[i], &playerList->scores[i][synced[i]], nbRound - synced[i]);
+            if (sendPlayerData(&playerList->players[playerIndex], buffer, 5) == -1) {
+                return -1;
             }
+            synced[i] += nbRows;
         }
     }
     LOG(1, "Other players result sent to player %d.\n", playerIndex);
+    return 0;
 }
 
 
@@ -117,59 +399,84 @@ void sendResult(gameData_t *gameData, int playerIndex) {
 /**
  * \fn          void *_listenningThreadHandler(void *args)
  * \brief       Handles the listening thread.
- * \param       args : The arguments for the thread.
- * \details     This function listens for players to connect until the maximum number of players is reached or the game has started. It creates a new thread for each connected player.
+ * \param       args : The index of the listenning queue of the thread.
+ * \details     This function accepts the players connecting on its listenning queue, handing each of them a queue of the pool. While no player is connecting, the pool is filled up, and a queue is only created on demand when a burst has emptied it. It creates a new thread for each connected player waiting for the player to be ready.
  */
 void *_listenningThreadHandler(void *args) {
-    LOG(1, "Listening for players with key %d\n", SERVER_LISTENNING_KEY);
-    listenningThreadHandlerArgs_t *listenningThreadHandlerArgs = (listenningThreadHandlerArgs_t *)args;
-    int serverListenningQueue = msgget(SERVER_LISTENNING_KEY, 0666 | IPC_CREAT);
-    printf("Server listenning queue: %d\n", serverListenningQueue);
-    while (listenningThreadHandlerArgs->gameData->playerList.nbPlayers < MAX_PLAYERS && !*listenningThreadHandlerArgs->gameStarted) {
-        LOG(1, "nbPlayers: %d\n", listenningThreadHandlerArgs->gameData->playerList.nbPlayers);
-        LOG(1, "gameStarted: %d\n", *listenningThreadHandlerArgs->gameStarted);
-        
-        listenningThreadHandlerArgs->gameData->playerList.players[listenningThreadHandlerArgs->gameData->playerList.nbPlayers].msgid = acceptClient(serverListenningQueue);
-        pthread_mutex_lock(&mutexListenning);
-        if (*listenningThreadHandlerArgs->gameStarted) {
-            LOG(1, "Stop listening\n");
-            break;
+    listenner_t *listenner = &listenners[(intptr_t) args];
+    clientReadyThreadHandlerArgs_t *clientReadyThreadHandlerArgs;
+    pthread_t threadClient;
+    int status;
+    printf("Server listenning queue %d: %d\n", (int) (intptr_t) args, listenner->msgid);
+    while (1) {
+        if (listenner->nbPooled == 0) {
+            _listennerFill(listenner);
+        }
+        clientReadyThreadHandlerArgs = slabAlloc(&clientCache);
+        clientReadyThreadHandlerArgs->msgid = listenner->pool[listenner->nbPooled - 1];
+        status = acceptClient(listenner->msgid, &clientReadyThreadHandlerArgs->pid, clientReadyThreadHandlerArgs->msgid,
+                              listenner->nbPooled < QUEUE_POOL_SIZE ? IPC_NOWAIT : 0);
+        if (status != 1) {
+            slabFree(&clientCache, clientReadyThreadHandlerArgs);
+            if (status == 0) {
+                _listennerFill(listenner);
+            }
+            continue;
         }
-        pthread_mutex_unlock(&mutexListenning);
-        clientReadyThreadHandlerArgs_t *clientReadyThreadHandlerArgs = malloc(sizeof(clientReadyThreadHandlerArgs_t));
-        clientReadyThreadHandlerArgs->gameData = listenningThreadHandlerArgs->gameData;
-        clientReadyThreadHandlerArgs->playerIndex = listenningThreadHandlerArgs->gameData->playerList.nbPlayers;
-        pthread_create(&listenningThreadHandlerArgs->threadClients[listenningThreadHandlerArgs->gameData->playerList.nbPlayers], 
+        listenner->nbPooled--;
+        __atomic_add_fetch(&adminStats.clients, 1, __ATOMIC_RELAXED);
+        registerClient(clientReadyThreadHandlerArgs->pid);
+        LOG(1, "Player %d connected.\n", clientReadyThreadHandlerArgs->pid);
+        pthread_create(&threadClient, 
                         NULL, 
                         _clientReadyThreadHandler, 
                         clientReadyThreadHandlerArgs);
-        LOG(1, "Player %d connected.\n", listenningThreadHandlerArgs->gameData->playerList.nbPlayers);
-        listenningThreadHandlerArgs->gameData->playerList.nbPlayers++;
+        pthread_detach(threadClient);
     }
-    LOG(1, "All players are connected.\n");
-    msgctl(serverListenningQueue, IPC_RMID, NULL);
     pthread_exit(NULL);
 }
 
+/**
+ * \fn          void _listennerFill(listenner_t *listenner)
+ * \brief       Adds a client queue to the pool of a listenning queue.
+ * \param       listenner : The listenning queue.
+ * \details     This function creates a client queue and registers it. The players keep their own queue in the lobby even when they are multiplexed, they only move to the shared queue of their session once it is formed.
+ */
+void _listennerFill(listenner_t *listenner) {
+    CHECK(listenner->pool[listenner->nbPooled++] = ipcTrack(msgget(IPC_PRIVATE, TRANSPORT_QUEUE_MODE | IPC_CREAT)), "Error: could not create a client queue");
+}
+
 /**
  * \fn          void *_clientReadyThreadHandler(void *args)
  * \brief       Handles the client ready thread.
  * \param       args : The arguments for the thread.
- * \details     This function waits for a specific player to be ready. Once the player is ready, it updates the player's ready status in the game data.
+ * \details     This function waits for a specific player to be ready. Once the player is ready, it is added to the matchmaking queue.
  */
 void *_clientReadyThreadHandler(void *args) {
     clientReadyThreadHandlerArgs_t *clientReadyThreadHandlerArgs = (clientReadyThreadHandlerArgs_t *) args;
-    LOG(1, "Waiting for player %d to be ready...\n", clientReadyThreadHandlerArgs->playerIndex);
-    char buffer[1024];
-    while (!clientReadyThreadHandlerArgs->gameData->playerList.players[clientReadyThreadHandlerArgs->playerIndex].ready) {
-        receiveData(clientReadyThreadHandlerArgs->gameData->playerList.players[clientReadyThreadHandlerArgs->playerIndex].msgid, buffer, 1);
-        if (strcmp(buffer, "ready") == 0) {
-            //printf("Player %d is ready.\n", clientReadyThreadHandlerArgs->playerIndex);
-            clientReadyThreadHandlerArgs->gameData->playerList.players[clientReadyThreadHandlerArgs->playerIndex].ready = 1;
-        }
+    if (receiveReady(clientReadyThreadHandlerArgs->msgid, clientReadyThreadHandlerArgs->pid) == 0) {
+        matchmakingEnqueue(clientReadyThreadHandlerArgs->msgid, clientReadyThreadHandlerArgs->pid);
     }
-    LOG(1, "Player %d is ready.\n", clientReadyThreadHandlerArgs->playerIndex);
-    free(clientReadyThreadHandlerArgs);
+    slabFree(&clientCache, clientReadyThreadHandlerArgs);
     pthread_exit(NULL);
 }
 
+/**
+ * \fn          int _playerMove(player_t *player, int lane)
+ * \brief       Moves a player to a lane of the shared queue of its session.
+ * \param       player : The player.
+ * \param       lane : The lane.
+ * \details     This function sends the shared queue and the index of the lane to the player on its own queue. Once the player has acknowledged them, it plays on the lane and its own queue is removed. It returns 0 on success and -1 if the player is not connected anymore.
+ */
+int _playerMove(player_t *player, int lane) {
+    char data[MSG_SIZE];
+    int msgid;
+    int index = transportLaneOf(lane, &msgid);
+    sprintf(data, "%d:%d", msgid, index);
+    if (sendPlayerData(player, data, 10) == -1) {
+        return -1;
+    }
+    transport->remove(player->msgid);
+    player->msgid = lane;
+    return 0;
+}
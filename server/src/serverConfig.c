@@ -0,0 +1,142 @@
+/**
+ * \file        serverConfig.c
+ * \brief       Contains the server runtime configuration.
+ * \details     This file includes the configuration structure shared by the server modules and the function parsing the command line arguments into it.
+ */
+#include "serverConfig.h"
+#include "serverScheduler.h"
+#include "serverAnalysis.h"
+#include "solver.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+int logLevel = LOG_LEVEL;
+serverConfig_t serverConfig = {
+    .matchmakingTargetSize = MATCHMAKING_TARGET_SIZE,
+    .matchmakingMaxWait = MATCHMAKING_MAX_WAIT,
+    .lobbyDeadline = LOBBY_DEADLINE,
+    .turnDeadline = TURN_DEADLINE,
+    .nbShards = 0,
+    .nbListenners = LISTENNING_QUEUES,
+    .listenningKey = SERVER_LISTENNING_KEY,
+    .race = 0,
+    .lockstep = 0,
+    .nbAnalysts = ANALYSTS,
+    .botsFillSize = 0,
+    .botsBookPath = NULL,
+    .botsSolverWorkers = 0,
+    .multiplex = 0,
+};
+
+/**
+ * \fn          void _configUsage(char *name)
+ * \brief       Displays the server usage.
+ * \param       name : The name of the executable.
+ * \details     This function prints the available command line options and exits the server.
+ */
+void _configUsage(char *name) {
+    fprintf(stderr, "Usage: %s [-s target size] [-w max wait] [-l lobby deadline] [-t turn deadline] [-j shards] [-q listenning queues] [-K listenning key] [-a analysts] [-r] [-k] [-f bots fill size] [-b bots book] [-m bots solver workers] [-x]\n", name);
+    fprintf(stderr, "\t-s : number of ready players forming a game (1-%d, default %d)\n", MAX_PLAYERS, MATCHMAKING_TARGET_SIZE);
+    fprintf(stderr, "\t-w : maximum time in seconds a ready player waits for a game (default %d)\n", MATCHMAKING_MAX_WAIT);
+    fprintf(stderr, "\t-l : time in seconds a connected player has to be ready, 0 to disable (default %d)\n", LOBBY_DEADLINE);
+    fprintf(stderr, "\t-t : time in seconds a player has to play a turn, 0 to disable (default %d)\n", TURN_DEADLINE);
+    fprintf(stderr, "\t-j : number of worker shards playing the turns (1-%d, default one per core)\n", MAX_SHARDS);
+    fprintf(stderr, "\t-q : number of listenning queues accepting the clients in parallel (1-%d, default %d)\n", MAX_LISTENNING_QUEUES, LISTENNING_QUEUES);
+    fprintf(stderr, "\t-K : key of the first listenning queue (default %d)\n", SERVER_LISTENNING_KEY);
+    fprintf(stderr, "\t-a : number of threads analysing the finished games (0-%d, default %d)\n", MAX_ANALYSTS, ANALYSTS);
+    fprintf(stderr, "\t-r : race games, the players stream their guesses and the first winning guess received wins\n");
+    fprintf(stderr, "\t-k : lockstep games, each round is scored once every player has played it and all the players finding the code in the same round win\n");
+    fprintf(stderr, "\t-f : number of players the games are filled up to with bots played by the server (0-%d, default 0)\n", MAX_PLAYERS);
+    fprintf(stderr, "\t-b : opening book of the bots, generated by bookgen (default none)\n");
+    fprintf(stderr, "\t-m : number of threads helping the bots search their guesses, 0 to search on the shards (0-%d, default 0)\n", SOLVER_MAX_WORKERS);
+    fprintf(stderr, "\t-x : multiplex the players of each session over one shared queue\n");
+    exit(-1);
+}
+
+/**
+ * \fn          void parseArguments(int argc, char *argv[])
+ * \brief       Parses the server command line arguments.
+ * \param       argc : The number of arguments.
+ * \param       argv : The arguments.
+ * \details     This function fills the server configuration with the default values and overrides them with the command line options. -s sets the matchmaking target size, -w the matchmaking maximum wait, -l the lobby deadline and -t the turn deadline, all in seconds. -j sets the number of worker shards, one per online core by default, -q the number of listenning queues, -K their key, and -a the number of analysts. -r makes the games races and -k makes the rounds simultaneous, the two modes excluding each other. -f sets the number of players the sessions are filled up to with bots, -b their opening book and -m the number of workers of their solver. -x multiplexes the players of each session over one shared queue.
+ */
+void parseArguments(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:w:l:t:j:q:K:a:rkf:b:m:x")) != -1) {
+        switch (opt) {
+            case 's':
+                serverConfig.matchmakingTargetSize = atoi(optarg);
+                break;
+            case 'w':
+                serverConfig.matchmakingMaxWait = atoi(optarg);
+                break;
+            case 'l':
+                serverConfig.lobbyDeadline = atoi(optarg);
+                break;
+            case 't':
+                serverConfig.turnDeadline = atoi(optarg);
+                break;
+            case 'j':
+                serverConfig.nbShards = atoi(optarg);
+                if (serverConfig.nbShards < 1 || serverConfig.nbShards > MAX_SHARDS) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            case 'q':
+                serverConfig.nbListenners = atoi(optarg);
+                if (serverConfig.nbListenners < 1 || serverConfig.nbListenners > MAX_LISTENNING_QUEUES) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            case 'K':
+                serverConfig.listenningKey = atoi(optarg);
+                if (serverConfig.listenningKey <= 0) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            case 'r':
+                serverConfig.race = 1;
+                break;
+            case 'k':
+                serverConfig.lockstep = 1;
+                break;
+            case 'f':
+                serverConfig.botsFillSize = atoi(optarg);
+                if (serverConfig.botsFillSize < 0 || serverConfig.botsFillSize > MAX_PLAYERS) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            case 'b':
+                serverConfig.botsBookPath = optarg;
+                break;
+            case 'm':
+                serverConfig.botsSolverWorkers = atoi(optarg);
+                if (serverConfig.botsSolverWorkers < 0 || serverConfig.botsSolverWorkers > SOLVER_MAX_WORKERS) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            case 'x':
+                serverConfig.multiplex = 1;
+                break;
+            case 'a':
+                serverConfig.nbAnalysts = atoi(optarg);
+                if (serverConfig.nbAnalysts < 0 || serverConfig.nbAnalysts > MAX_ANALYSTS) {
+                    _configUsage(argv[0]);
+                }
+                break;
+            default:
+                _configUsage(argv[0]);
+        }
+    }
+    if (serverConfig.matchmakingTargetSize < 1 || serverConfig.matchmakingTargetSize > MAX_PLAYERS
+        || serverConfig.matchmakingMaxWait < 0
+        || serverConfig.lobbyDeadline < 0
+        || serverConfig.turnDeadline < 0
+        || (serverConfig.race && serverConfig.lockstep)) {
+        _configUsage(argv[0]);
+    }
+    if (serverConfig.nbShards == 0) {
+        serverConfig.nbShards = MIN(MAX(sysconf(_SC_NPROCESSORS_ONLN), 1), MAX_SHARDS);
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * \file        serverGame.c
+ * \brief       Contains the rules of a game.
+ * \details     This file includes the turns of a classic game, the scoring of a choice and the end of the game, apart from the shards and the coroutines playing them. They exchange with the players through the transport of the thread, and their waits yield the coroutine they run on, so the simulation plays its games with this code over the loopback transport.
+ */
+#include "serverGame.h"
+
+/**
+ * \fn          int playTurn(gameData_t *gameData, int playerIndex)
+ * \brief       Plays a turn of a player.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the player's choice, checks it and sends the result to the player, then counts the round. A winning choice interrupts the other players. It returns 0 once the round is played, and -1 if the game has a winner or the player was evicted.
+ */
+int playTurn(gameData_t *gameData, int playerIndex) {
+    pthread_mutex_lock(&gameData->mutex);
+    if (gameData->gameWinner != EMPTY) {
+        pthread_mutex_unlock(&gameData->mutex);
+        return -1;
+    }
+    pthread_mutex_unlock(&gameData->mutex);
+    if (getPlayerChoice(gameData, playerIndex) == -1) {
+        return -1;
+    }
+    checkChoice(gameData, playerIndex);
+    if (gameData->gameWinner == playerIndex) {
+        interruptPlayers(gameData);
+    }
+    if (sendResult(gameData, playerIndex) == -1) {
+        return -1;
+    }
+    __atomic_add_fetch(&gameData->playerList.nbRound[playerIndex], 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * \fn          void checkChoice(gameData_t *gameData, int playerIndex)
+ * \brief       Checks the player's choice.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function scores the player's packed guess against the secret code and stores the packed score of the round.
+ */
+void checkChoice(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    int nbRound = playerList->nbRound[playerIndex];
+    score_t score;
+    LOG(1, "Checking player %d choice...\n", playerIndex);
+    score = codeScore(playerList->guesses[playerIndex][nbRound], gameData->secretCode);
+    playerList->scores[playerIndex][nbRound] = score;
+    pthread_mutex_lock(&gameData->mutex);
+    if (score == SCORE_WIN && gameData->gameWinner == EMPTY) {
+        gameData->gameWinner = playerIndex;
+    }
+    pthread_mutex_unlock(&gameData->mutex);
+    LOG(1, "Player %d choice checked.\n", playerIndex);
+    LOG(1, "Player %d result : %d good place and %d good color.\n", playerIndex, SCORE_GOOD_PLACE(score), SCORE_GOOD_COLOR(score));
+}
+
+/**
+ * \fn          void endGame(gameData_t *gameData)
+ * \brief       Ends the game.
+ * \param       gameData : The game data structure.
+ * \details     This function ends the game by broadcasting the result and the secret code to all the players at once, the players having the turn deadline to acknowledge them. In a lockstep game, every player who found the code in the winning round wins.
+ */
+void endGame(gameData_t *gameData) {
+    broadcast_t broadcast;
+    char secretCode[BOARD_WIDTH + 1] = {0};
+    int nbDone;
+    LOG(1, "Ending game...\n");
+    codeUnpack(gameData->secretCode, secretCode);
+    broadcast.nbMessages = 2;
+    broadcast.expectedCodes[0] = 6;
+    broadcast.expectedCodes[1] = 7;
+    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+        if (i == gameData->gameWinner || lockstepCoWinner(gameData, i)) {
+            strcpy(broadcast.data[i][0], "win");
+        } else {
+            sprintf(broadcast.data[i][0], "loose:%d", gameData->gameWinner);
+        }
+        strcpy(broadcast.data[i][1], secretCode);
+    }
+    nbDone = broadcastPlayerData(&gameData->playerList, &broadcast, __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED));
+    LOG(1, "Session %d: winner is player %d.\n", gameData->sessionId, gameData->gameWinner);
+    if (serverConfig.race) {
+        LOG(1, "Session %d: %ld guesses scored.\n", gameData->sessionId, gameData->nbScored);
+    }
+    LOG(1, "Result sent to %d players. Game ended.\n", nbDone);
+}
@@ -9,17 +9,25 @@
  * \fn          void serverInit(gameData_t *gameData)
  * \brief       Initializes the game data.
  * \param       gameData : The game data structure.
- * \details     This function initializes the game data structure. It sets the number of players to 0, the game winner to EMPTY, and initializes each player's data using the _playerInit function. It also sets the secret code to EMPTY.
+ * \details     This function initializes the game data structure taken from the session slab cache. It sets the number of players to 0, the game winner and the shared queue to EMPTY, the race guesses scored and the race replies to 0, and initializes each player's data using the _playerInit function. The numbers of rounds and the revisions of the histories the players have are reset, the guesses, the scores and the secret code are not cleared, they are written before being read.
  */
 void serverInit(gameData_t *gameData) {
     LOG(1, "Initializing game data...\n");
     gameData->playerList.nbPlayers = 0;
     gameData->gameWinner = EMPTY;
+    gameData->sharedMsgid = EMPTY;
+    gameData->nbScored = 0;
+    gameData->roundsClaimed = 0;
+    gameData->roundsScored = 0;
+    gameData->raceReceiving = 0;
+    gameData->raceFirst = 0;
+    pthread_mutex_init(&gameData->mutex, NULL);
     for (int i = 0; i < MAX_PLAYERS; i++) {
         _playerInit(&gameData->playerList.players[i]);
-    }
-    for (int i = 0; i < BOARD_WIDTH; i++) {
-        gameData->secretCode[i] = EMPTY;
+        gameData->playerList.nbRound[i] = 0;
+        gameData->nbSubmitted[i] = 0;
+        gameData->raceNbReplies[i] = 0;
+        memset(gameData->playerList.synced[i], 0, sizeof(gameData->playerList.synced[i]));
     }
     LOG(1, "Game data initialized.\n");
 }
@@ -28,18 +36,13 @@ void serverInit(gameData_t *gameData) {
  * \fn          void _playerInit(player_t *player)
  * \brief       Initializes the player data.
  * \param       player : The player data structure.
- * \details     This function initializes the player data structure. It sets the player's ready status to 0, the number of rounds to 0, and initializes the player's board and result arrays to EMPTY and 0, respectively.
+ * \details     This function initializes the player data structure in constant time. It sets the player's ready status to 0 and leaves the player disconnected until the matchmaking or the bots fill it.
  */
 void _playerInit(player_t *player) {
     player->ready = 0;
-    player->nbRound = 0;
-    for (int i = 0; i < MAX_ROUND; i++) {
-        for (int j = 0; j < BOARD_WIDTH; j++) {
-            player->board[i][j] = EMPTY;
-        }
-        for (int j = 0; j < RESULT_WIDTH; j++) {
-            player->result[i][j] = 0;
-        }
-    }
     player->msgid = -1;
-}
\ No newline at end of file
+    player->pid = 0;
+    player->connected = 0;
+    player->deadline = 0;
+    player->bot = 0;
+}
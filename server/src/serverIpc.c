@@ -0,0 +1,175 @@
+/**
+ * \file        serverIpc.c
+ * \brief       Contains the accounting of the IPC objects of the server.
+ * \details     This file includes the registry of the message queues created by the server and the reaper removing the queues left by dead processes. Every queue the server creates is registered and stamped: the server sends itself a message on it, so the kernel records the server as its last sender and receiver until a client uses it. The private queues of the game are created with TRANSPORT_QUEUE_MODE, which no other application is expected to use. A private queue with these permissions which is not registered and whose last sender and receiver are both dead is an orphan, left by a server or a client that did not clean up, and the reaper removes it. The queues of the other applications are never touched.
+ */
+#define _GNU_SOURCE
+#include "serverIpc.h"
+#include <signal.h>
+#include <unistd.h>
+
+ipcRegistry_t ipcRegistry = {
+    .nbTracked = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * \fn          void ipcInit()
+ * \brief       Starts the reaper.
+ * \details     This function creates the reaper thread. Its first pass runs right away, so the orphans of a server that crashed are removed when the next one starts.
+ */
+void ipcInit() {
+    pthread_t threadReaper;
+    pthread_create(&threadReaper,
+                    NULL,
+                    _ipcReaperThreadHandler,
+                    NULL);
+    pthread_detach(threadReaper);
+}
+
+/**
+ * \fn          int ipcTrack(int msgid)
+ * \brief       Registers a queue created by the server.
+ * \param       msgid : The queue, or -1 if it could not be created.
+ * \details     This function stamps the queue and adds it to the registry. Returns the queue, so the creation can be wrapped.
+ */
+int ipcTrack(int msgid) {
+    mbuf_t stamp;
+    if (msgid == -1) {
+        return -1;
+    }
+    stamp.mtype = IPC_STAMP_TYPE;
+    stamp.ackType = MTYPE_NO_ACK;
+    stamp.mtext[0] = '\0';
+    if (msgsnd(msgid, &stamp, MBUF_SIZE, IPC_NOWAIT) == -1 || msgrcv(msgid, &stamp, MBUF_SIZE, IPC_STAMP_TYPE, IPC_NOWAIT) == -1) {
+        LOG(1, "Queue %d could not be stamped.\n", msgid);
+    }
+    pthread_mutex_lock(&ipcRegistry.mutex);
+    ipcRegistry.nbCreated++;
+    if (ipcRegistry.nbTracked < IPC_MAX_TRACKED) {
+        ipcRegistry.msgids[ipcRegistry.nbTracked++] = msgid;
+    } else {
+        LOG(1, "Queue %d not registered, the registry is full.\n", msgid);
+    }
+    pthread_mutex_unlock(&ipcRegistry.mutex);
+    return msgid;
+}
+
+/**
+ * \fn          void ipcClose()
+ * \brief       Removes the queues of the server.
+ * \details     This function removes every queue of the registry, the listenning queues, the pooled queues and the queues of the sessions still running.
+ */
+void ipcClose() {
+    pthread_mutex_lock(&ipcRegistry.mutex);
+    for (int i = 0; i < ipcRegistry.nbTracked; i++) {
+        msgctl(ipcRegistry.msgids[i], IPC_RMID, NULL);
+    }
+    ipcRegistry.nbTracked = 0;
+    pthread_mutex_unlock(&ipcRegistry.mutex);
+}
+
+/**
+ * \fn          int ipcCount()
+ * \brief       Counts the queues of the host.
+ * \details     This function stores the number of queues on the host and the maximum number of queues in the registry. Returns the highest index used in the table of the queues of the kernel, -1 on failure.
+ */
+int ipcCount() {
+    struct msginfo info;
+    int maxIndex;
+    if ((maxIndex = msgctl(0, MSG_INFO, (struct msqid_ds *) &info)) != -1) {
+        __atomic_store_n(&ipcRegistry.nbHost, info.msgpool, __ATOMIC_RELAXED);
+        __atomic_store_n(&ipcRegistry.maxHost, info.msgmni, __ATOMIC_RELAXED);
+    }
+    return maxIndex;
+}
+
+/**
+ * \fn          int ipcReap()
+ * \brief       Runs a pass of the reaper.
+ * \details     This function forgets the registered queues which were removed, then walks the queues of the host and removes the orphans. Only the private queues of the user of the server created with TRANSPORT_QUEUE_MODE are considered, the listenning queues of a stopped server are left for the server restarted on them. Returns the number of orphans removed.
+ */
+int ipcReap() {
+    static int tracked[IPC_MAX_TRACKED];
+    struct msqid_ds state;
+    int nbTracked;
+    int maxIndex;
+    int msgid;
+    int nbReaped = 0;
+
+    pthread_mutex_lock(&ipcRegistry.mutex);
+    for (int i = 0; i < ipcRegistry.nbTracked; i++) {
+        if (msgctl(ipcRegistry.msgids[i], IPC_STAT, &state) == -1) {
+            ipcRegistry.msgids[i--] = ipcRegistry.msgids[--ipcRegistry.nbTracked];
+        }
+    }
+    nbTracked = ipcRegistry.nbTracked;
+    memcpy(tracked, ipcRegistry.msgids, nbTracked * sizeof(int));
+    pthread_mutex_unlock(&ipcRegistry.mutex);
+    qsort(tracked, nbTracked, sizeof(int), _ipcCompare);
+
+    if ((maxIndex = ipcCount()) == -1) {
+        return 0;
+    }
+    // A queue registered after the copy was stamped by the server, which is alive
+    for (int i = 0; i <= maxIndex; i++) {
+        if ((msgid = msgctl(i, MSG_STAT, &state)) == -1
+            || state.msg_perm.__key != IPC_PRIVATE
+            || state.msg_perm.uid != geteuid()
+            || (state.msg_perm.mode & 0777) != TRANSPORT_QUEUE_MODE
+            || bsearch(&msgid, tracked, nbTracked, sizeof(int), _ipcCompare) != NULL
+            || !_ipcIsOrphan(&state)) {
+            continue;
+        }
+        if (msgctl(msgid, IPC_RMID, NULL) != -1) {
+            LOG(1, "Orphan queue %d reaped, last used by %d and %d.\n", msgid, state.msg_lspid, state.msg_lrpid);
+            nbReaped++;
+        }
+    }
+    __atomic_add_fetch(&ipcRegistry.nbReaped, nbReaped, __ATOMIC_RELAXED);
+    return nbReaped;
+}
+
+/**
+ * \fn          void *_ipcReaperThreadHandler(void *args)
+ * \brief       Handles the reaper thread.
+ * \param       args : Unused.
+ * \details     This function runs a pass every IPC_REAP_PERIOD_S seconds.
+ */
+void *_ipcReaperThreadHandler(void *args) {
+    (void) args;
+    int nbReaped;
+    while (1) {
+        if ((nbReaped = ipcReap()) > 0) {
+            printf("%d orphan queues reaped.\n", nbReaped);
+        }
+        sleep(IPC_REAP_PERIOD_S);
+    }
+    pthread_exit(NULL);
+}
+
+/**
+ * \fn          int _ipcIsOrphan(const struct msqid_ds *state)
+ * \brief       Tells whether a queue is an orphan.
+ * \param       state : The state of the queue.
+ * \details     A queue nobody ever used is left alone, its owner is unknown. Returns 1 if the last sender and the last receiver of the queue are dead, 0 otherwise.
+ */
+int _ipcIsOrphan(const struct msqid_ds *state) {
+    if (state->msg_lspid == 0 || state->msg_lrpid == 0) {
+        return 0;
+    }
+    return (kill(state->msg_lspid, 0) == -1 && errno == ESRCH)
+        && (kill(state->msg_lrpid, 0) == -1 && errno == ESRCH);
+}
+
+/**
+ * \fn          int _ipcCompare(const void *a, const void *b)
+ * \brief       Compares two queues, to sort the registry.
+ * \param       a : The first queue.
+ * \param       b : The second queue.
+ */
+int _ipcCompare(const void *a, const void *b) {
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,147 @@
+/**
+ * \file        serverLockstep.c
+ * \brief       Contains the lockstep game mode of the server.
+ * \details     This file includes the turns of the lockstep games. In a lockstep game the rounds are simultaneous: the player's coroutine receives the player's guess, then waits at the round barrier until every connected player has submitted the round. The coroutine completing the round scores all its guesses at once with the feedback table, the guesses of the bots included, and broadcasts one summary of the round to every player instead of a message per result. All the players finding the code in the same round win.
+ */
+#include "serverLockstep.h"
+#include "server.h"
+
+long lockstepRounds = 0;
+
+/**
+ * \fn          void lockstepPlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the rounds of a player in a lockstep game.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the guess of each round of the player and waits for the round to be scored, until the game has a winner, the player has played the maximum number of rounds or the player is evicted.
+ */
+void lockstepPlayer(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    int round;
+    while ((round = __atomic_load_n(&playerList->nbRound[playerIndex], __ATOMIC_ACQUIRE)) < MAX_ROUND
+           && __atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY) {
+        if (getPlayerChoice(gameData, playerIndex) == -1) {
+            break;
+        }
+        __atomic_store_n(&gameData->nbSubmitted[playerIndex], round + 1, __ATOMIC_RELEASE);
+        _lockstepWaitRound(gameData, round);
+    }
+}
+
+/**
+ * \fn          int lockstepCoWinner(gameData_t *gameData, int playerIndex)
+ * \brief       Checks if a player shares the win of a lockstep game.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function returns 1 if the game is a lockstep game and the last guess of the player found the code, in the same round as the winner, and 0 otherwise.
+ */
+int lockstepCoWinner(gameData_t *gameData, int playerIndex) {
+    playerList_t *playerList = &gameData->playerList;
+    int nbRound = playerList->nbRound[playerIndex];
+    return serverConfig.lockstep && nbRound > 0 && playerList->scores[playerIndex][nbRound - 1] == SCORE_WIN;
+}
+
+/**
+ * \fn          void _lockstepWaitRound(gameData_t *gameData, int round)
+ * \brief       Waits at the barrier of a round.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function yields the coroutine until the round is scored. The first coroutine to find every connected player's guess submitted claims the round and scores it, the players evicted meanwhile are not waited for.
+ */
+void _lockstepWaitRound(gameData_t *gameData, int round) {
+    int claimed;
+    while (__atomic_load_n(&gameData->roundsScored, __ATOMIC_ACQUIRE) <= round) {
+        claimed = round;
+        // The coroutines of a session may run on several shards, a single one wins the round
+        if (_lockstepRoundSubmitted(gameData, round)
+            && __atomic_compare_exchange_n(&gameData->roundsClaimed, &claimed, round + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            _lockstepScoreRound(gameData, round);
+            __atomic_store_n(&gameData->roundsScored, round + 1, __ATOMIC_RELEASE);
+            return;
+        }
+        coroutineYield();
+    }
+}
+
+/**
+ * \fn          int _lockstepRoundSubmitted(gameData_t *gameData, int round)
+ * \brief       Checks if a round can be scored.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function returns 1 if every connected player that is not a bot has submitted the guess of the round, and 0 otherwise.
+ */
+int _lockstepRoundSubmitted(gameData_t *gameData, int round) {
+    playerList_t *playerList = &gameData->playerList;
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (!playerList->players[i].bot
+            && __atomic_load_n(&playerList->players[i].connected, __ATOMIC_ACQUIRE)
+            && __atomic_load_n(&gameData->nbSubmitted[i], __ATOMIC_ACQUIRE) <= round) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * \fn          void _lockstepScoreRound(gameData_t *gameData, int round)
+ * \brief       Scores a round and broadcasts its summary.
+ * \param       gameData : The game data structure.
+ * \param       round : The round.
+ * \details     This function has the bots submit their guesses, scores the guesses of all the connected players in one pass, records the winner of the round, the first one in the order of the players, and counts the round for the players who played it. The summary is then broadcast to the players, who have the turn deadline to acknowledge it.
+ */
+void _lockstepScoreRound(gameData_t *gameData, int round) {
+    playerList_t *playerList = &gameData->playerList;
+    broadcast_t broadcast;
+    code_t guesses[MAX_PLAYERS];
+    score_t scores[MAX_PLAYERS];
+    int players[MAX_PLAYERS];
+    int played[MAX_PLAYERS] = {0};
+    char summary[MSG_SIZE];
+    int nbGuesses = 0;
+    int nbRound;
+    score_t score;
+
+    botsSubmitRound(gameData);
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        if (playerList->players[i].connected && gameData->nbSubmitted[i] > round) {
+            players[nbGuesses] = i;
+            guesses[nbGuesses++] = playerList->guesses[i][round];
+        }
+    }
+    for (int i = 0; i < nbGuesses; i++) {
+        scores[i] = CODE_FEEDBACK(guesses[i], gameData->secretCode);
+    }
+    pthread_mutex_lock(&gameData->mutex);
+    for (int i = 0; i < nbGuesses; i++) {
+        playerList->scores[players[i]][round] = scores[i];
+        played[players[i]] = 1;
+        if (scores[i] == SCORE_WIN && gameData->gameWinner == EMPTY) {
+            gameData->gameWinner = players[i];
+        }
+    }
+    pthread_mutex_unlock(&gameData->mutex);
+    for (int i = 0; i < nbGuesses; i++) {
+        __atomic_add_fetch(&playerList->nbRound[players[i]], 1, __ATOMIC_RELEASE);
+    }
+    if (gameData->gameWinner != EMPTY && playerList->players[gameData->gameWinner].bot) {
+        __atomic_add_fetch(&botWins, 1, __ATOMIC_RELAXED);
+    }
+
+    // The players who did not play the round are shown with their last score
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        nbRound = playerList->nbRound[i];
+        score = nbRound == 0 ? SCORE(0, 0) : playerList->scores[i][nbRound - 1];
+        summary[i * SUMMARY_ROW_WIDTH] = SCORE_GOOD_PLACE(score) + '0';
+        summary[i * SUMMARY_ROW_WIDTH + 1] = SCORE_GOOD_COLOR(score) + '0';
+        summary[i * SUMMARY_ROW_WIDTH + 2] = played[i] + '0';
+    }
+    summary[playerList->nbPlayers * SUMMARY_ROW_WIDTH] = '\0';
+    broadcast.nbMessages = 1;
+    broadcast.expectedCodes[0] = 9;
+    for (int i = 0; i < playerList->nbPlayers; i++) {
+        strcpy(broadcast.data[i][0], summary);
+    }
+    broadcastPlayerData(playerList, &broadcast, __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED));
+    __atomic_add_fetch(&lockstepRounds, 1, __ATOMIC_RELAXED);
+    LOG(1, "Session %d: round %d scored, %d guesses.\n", gameData->sessionId, round, nbGuesses);
+}
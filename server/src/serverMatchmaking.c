@@ -0,0 +1,121 @@
+/**
+ * \file        serverMatchmaking.c
+ * \brief       Contains the matchmaking queue of the server.
+ * \details     This file includes the queue where ready players wait for a game and the function forming game sessions from it. A session is formed as soon as the target size is reached, or with the players already waiting once the oldest one has waited the maximum wait time.
+ */
+#include "serverMatchmaking.h"
+
+matchmakingQueue_t matchmakingQueue = {
+    .head = 0,
+    .count = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * \fn          void matchmakingInit()
+ * \brief       Initializes the matchmaking queue.
+ * \details     This function initializes the queue condition variables. The notEmpty condition uses the monotonic clock so the maximum wait is not affected by system time changes.
+ */
+void matchmakingInit() {
+    pthread_condattr_t condAttr;
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&matchmakingQueue.notEmpty, &condAttr);
+    pthread_cond_init(&matchmakingQueue.notFull, NULL);
+    pthread_condattr_destroy(&condAttr);
+}
+
+/**
+ * \fn          void matchmakingEnqueue(int msgid, int pid)
+ * \brief       Adds a ready player to the matchmaking queue.
+ * \param       msgid : The player's message queue id.
+ * \param       pid : The PID of the player's client process.
+ * \details     This function appends the player at the end of the queue and wakes the matchmaker. It blocks while the queue is full.
+ */
+void matchmakingEnqueue(int msgid, int pid) {
+    pthread_mutex_lock(&matchmakingQueue.mutex);
+    while (matchmakingQueue.count == MAX_CLIENTS) {
+        pthread_cond_wait(&matchmakingQueue.notFull, &matchmakingQueue.mutex);
+    }
+    waitingPlayer_t *player = &matchmakingQueue.players[(matchmakingQueue.head + matchmakingQueue.count) % MAX_CLIENTS];
+    player->msgid = msgid;
+    player->pid = pid;
+    clock_gettime(CLOCK_MONOTONIC, &player->readyTime);
+    matchmakingQueue.count++;
+    LOG(1, "Player %d queued for matchmaking, %d waiting.\n", pid, matchmakingQueue.count);
+    pthread_cond_signal(&matchmakingQueue.notEmpty);
+    pthread_mutex_unlock(&matchmakingQueue.mutex);
+}
+
+/**
+ * \fn          void matchmakingNextBatch(playerList_t *playerList)
+ * \brief       Forms the next game session.
+ * \param       playerList : The player list of the new session.
+ * \details     This function blocks until a batch of players is available and moves it into the player list. A batch is available when the target size is reached, or when the oldest waiting player has waited the maximum wait time. In the latter case all the waiting players, up to MAX_PLAYERS, form the session. The wait of each player is recorded.
+ */
+void matchmakingNextBatch(playerList_t *playerList) {
+    struct timespec deadline;
+    int batchSize;
+
+    pthread_mutex_lock(&matchmakingQueue.mutex);
+    while ((batchSize = _matchmakingBatchSize(&deadline)) == 0) {
+        if (matchmakingQueue.count == 0) {
+            pthread_cond_wait(&matchmakingQueue.notEmpty, &matchmakingQueue.mutex);
+        } else {
+            pthread_cond_timedwait(&matchmakingQueue.notEmpty, &matchmakingQueue.mutex, &deadline);
+        }
+    }
+    for (int i = 0; i < batchSize; i++) {
+        waitingPlayer_t *player = &matchmakingQueue.players[matchmakingQueue.head];
+        playerList->players[i].msgid = player->msgid;
+        playerList->players[i].pid = player->pid;
+        playerList->players[i].ready = 1;
+        playerList->players[i].connected = 1;
+        adminRecord(&adminStats.wait, &player->readyTime);
+        matchmakingQueue.head = (matchmakingQueue.head + 1) % MAX_CLIENTS;
+        matchmakingQueue.count--;
+    }
+    playerList->nbPlayers = batchSize;
+    pthread_cond_broadcast(&matchmakingQueue.notFull);
+    pthread_mutex_unlock(&matchmakingQueue.mutex);
+    LOG(1, "Session formed with %d players.\n", batchSize);
+}
+
+/**
+ * \fn          void matchmakingSet(int *setting, int value)
+ * \brief       Changes a matchmaking setting.
+ * \param       setting : The target size or the maximum wait of the server configuration.
+ * \param       value : The new value.
+ * \details     This function changes the setting with the queue mutex held, the matchmaker reading the settings with it, and makes the matchmaker check again whether a batch can be formed.
+ */
+void matchmakingSet(int *setting, int value) {
+    pthread_mutex_lock(&matchmakingQueue.mutex);
+    *setting = value;
+    pthread_cond_signal(&matchmakingQueue.notEmpty);
+    pthread_mutex_unlock(&matchmakingQueue.mutex);
+}
+
+/**
+ * \fn          int _matchmakingBatchSize(struct timespec *deadline)
+ * \brief       Computes the size of the batch that can be formed now.
+ * \param       deadline : Where the time at which the oldest player reaches the maximum wait is stored.
+ * \details     This function must be called with the queue mutex held. It returns 0 when no batch can be formed yet.
+ */
+int _matchmakingBatchSize(struct timespec *deadline) {
+    struct timespec now;
+
+    if (matchmakingQueue.count >= serverConfig.matchmakingTargetSize) {
+        return serverConfig.matchmakingTargetSize;
+    }
+    if (matchmakingQueue.count == 0) {
+        return 0;
+    }
+    *deadline = matchmakingQueue.players[matchmakingQueue.head].readyTime;
+    deadline->tv_sec += serverConfig.matchmakingMaxWait;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > deadline->tv_sec
+        || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec)) {
+        return MIN(matchmakingQueue.count, MAX_PLAYERS);
+    }
+    return 0;
+}
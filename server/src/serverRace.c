@@ -0,0 +1,182 @@
+/**
+ * \file        serverRace.c
+ * \brief       Contains the race game mode of the server.
+ * \details     This file includes the turns of the race games. In a race, the players stream their guesses without waiting for their scores. The guesses of a session are received by one coroutine of the session at a time, which scores them with the feedback table as they are received and keeps the scores for the players' coroutines, which stream them back. The first winning guess received wins the race, whichever coroutine is scheduled first. When the players are multiplexed, the whole session streams on one queue and its guesses are received in the order they were sent.
+ */
+#include "serverRace.h"
+
+long raceScored = 0;
+
+/**
+ * \fn          void racePlayer(gameData_t *gameData, int playerIndex)
+ * \brief       Plays the race of a player.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \details     This function receives the guesses of the session unless another coroutine of the session is receiving them, then streams the scores of the player back, until the race has a winner. The scores received before the race was won are streamed before the player leaves. Waiting for guesses yields the coroutine. A player who sends no guess for the turn deadline, an invalid combination or more messages than its replies hold is evicted.
+ */
+void racePlayer(gameData_t *gameData, int playerIndex) {
+    player_t *player = &gameData->playerList.players[playerIndex];
+    char replies[RACE_BATCH][MSG_SIZE];
+    struct timespec now;
+    time_t lastGuess;
+    int nbReplies;
+    int deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    lastGuess = now.tv_sec;
+    while (player->connected) {
+        if (__atomic_exchange_n(&gameData->raceReceiving, 1, __ATOMIC_ACQUIRE)) {
+            coroutineYield();
+            continue;
+        }
+        if (__atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY) {
+            _raceReceive(gameData);
+        }
+        nbReplies = gameData->raceNbReplies[playerIndex];
+        if (nbReplies > 0) {
+            memcpy(replies, gameData->raceReplies[playerIndex], nbReplies * MSG_SIZE);
+            gameData->raceNbReplies[playerIndex] = 0;
+        }
+        __atomic_store_n(&gameData->raceReceiving, 0, __ATOMIC_RELEASE);
+        if (nbReplies == RACE_FAILED) {
+            LOG(1, "Player %d sent an invalid combination or too many guesses.\n", playerIndex);
+            evictPlayer(player);
+            break;
+        }
+        for (int i = 0; i < nbReplies; i++) {
+            if (streamData(player->msgid, replies[i]) == -1) {
+                evictPlayer(player);
+                break;
+            }
+        }
+        if (__atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) != EMPTY) {
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (nbReplies > 0) {
+            lastGuess = now.tv_sec;
+            continue;
+        }
+        deadline = __atomic_load_n(&serverConfig.turnDeadline, __ATOMIC_RELAXED);
+        if (deadline > 0 && now.tv_sec - lastGuess >= deadline) {
+            LOG(1, "Player %d missed the turn deadline.\n", playerIndex);
+            evictPlayer(player);
+            break;
+        }
+        coroutineYield();
+    }
+}
+
+/**
+ * \fn          int _raceReceive(gameData_t *gameData)
+ * \brief       Receives the guesses of a race session.
+ * \param       gameData : The game data structure, its reception taken by the caller.
+ * \details     When the players share the queue of the session, this function takes the guesses of all the players in the order they reached the queue, so the first winning guess sent is the first one scored. Otherwise each player has its own queue, the order between the queues is lost and the function takes one message of each player in turn, starting with a different player each time, so no player is starved. Each message is scored as it is received and its scores are kept for the player. The reception stops at the first winning guess, or once no message is waiting. It returns the number of messages received.
+ */
+int _raceReceive(gameData_t *gameData) {
+    playerList_t *playerList = &gameData->playerList;
+    int nbPlayers = playerList->nbPlayers;
+    int first = gameData->raceFirst;
+    int waiting[MAX_PLAYERS];
+    int nbWaiting = 0;
+    int nbReceived = 0;
+    int lane;
+    mbuf_t message;
+
+    if (gameData->sharedMsgid != EMPTY) {
+        while (__atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY
+                && (lane = transportReceiveStream(gameData->sharedMsgid, &message, IPC_NOWAIT)) != -1) {
+            // Player i plays on lane i, the guesses left by an evicted player are dropped
+            if (lane < nbPlayers && playerList->players[lane].connected && gameData->raceNbReplies[lane] != RACE_FAILED) {
+                nbReceived += _raceTake(gameData, lane, message.mtext);
+            }
+        }
+        return nbReceived;
+    }
+    gameData->raceFirst = (first + 1) % nbPlayers;
+    for (int i = 0; i < nbPlayers; i++) {
+        waiting[i] = playerList->players[i].connected && gameData->raceNbReplies[i] != RACE_FAILED;
+        nbWaiting += waiting[i];
+    }
+    while (nbWaiting > 0 && __atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY) {
+        for (int j = 0; j < nbPlayers && __atomic_load_n(&gameData->gameWinner, __ATOMIC_ACQUIRE) == EMPTY; j++) {
+            int i = (first + j) % nbPlayers;
+            if (!waiting[i]) {
+                continue;
+            }
+            // A player whose replies are full is left until its coroutine has streamed them
+            if (gameData->raceNbReplies[i] == RACE_BATCH
+                    || !playerList->players[i].connected
+                    || pollMessage(playerList->players[i].msgid, &message, MTYPE_DATA) != 1
+                    || _raceTake(gameData, i, message.mtext) == 0) {
+                waiting[i] = 0;
+                nbWaiting--;
+                continue;
+            }
+            nbReceived++;
+        }
+    }
+    return nbReceived;
+}
+
+/**
+ * \fn          int _raceTake(gameData_t *gameData, int playerIndex, char *guesses)
+ * \brief       Scores a guess message received from a player and keeps its scores.
+ * \param       gameData : The game data structure, its reception taken by the caller.
+ * \param       playerIndex : The index of the player.
+ * \param       guesses : The text of the message, overwritten by its scores.
+ * \details     The scores wait in the replies of the player until its coroutine streams them back. A player who sent an invalid combination, or more messages than its replies hold, gets RACE_FAILED and the player's coroutine evicts it. It returns 1 if the message was scored, 0 otherwise.
+ */
+int _raceTake(gameData_t *gameData, int playerIndex, char *guesses) {
+    int nbScored;
+    if (gameData->raceNbReplies[playerIndex] == RACE_BATCH || (nbScored = _raceScore(gameData, playerIndex, guesses)) == -1) {
+        gameData->raceNbReplies[playerIndex] = RACE_FAILED;
+        return 0;
+    }
+    strcpy(gameData->raceReplies[playerIndex][gameData->raceNbReplies[playerIndex]++], guesses);
+    __atomic_add_fetch(&gameData->nbScored, nbScored, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&raceScored, nbScored, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/**
+ * \fn          int _raceScore(gameData_t *gameData, int playerIndex, char *guesses)
+ * \brief       Scores a guess message.
+ * \param       gameData : The game data structure.
+ * \param       playerIndex : The index of the player.
+ * \param       guesses : The text of the message, holding up to RACE_GUESSES_PER_MESSAGE guesses, overwritten by their scores.
+ * \details     The message is answered by the scores of its guesses, two digits per guess. The scoring stops at the first winning guess, the guesses after it are not answered, and the player wins the race if nobody won it before. It returns the number of guesses scored, or -1 if a guess is not a valid combination.
+ */
+int _raceScore(gameData_t *gameData, int playerIndex, char *guesses) {
+    char scores[MSG_SIZE];
+    int nbScored = 0;
+    int nbGuesses;
+    code_t guess;
+    score_t score;
+
+    guesses[MSG_SIZE - 1] = '\0';
+    nbGuesses = strlen(guesses) / BOARD_WIDTH;
+    if (nbGuesses == 0 || nbGuesses > RACE_GUESSES_PER_MESSAGE) {
+        return -1;
+    }
+    for (int j = 0; j < nbGuesses; j++) {
+        if (codePack(guesses + j * BOARD_WIDTH, &guess) == -1) {
+            return -1;
+        }
+        score = CODE_FEEDBACK(guess, gameData->secretCode);
+        scores[2 * j] = SCORE_GOOD_PLACE(score) + '0';
+        scores[2 * j + 1] = SCORE_GOOD_COLOR(score) + '0';
+        scores[2 * j + 2] = '\0';
+        nbScored++;
+        if (score == SCORE_WIN) {
+            pthread_mutex_lock(&gameData->mutex);
+            if (gameData->gameWinner == EMPTY) {
+                __atomic_store_n(&gameData->gameWinner, playerIndex, __ATOMIC_RELEASE);
+            }
+            pthread_mutex_unlock(&gameData->mutex);
+            break;
+        }
+    }
+    strcpy(guesses, scores);
+    return nbScored;
+}
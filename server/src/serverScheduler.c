@@ -0,0 +1,424 @@
+/**
+ * \file        serverScheduler.c
+ * \brief       Contains the session scheduler of the server.
+ * \details     This file includes the worker shards playing the game sessions. Each shard is a thread pinned to a core. A session is assigned to the least loaded shard, which keeps one turn task per player of the session. A turn task runs the player's coroutine, which yields whenever it waits for the player, so one shard multiplexes many players. A shard without ready task steals the tasks that have not started yet from the other shards. A started coroutine stays on its shard, since thread local state such as errno must not be cached across a switch of thread. The sessions are balanced when they are admitted instead: a session goes to the least loaded of the shards that are not busy, a shard being busy when it spent most of the last second running. The number of active shards can change while the server runs: the shards beyond it get no new session and finish the turns they have.
+ */
+#define _GNU_SOURCE
+#include "serverScheduler.h"
+#include "server.h"
+#include <sched.h>
+#include <unistd.h>
+
+scheduler_t scheduler = {
+    .nbShards = 0,
+    .nbActive = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+slabCache_t taskCache;
+slabCache_t stackCache;
+
+/**
+ * \fn          void schedulerInit(int nbShards)
+ * \brief       Starts the worker shards.
+ * \param       nbShards : The number of shards, each pinned to a core.
+ * \details     This function creates the shard threads. Shard i is pinned to core i modulo the number of online cores.
+ */
+void schedulerInit(int nbShards) {
+    scheduler.nbCpus = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    slabInit(&taskCache, "task", sizeof(turnTask_t));
+    slabInit(&stackCache, "stack", COROUTINE_STACK_SIZE);
+    scheduler.nbActive = MIN(nbShards, MAX_SHARDS);
+    for (int i = 0; i < scheduler.nbActive; i++) {
+        scheduler.shards[i].id = i;
+        _shardStart(&scheduler.shards[i]);
+    }
+    LOG(1, "%d shards started on %d cores.\n", scheduler.nbShards, scheduler.nbCpus);
+}
+
+/**
+ * \fn          void _shardStart(shard_t *shard)
+ * \brief       Starts the thread of a shard.
+ * \param       shard : The shard, its index set.
+ * \details     The shard is pinned to the core of its index modulo the number of online cores. It must be called with the scheduler mutex held or before the server accepts clients.
+ */
+void _shardStart(shard_t *shard) {
+    shard->cpu = shard->id % scheduler.nbCpus;
+    shard->tasks = NULL;
+    shard->capacity = 0;
+    shard->head = 0;
+    shard->count = 0;
+    shard->load = 0;
+    shard->busy = 0;
+    shard->windowStart = 0;
+    pthread_mutex_init(&shard->mutex, NULL);
+    // The thieves see the shard once it is initialized
+    __atomic_store_n(&scheduler.nbShards, shard->id + 1, __ATOMIC_RELEASE);
+    pthread_create(&shard->thread, 
+                    NULL, 
+                    _shardThreadHandler, 
+                    shard);
+    pthread_detach(shard->thread);
+}
+
+/**
+ * \fn          int schedulerResize(int nbShards)
+ * \brief       Changes the number of active shards.
+ * \param       nbShards : The number of active shards, at most MAX_SHARDS.
+ * \details     This function starts the shards missing. The shards beyond the new number stay started, so their coroutines go on with their turns, but they get no new session and steal no task, and the active shards steal their tasks that have not started. It returns the number of active shards.
+ */
+int schedulerResize(int nbShards) {
+    pthread_mutex_lock(&scheduler.mutex);
+    nbShards = MIN(MAX(nbShards, 1), MAX_SHARDS);
+    for (int i = scheduler.nbShards; i < nbShards; i++) {
+        scheduler.shards[i].id = i;
+        _shardStart(&scheduler.shards[i]);
+    }
+    __atomic_store_n(&scheduler.nbActive, nbShards, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&scheduler.mutex);
+    LOG(1, "%d shards active, %d started.\n", nbShards, scheduler.nbShards);
+    return nbShards;
+}
+
+/**
+ * \fn          void schedulerCount(int *nbTasks, int *nbQueued)
+ * \brief       Counts the turn tasks of the shards.
+ * \param       nbTasks : Where the number of tasks of the sessions on the shards is stored.
+ * \param       nbQueued : Where the number of tasks in the deques, the others being played, is stored.
+ */
+void schedulerCount(int *nbTasks, int *nbQueued) {
+    int nbShards = __atomic_load_n(&scheduler.nbShards, __ATOMIC_ACQUIRE);
+    *nbTasks = 0;
+    *nbQueued = 0;
+    for (int i = 0; i < nbShards; i++) {
+        *nbTasks += __atomic_load_n(&scheduler.shards[i].load, __ATOMIC_RELAXED);
+        *nbQueued += __atomic_load_n(&scheduler.shards[i].count, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * \fn          int schedulerSubmitSession(gameData_t *gameData)
+ * \brief       Assigns a session to a shard.
+ * \param       gameData : The game data structure.
+ * \details     This function assigns the session to the shard with the lowest load among the shards that are not busy, or among all the shards if they are all busy, and queues a turn task for each player of the session on it. Each task gets a coroutine running clientCoroutineHandler. A shard whose deque cannot grow to the session is skipped for the next one. Returns -1 if no shard can take the session, 0 otherwise.
+ */
+int schedulerSubmitSession(gameData_t *gameData) {
+    int candidates[MAX_SHARDS];
+    shard_t *shard = NULL;
+
+    pthread_mutex_lock(&scheduler.mutex);
+    // The shards that are not busy first, then the least loaded ones
+    for (int i = 0; i < scheduler.nbActive; i++) {
+        candidates[i] = i;
+        for (int j = i; j > 0 && _shardBefore(&scheduler.shards[candidates[j]], &scheduler.shards[candidates[j-1]]); j--) {
+            int candidate = candidates[j];
+            candidates[j] = candidates[j-1];
+            candidates[j-1] = candidate;
+        }
+    }
+    for (int i = 0; i < scheduler.nbActive && shard == NULL; i++) {
+        if (_shardReserve(&scheduler.shards[candidates[i]], gameData->playerList.nbPlayers) == 0) {
+            shard = &scheduler.shards[candidates[i]];
+        }
+    }
+    if (shard == NULL) {
+        pthread_mutex_unlock(&scheduler.mutex);
+        LOG(1, "Session %d refused, no shard can take it.\n", gameData->sessionId);
+        return -1;
+    }
+    __atomic_add_fetch(&shard->sessions, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&scheduler.mutex);
+    gameData->activePlayers = gameData->playerList.nbPlayers;
+    LOG(1, "Session %d assigned to shard %d.\n", gameData->sessionId, shard->id);
+    for (int i = 0; i < gameData->playerList.nbPlayers; i++) {
+        turnTask_t *task = slabAlloc(&taskCache);
+        task->gameData = gameData;
+        task->playerIndex = i;
+        task->shard = shard->id;
+        task->started = 0;
+        task->stack = slabAlloc(&stackCache);
+        coroutineInit(&task->coroutine, clientCoroutineHandler, task, task->stack, COROUTINE_STACK_SIZE);
+        _shardPush(shard, task);
+    }
+    return 0;
+}
+
+/**
+ * \fn          void schedulerShowStats()
+ * \brief       Displays the shard statistics.
+ * \details     This function prints, for each shard, its core, its load, its busy percentage and the sessions, turns, stolen tasks, empty polls and idle sleeps counted so far.
+ */
+void schedulerShowStats() {
+    printf("shard  cpu  load  busy  sessions  turns  stolen  polls  sleeps\n");
+    for (int i = 0; i < __atomic_load_n(&scheduler.nbShards, __ATOMIC_ACQUIRE); i++) {
+        shard_t *shard = &scheduler.shards[i];
+        printf("%5d  %3d  %4d  %3d%%  %8ld  %5ld  %6ld  %5ld  %6ld\n",
+                shard->id, shard->cpu,
+                __atomic_load_n(&shard->load, __ATOMIC_RELAXED),
+                __atomic_load_n(&shard->busy, __ATOMIC_RELAXED),
+                __atomic_load_n(&shard->sessions, __ATOMIC_RELAXED),
+                shard->turns, shard->stolenTasks, shard->polls, shard->idleSleeps);
+    }
+}
+
+/**
+ * \fn          void *_shardThreadHandler(void *args)
+ * \brief       Handles a shard thread.
+ * \param       args : The shard.
+ * \details     This function pins the thread to the core of the shard, then resumes the coroutines of the shard in turn, measuring how busy the shard is after each pass. When a whole pass over the deque plays no turn, an active shard tries to steal from the other shards, and the shard sleeps with an exponential backoff if there is nothing to steal.
+ */
+void *_shardThreadHandler(void *args) {
+    shard_t *shard = (shard_t *) args;
+    cpu_set_t cpuSet;
+    turnTask_t *task;
+    int backoff = 0;
+    int pending;
+    int played;
+    int status;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(shard->cpu, &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+        LOG(1, "Shard %d could not be pinned to core %d.\n", shard->id, shard->cpu);
+    }
+    while (1) {
+        played = 0;
+        pthread_mutex_lock(&shard->mutex);
+        pending = shard->count;
+        pthread_mutex_unlock(&shard->mutex);
+        for (int i = 0; i < pending && (task = _shardPop(shard)) != NULL; i++) {
+            status = _shardRunTask(shard, task);
+            if (status == TURN_PLAYED) {
+                played++;
+            }
+            if (status != TURN_DONE) {
+                _shardPush(shard, task);
+            }
+        }
+        _shardMeasure(shard);
+        if (!played && shard->id < __atomic_load_n(&scheduler.nbActive, __ATOMIC_RELAXED)) {
+            played = _shardSteal(shard);
+        }
+        if (played) {
+            backoff = 0;
+        } else {
+            backoff = backoff ? MIN(backoff * 2, SCHEDULER_MAX_BACKOFF_US) : 50;
+            shard->idleSleeps++;
+            usleep(backoff);
+        }
+    }
+    pthread_exit(NULL);
+}
+
+/**
+ * \fn          int _shardRunTask(shard_t *shard, turnTask_t *task)
+ * \brief       Runs a turn task.
+ * \param       shard : The shard running the task.
+ * \param       task : The task.
+ * \details     This function resumes the player's coroutine until it yields. When the coroutine has finished, its stack and the task are released. It returns TURN_PLAYED if the player's round went on, TURN_WAITING if the coroutine yielded without playing and TURN_DONE if it has finished.
+ */
+int _shardRunTask(shard_t *shard, turnTask_t *task) {
+    int nbRound = task->gameData->playerList.nbRound[task->playerIndex];
+    task->started = 1;
+    if (!coroutineResume(&task->coroutine)) {
+        // The game data may have been released by the coroutine
+        __atomic_sub_fetch(&shard->load, 1, __ATOMIC_RELAXED);
+        slabFree(&stackCache, task->stack);
+        slabFree(&taskCache, task);
+        return TURN_DONE;
+    }
+    if (task->gameData->playerList.nbRound[task->playerIndex] != nbRound) {
+        shard->turns++;
+        return TURN_PLAYED;
+    }
+    shard->polls++;
+    return TURN_WAITING;
+}
+
+/**
+ * \fn          void _shardMeasure(shard_t *shard)
+ * \brief       Measures how busy a shard is.
+ * \param       shard : The shard, measured by its own thread.
+ * \details     This function closes the window of the shard once it lasted SCHEDULER_BUSY_WINDOW_NS and sets the busy percentage of the shard to the CPU time its thread used during the window.
+ */
+void _shardMeasure(shard_t *shard) {
+    struct timespec now;
+    struct timespec cpu;
+    long elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    elapsed = now.tv_sec * 1000000000L + now.tv_nsec - shard->windowStart;
+    if (elapsed < SCHEDULER_BUSY_WINDOW_NS) {
+        return;
+    }
+    if (shard->windowStart != 0) {
+        __atomic_store_n(&shard->busy, (int) MIN((cpu.tv_sec * 1000000000L + cpu.tv_nsec - shard->windowCpu) * 100 / elapsed, 100), __ATOMIC_RELAXED);
+    }
+    shard->windowStart = now.tv_sec * 1000000000L + now.tv_nsec;
+    shard->windowCpu = cpu.tv_sec * 1000000000L + cpu.tv_nsec;
+}
+
+/**
+ * \fn          int _shardBefore(shard_t *a, shard_t *b)
+ * \brief       Tells whether a shard takes a new session before another.
+ * \param       a : The first shard.
+ * \param       b : The second shard.
+ * \details     A shard that is not busy comes before a busy one, then the least loaded shard comes first. Returns 1 if a comes before b, 0 otherwise.
+ */
+int _shardBefore(shard_t *a, shard_t *b) {
+    int aBusy = __atomic_load_n(&a->busy, __ATOMIC_RELAXED) >= SCHEDULER_BUSY_PERCENT;
+    int bBusy = __atomic_load_n(&b->busy, __ATOMIC_RELAXED) >= SCHEDULER_BUSY_PERCENT;
+    if (aBusy != bBusy) {
+        return bBusy;
+    }
+    return __atomic_load_n(&a->load, __ATOMIC_RELAXED) < __atomic_load_n(&b->load, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn          turnTask_t *_shardPop(shard_t *shard)
+ * \brief       Takes the first task of a shard.
+ * \param       shard : The shard.
+ * \details     This function returns NULL if the deque is empty.
+ */
+turnTask_t *_shardPop(shard_t *shard) {
+    turnTask_t *task = NULL;
+    pthread_mutex_lock(&shard->mutex);
+    if (shard->count > 0) {
+        task = shard->tasks[shard->head];
+        shard->head = (shard->head + 1) % shard->capacity;
+        shard->count--;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    return task;
+}
+
+/**
+ * \fn          int _shardPush(shard_t *shard, turnTask_t *task)
+ * \brief       Puts a task at the end of a shard.
+ * \param       shard : The shard.
+ * \param       task : The task, reserved on the shard.
+ * \details     Returns -1 if the deque is full, which only happens to a task that was not reserved, 0 otherwise.
+ */
+int _shardPush(shard_t *shard, turnTask_t *task) {
+    pthread_mutex_lock(&shard->mutex);
+    if (shard->count == shard->capacity) {
+        pthread_mutex_unlock(&shard->mutex);
+        return -1;
+    }
+    shard->tasks[(shard->head + shard->count) % shard->capacity] = task;
+    shard->count++;
+    pthread_mutex_unlock(&shard->mutex);
+    return 0;
+}
+
+/**
+ * \fn          int _shardReserve(shard_t *shard, int nbTasks)
+ * \brief       Reserves the slots of tasks assigned to a shard.
+ * \param       shard : The shard.
+ * \param       nbTasks : The number of tasks.
+ * \details     This function adds the tasks to the load of the shard and grows the deque to the load, doubling it, up to SHARD_MAX_TASKS slots. Returns -1 if the deque cannot grow, the load being left unchanged, 0 otherwise.
+ */
+int _shardReserve(shard_t *shard, int nbTasks) {
+    turnTask_t **tasks;
+    int capacity;
+    int status = 0;
+
+    pthread_mutex_lock(&shard->mutex);
+    capacity = MAX(shard->capacity, SHARD_INITIAL_TASKS);
+    // The load only decreases without the lock, it bounds the deque
+    while (capacity < __atomic_load_n(&shard->load, __ATOMIC_RELAXED) + nbTasks && capacity < SHARD_MAX_TASKS) {
+        capacity *= 2;
+    }
+    if (capacity < __atomic_load_n(&shard->load, __ATOMIC_RELAXED) + nbTasks) {
+        status = -1;
+    } else if (capacity > shard->capacity) {
+        if ((tasks = malloc(capacity * sizeof(turnTask_t *))) == NULL) {
+            status = -1;
+        } else {
+            // The tasks are moved to the start of the new deque
+            for (int i = 0; i < shard->count; i++) {
+                tasks[i] = shard->tasks[(shard->head + i) % shard->capacity];
+            }
+            free(shard->tasks);
+            shard->tasks = tasks;
+            shard->capacity = capacity;
+            shard->head = 0;
+        }
+    }
+    if (status == 0) {
+        __atomic_add_fetch(&shard->load, nbTasks, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    if (status == -1) {
+        LOG(1, "Shard %d cannot take %d more tasks.\n", shard->id, nbTasks);
+    }
+    return status;
+}
+
+/**
+ * \fn          int _shardSteal(shard_t *thief)
+ * \brief       Steals tasks from another shard.
+ * \param       thief : The idle shard.
+ * \details     This function goes through the other shards, starting with the most loaded one, and moves to the thief the tasks that have not started yet, at most half of the deque of the first shard that has some, and as many as the deque of the thief can take. It returns the number of stolen tasks.
+ */
+int _shardSteal(shard_t *thief) {
+    int victims[MAX_SHARDS];
+    int nbVictims = 0;
+    int nbStolen = 0;
+    turnTask_t *task;
+
+    for (int i = 0; i < __atomic_load_n(&scheduler.nbShards, __ATOMIC_ACQUIRE); i++) {
+        if (i != thief->id && __atomic_load_n(&scheduler.shards[i].count, __ATOMIC_RELAXED) > 1) {
+            victims[nbVictims++] = i;
+        }
+    }
+    // Most loaded victims first
+    for (int i = 1; i < nbVictims; i++) {
+        for (int j = i; j > 0 && scheduler.shards[victims[j]].load > scheduler.shards[victims[j-1]].load; j--) {
+            int victim = victims[j];
+            victims[j] = victims[j-1];
+            victims[j-1] = victim;
+        }
+    }
+    for (int i = 0; i < nbVictims && nbStolen == 0; i++) {
+        shard_t *victim = &scheduler.shards[victims[i]];
+        int max = __atomic_load_n(&victim->count, __ATOMIC_RELAXED) / 2;
+        while (nbStolen < max && _shardReserve(thief, 1) == 0) {
+            if ((task = _shardTakeUnstarted(victim)) == NULL) {
+                __atomic_sub_fetch(&thief->load, 1, __ATOMIC_RELAXED);
+                break;
+            }
+            __atomic_sub_fetch(&victim->load, 1, __ATOMIC_RELAXED);
+            task->shard = thief->id;
+            _shardPush(thief, task);
+            nbStolen++;
+        }
+    }
+    thief->stolenTasks += nbStolen;
+    return nbStolen;
+}
+
+/**
+ * \fn          turnTask_t *_shardTakeUnstarted(shard_t *shard)
+ * \brief       Takes a task that has not started from a shard.
+ * \param       shard : The shard.
+ * \details     This function removes from the deque the first task whose coroutine has never been resumed. It returns NULL if there is none.
+ */
+turnTask_t *_shardTakeUnstarted(shard_t *shard) {
+    turnTask_t *task = NULL;
+    pthread_mutex_lock(&shard->mutex);
+    for (int i = 0; i < shard->count; i++) {
+        int index = (shard->head + i) % shard->capacity;
+        if (!shard->tasks[index]->started) {
+            task = shard->tasks[index];
+            // Close the gap left in the deque
+            for (int j = i; j < shard->count - 1; j++) {
+                shard->tasks[(shard->head + j) % shard->capacity] = shard->tasks[(shard->head + j + 1) % shard->capacity];
+            }
+            shard->count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    return task;
+}
@@ -0,0 +1,139 @@
+/**
+ * \file        serverSlab.c
+ * \brief       Contains the slab allocator of the server.
+ * \details     This file includes a slab allocator recycling fixed-size objects such as game sessions and client arguments. Free objects are kept in per-core free lists backed by a shared depot, so session churn does not go through malloc once the slabs are carved.
+ */
+#define _GNU_SOURCE
+#include "serverSlab.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+slabCache_t sessionCache;
+slabCache_t clientCache;
+
+/**
+ * \fn          void slabInit(slabCache_t *cache, const char *name, size_t objectSize)
+ * \brief       Initializes a cache.
+ * \param       cache : The cache.
+ * \param       name : The name of the cache.
+ * \param       objectSize : The size of the objects of the cache.
+ * \details     This function initializes the free lists and carves a first slab of SLAB_OBJECTS objects into the depot.
+ */
+void slabInit(slabCache_t *cache, const char *name, size_t objectSize) {
+    cache->name = name;
+    cache->objectSize = (objectSize + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    cache->nbSlabs = 0;
+    for (int i = 0; i < SLAB_MAX_CPUS; i++) {
+        cache->freeLists[i].head = NULL;
+        cache->freeLists[i].count = 0;
+        pthread_mutex_init(&cache->freeLists[i].mutex, NULL);
+    }
+    cache->depot.head = NULL;
+    cache->depot.count = 0;
+    pthread_mutex_init(&cache->depot.mutex, NULL);
+    pthread_mutex_lock(&cache->depot.mutex);
+    _slabGrow(cache);
+    pthread_mutex_unlock(&cache->depot.mutex);
+}
+
+/**
+ * \fn          void *slabAlloc(slabCache_t *cache)
+ * \brief       Allocates an object.
+ * \param       cache : The cache.
+ * \details     This function pops an object from the free list of the current core. An empty list is refilled with SLAB_BATCH objects from the depot, and a new slab is carved only when the depot is empty too. The content of the object is not reset.
+ */
+void *slabAlloc(slabCache_t *cache) {
+    slabFreeList_t *local = _slabLocalList(cache);
+    slabObject_t *object;
+
+    pthread_mutex_lock(&local->mutex);
+    if (local->head == NULL) {
+        pthread_mutex_lock(&cache->depot.mutex);
+        if (cache->depot.head == NULL) {
+            _slabGrow(cache);
+        }
+        for (int i = 0; i < SLAB_BATCH && cache->depot.head != NULL; i++) {
+            object = cache->depot.head;
+            cache->depot.head = object->next;
+            cache->depot.count--;
+            object->next = local->head;
+            local->head = object;
+            local->count++;
+        }
+        pthread_mutex_unlock(&cache->depot.mutex);
+    }
+    object = local->head;
+    local->head = object->next;
+    local->count--;
+    pthread_mutex_unlock(&local->mutex);
+    return object;
+}
+
+/**
+ * \fn          void slabFree(slabCache_t *cache, void *object)
+ * \brief       Releases an object.
+ * \param       cache : The cache.
+ * \param       object : The object.
+ * \details     This function pushes the object on the free list of the current core. When the list holds more than two batches, one batch goes back to the depot for the other cores.
+ */
+void slabFree(slabCache_t *cache, void *object) {
+    slabFreeList_t *local = _slabLocalList(cache);
+    slabObject_t *freed = (slabObject_t *) object;
+
+    pthread_mutex_lock(&local->mutex);
+    freed->next = local->head;
+    local->head = freed;
+    local->count++;
+    if (local->count > 2 * SLAB_BATCH) {
+        pthread_mutex_lock(&cache->depot.mutex);
+        for (int i = 0; i < SLAB_BATCH; i++) {
+            freed = local->head;
+            local->head = freed->next;
+            local->count--;
+            freed->next = cache->depot.head;
+            cache->depot.head = freed;
+            cache->depot.count++;
+        }
+        pthread_mutex_unlock(&cache->depot.mutex);
+    }
+    pthread_mutex_unlock(&local->mutex);
+}
+
+/**
+ * \fn          void _slabGrow(slabCache_t *cache)
+ * \brief       Carves a new slab.
+ * \param       cache : The cache.
+ * \details     This function allocates SLAB_OBJECTS zeroed objects in one block and pushes them in the depot. It must be called with the depot mutex held.
+ */
+void _slabGrow(slabCache_t *cache) {
+    char *slab;
+    slabObject_t *object;
+
+    if (posix_memalign((void **) &slab, CACHE_LINE, cache->objectSize * SLAB_OBJECTS) != 0) {
+        fprintf(stderr, "Error: could not allocate a %s slab\n", cache->name);
+        exit(-1);
+    }
+    memset(slab, 0, cache->objectSize * SLAB_OBJECTS);
+    for (int i = 0; i < SLAB_OBJECTS; i++) {
+        object = (slabObject_t *) (slab + i * cache->objectSize);
+        object->next = cache->depot.head;
+        cache->depot.head = object;
+        cache->depot.count++;
+    }
+    cache->nbSlabs++;
+    LOG(1, "New %s slab, %d slabs.\n", cache->name, cache->nbSlabs);
+}
+
+/**
+ * \fn          slabFreeList_t *_slabLocalList(slabCache_t *cache)
+ * \brief       Gets the free list of the current core.
+ * \param       cache : The cache.
+ */
+slabFreeList_t *_slabLocalList(slabCache_t *cache) {
+    int cpu = sched_getcpu();
+    if (cpu < 0) {
+        cpu = 0;
+    }
+    return &cache->freeLists[cpu % SLAB_MAX_CPUS];
+}
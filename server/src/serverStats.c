@@ -0,0 +1,26 @@
+/**
+ * \file        serverStats.c
+ * \brief       Contains the live statistics of the server.
+ * \details     This file includes the counters and the latencies recorded by the code playing the games. They are kept apart from the admin channel reporting them, so the game code does not pull the admin thread in.
+ */
+#include "serverStats.h"
+
+adminStats_t adminStats;
+
+/**
+ * \fn          void adminRecord(adminLatency_t *latency, const struct timespec *start)
+ * \brief       Records a latency.
+ * \param       latency : The latency.
+ * \param       start : The monotonic time the measure started.
+ */
+void adminRecord(adminLatency_t *latency, const struct timespec *start) {
+    struct timespec now;
+    long us;
+    long max;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_nsec - start->tv_nsec) / 1000;
+    __atomic_add_fetch(&latency->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&latency->totalUs, us, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&latency->maxUs, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&latency->maxUs, &max, us, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
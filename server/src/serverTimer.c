@@ -0,0 +1,216 @@
+/**
+ * \file        serverTimer.c
+ * \brief       Contains the deadline timers of the server.
+ * \details     This file includes a hashed timer wheel driven by a single timerfd. When a deadline expires, a deadline message is posted on the message queue of the player so the thread blocked on that queue wakes up, no thread sleeps on behalf of a player.
+ */
+#include "serverTimer.h"
+
+timerWheel_t timerWheel = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * \fn          void timerInit()
+ * \brief       Starts the timer wheel.
+ * \details     This function initializes the wheel, arms the timerfd to tick every TIMER_TICK_MS and creates the timer thread.
+ */
+void timerInit() {
+    struct itimerspec tick = {
+        .it_interval = {TIMER_TICK_MS / 1000, (TIMER_TICK_MS % 1000) * 1000000},
+        .it_value = {TIMER_TICK_MS / 1000, (TIMER_TICK_MS % 1000) * 1000000},
+    };
+    pthread_t threadTimer;
+
+    for (int i = 0; i < TIMER_WHEEL_SIZE; i++) {
+        timerWheel.slots[i] = -1;
+    }
+    timerWheel.entries = NULL;
+    timerWheel.nbEntries = 0;
+    timerWheel.freeList = -1;
+    CHECK(_timerGrow(), "Error: could not allocate the timers");
+    timerWheel.currentSlot = 0;
+    timerWheel.generation = 0;
+    CHECK(timerWheel.timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC), "Error: could not create the timer");
+    CHECK(timerfd_settime(timerWheel.timerfd, 0, &tick, NULL), "Error: could not start the timer");
+    pthread_create(&threadTimer, 
+                    NULL, 
+                    _timerThreadHandler, 
+                    NULL);
+    pthread_detach(threadTimer);
+}
+
+/**
+ * \fn          int timerArm(int msgid, long mtype, int delay)
+ * \brief       Arms a deadline.
+ * \param       msgid : The message queue on which the deadline message is posted.
+ * \param       mtype : The type of the message the waiting thread receives.
+ * \param       delay : The delay in seconds, 0 disables the deadline.
+ * \details     This function returns the stamp of the deadline to pass to sendDataBefore or receiveDataBefore, or NO_DEADLINE when the delay is 0. The entries grow with the deadlines armed at once, up to TIMER_MAX_ENTRIES. It returns TIMER_FAILED if no entry is left, the caller must then drop the player rather than wait without a deadline.
+ */
+int timerArm(int msgid, long mtype, int delay) {
+    int ticks = delay * 1000 / TIMER_TICK_MS;
+    int index;
+    int stamp;
+    timerEntry_t *entry;
+
+    if (delay <= 0) {
+        return NO_DEADLINE;
+    }
+    pthread_mutex_lock(&timerWheel.mutex);
+    if (timerWheel.freeList == -1 && _timerGrow() == -1) {
+        pthread_mutex_unlock(&timerWheel.mutex);
+        fprintf(stderr, "Error: no timer left for queue %d\n", msgid);
+        return TIMER_FAILED;
+    }
+    index = timerWheel.freeList;
+    entry = &timerWheel.entries[index];
+    timerWheel.freeList = entry->next;
+    timerWheel.generation = (timerWheel.generation + 1) & 0x7FF;
+    entry->stamp = ((timerWheel.generation + 1) << 16) | index;
+    entry->msgid = msgid;
+    entry->mtype = mtype;
+    entry->rounds = (ticks - 1) / TIMER_WHEEL_SIZE;
+    entry->slot = (timerWheel.currentSlot + ticks) % TIMER_WHEEL_SIZE;
+    entry->prev = -1;
+    entry->next = timerWheel.slots[entry->slot];
+    if (entry->next != -1) {
+        timerWheel.entries[entry->next].prev = index;
+    }
+    timerWheel.slots[entry->slot] = index;
+    // The entries may be reallocated once the mutex is released
+    stamp = entry->stamp;
+    pthread_mutex_unlock(&timerWheel.mutex);
+    return stamp;
+}
+
+/**
+ * \fn          void timerCancel(int stamp)
+ * \brief       Cancels a deadline.
+ * \param       stamp : The stamp returned by timerArm.
+ * \details     This function releases the timer entry if the deadline has not expired yet. If it already expired, the deadline message left on the queue is stale and will be discarded by the next receive.
+ */
+void timerCancel(int stamp) {
+    int index = stamp & 0xFFFF;
+
+    if (stamp == NO_DEADLINE || stamp == TIMER_FAILED) {
+        return;
+    }
+    pthread_mutex_lock(&timerWheel.mutex);
+    if (timerWheel.entries[index].stamp == stamp) {
+        _timerUnlink(index);
+    }
+    pthread_mutex_unlock(&timerWheel.mutex);
+}
+
+/**
+ * \fn          void timerExpireNow(int stamp)
+ * \brief       Expires a deadline before its time.
+ * \param       stamp : The stamp returned by timerArm.
+ * \details     This function posts the deadline message right away and releases the timer entry, so the thread waiting with this deadline wakes up. Nothing is done if the deadline has already expired or been cancelled.
+ */
+void timerExpireNow(int stamp) {
+    int index = stamp & 0xFFFF;
+
+    if (stamp == NO_DEADLINE || stamp == TIMER_FAILED) {
+        return;
+    }
+    pthread_mutex_lock(&timerWheel.mutex);
+    if (timerWheel.entries[index].stamp == stamp) {
+        _timerExpire(&timerWheel.entries[index]);
+        _timerUnlink(index);
+    }
+    pthread_mutex_unlock(&timerWheel.mutex);
+}
+
+/**
+ * \fn          void *_timerThreadHandler(void *args)
+ * \brief       Handles the timer thread.
+ * \param       args : The arguments for the thread.
+ * \details     This function waits for the timerfd ticks, advances the wheel and expires the deadlines of the slots it goes through.
+ */
+void *_timerThreadHandler(void *args) {
+    (void) args;
+    uint64_t expirations;
+    int index;
+    int next;
+
+    while (1) {
+        if (read(timerWheel.timerfd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            continue;
+        }
+        pthread_mutex_lock(&timerWheel.mutex);
+        for (uint64_t tick = 0; tick < expirations; tick++) {
+            timerWheel.currentSlot = (timerWheel.currentSlot + 1) % TIMER_WHEEL_SIZE;
+            for (index = timerWheel.slots[timerWheel.currentSlot]; index != -1; index = next) {
+                next = timerWheel.entries[index].next;
+                if (timerWheel.entries[index].rounds > 0) {
+                    timerWheel.entries[index].rounds--;
+                } else {
+                    _timerExpire(&timerWheel.entries[index]);
+                    _timerUnlink(index);
+                }
+            }
+        }
+        pthread_mutex_unlock(&timerWheel.mutex);
+    }
+    pthread_exit(NULL);
+}
+
+/**
+ * \fn          void _timerExpire(timerEntry_t *entry)
+ * \brief       Expires a deadline.
+ * \param       entry : The timer entry.
+ * \details     This function posts the deadline message on the queue of the entry. It must be called with the wheel mutex held, the entry is not released.
+ */
+void _timerExpire(timerEntry_t *entry) {
+    mbuf_t buffer;
+    buffer.mtype = entry->mtype;
+    buffer.ackType = MTYPE_DEADLINE;
+    sprintf(buffer.mtext, "%d", entry->stamp);
+    // Never block the wheel, the queue may be full or already removed
+    transport->send(entry->msgid, &buffer, IPC_NOWAIT);
+    LOG(1, "Deadline %d expired on queue %d.\n", entry->stamp, entry->msgid);
+}
+
+/**
+ * \fn          int _timerGrow()
+ * \brief       Doubles the timer entries.
+ * \details     This function reallocates the entries and puts the new ones in the free list. It must be called with the wheel mutex held. It returns 0 on success and -1 if TIMER_MAX_ENTRIES are allocated already or the memory is exhausted.
+ */
+int _timerGrow() {
+    int nbEntries = timerWheel.nbEntries ? MIN(timerWheel.nbEntries * 2, TIMER_MAX_ENTRIES) : TIMER_INITIAL_ENTRIES;
+    timerEntry_t *entries;
+    if (nbEntries == timerWheel.nbEntries || (entries = realloc(timerWheel.entries, nbEntries * sizeof(timerEntry_t))) == NULL) {
+        return -1;
+    }
+    for (int i = timerWheel.nbEntries; i < nbEntries; i++) {
+        entries[i].stamp = 0;
+        entries[i].next = i + 1 < nbEntries ? i + 1 : timerWheel.freeList;
+    }
+    timerWheel.freeList = timerWheel.nbEntries;
+    timerWheel.entries = entries;
+    timerWheel.nbEntries = nbEntries;
+    LOG(1, "%d timer entries allocated.\n", nbEntries);
+    return 0;
+}
+
+/**
+ * \fn          void _timerUnlink(int index)
+ * \brief       Releases a timer entry.
+ * \param       index : The index of the entry.
+ * \details     This function removes the entry from its slot and puts it back in the free list. It must be called with the wheel mutex held.
+ */
+void _timerUnlink(int index) {
+    timerEntry_t *entry = &timerWheel.entries[index];
+    if (entry->prev != -1) {
+        timerWheel.entries[entry->prev].next = entry->next;
+    } else {
+        timerWheel.slots[entry->slot] = entry->next;
+    }
+    if (entry->next != -1) {
+        timerWheel.entries[entry->next].prev = entry->prev;
+    }
+    entry->stamp = 0;
+    entry->next = timerWheel.freeList;
+    timerWheel.freeList = index;
+}
@@ -0,0 +1,144 @@
+/**
+ *	\file		sim.c
+ *	\brief		Simulates complete games in one process.
+ *
+ *	\details	This file contains the simulation tool. Each game is played over the loopback transport: the clients are the libClient contexts, unchanged, and the server side is the code the server plays its sessions with, from the lobby to the end of the game. A thread plays both sides: the server side runs in a coroutine, yielding whenever it waits for a client, and the clients handle their messages in between. Each side assumes its own identity while it runs, so the games need neither queues of the system nor other processes.
+ *				Every random draw of a game, the secret code and the guesses of the players, comes from a generator seeded with the seed of the run and the number of the game. A run replays exactly on any machine and with any number of threads, and the digest of its games tells two runs apart.
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include "clientContext.h"
+#include "serverGame.h"
+#include "serverInit.h"
+#include "coroutine.h"
+#include "transport.h"
+#include "rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define SIM_DEFAULT_GAMES 100000
+#define SIM_DEFAULT_PLAYERS MAX_PLAYERS
+#define SIM_DEFAULT_SEED 1
+#define SIM_DEFAULT_THREADS 1
+#define SIM_SERVER_PID 1 // The identities of the two sides of the loopback, never the PID of a process of the simulation
+#define SIM_CLIENT_PID 2
+#define SIM_STRATEGY_RANDOM 0
+#define SIM_STRATEGY_CONSISTENT 1
+#define SIM_STRATEGY_MINIMAX 2
+#define SIM_MAX_RESUMES 4096 // The resumes of the server side after which a stalled game is abandoned, far more than a game ever needs
+#define SIM_DIGEST_BASIS 0xCBF29CE484222325ULL // FNV-1a
+#define SIM_DIGEST_PRIME 0x100000001B3ULL
+
+/**
+ *	\struct		simConfig
+ *	\brief		Represents the options of a run.
+ */
+struct simConfig
+{
+    long nbGames; /**<The number of games.*/
+    int nbPlayers; /**<The number of players of each game.*/
+    uint64_t seed; /**<The seed of the run.*/
+    int strategy; /**<SIM_STRATEGY_RANDOM, SIM_STRATEGY_CONSISTENT or SIM_STRATEGY_MINIMAX.*/
+    const book_t *book; /**<The opening book played before the strategy, or NULL.*/
+    int nbThreads; /**<The number of threads sharing the games.*/
+};
+typedef struct simConfig simConfig_t;
+
+/**
+ *	\struct		simGame
+ *	\brief		Represents a simulated game.
+ */
+struct simGame
+{
+    const simConfig_t *config; /**<The options of the run.*/
+    gameData_t session; /**<The server side of the game, the players, the secret code and the winner.*/
+    clientContext_t clients[MAX_PLAYERS]; /**<The client of each player.*/
+    coroutine_t server; /**<The coroutine playing the server side.*/
+    char *stack; /**<The stack of the coroutine, COROUTINE_STACK_SIZE bytes, kept from a game to the next.*/
+    rng_t rng; /**<The generator of the game.*/
+};
+typedef struct simGame simGame_t;
+
+/**
+ *	\struct		simThread
+ *	\brief		Represents a thread playing a share of the games.
+ */
+struct simThread
+{
+    pthread_t thread; /**<The thread.*/
+    const simConfig_t *config; /**<The options of the run.*/
+    int index; /**<The index of the thread, it plays the games whose number modulo the number of threads is its index.*/
+    long nbGames; /**<The number of games played.*/
+    long nbWins[MAX_PLAYERS]; /**<The number of games won by each player index.*/
+    long nbNoWinner; /**<The number of games nobody won.*/
+    long winningRounds; /**<The sum of the rounds played by the winners.*/
+    long nbLost; /**<The number of players lost, 0 unless the client and the server disagree.*/
+    uint64_t digest; /**<The digests of the games, combined in any order.*/
+};
+typedef struct simThread simThread_t;
+
+/**
+ *	\fn			void *simThreadHandler(void *args)
+ *	\brief		Plays the games of a thread.
+ *	\param 		args : The thread, a simThread_t.
+ *	\details	The thread uses the loopback transport and plays its games one after the other, each game seeded with its number.
+ */
+void *simThreadHandler(void *args);
+
+/**
+ *	\fn			int simPlayGame(simGame_t *game)
+ *	\brief		Plays a game.
+ *	\param 		game : The game, its configuration and its generator set.
+ *	\details	The queues of the players are created and attached to their clients, then the server side is resumed until the game ends, the clients handling their messages each time it waits for them. A game stalled for SIM_MAX_RESUMES resumes is abandoned. Returns the number of players lost.
+ */
+int simPlayGame(simGame_t *game);
+
+/**
+ *	\fn			void _simServe(void *args)
+ *	\brief		Plays the server side of a game.
+ *	\param 		args : The game, a simGame_t.
+ *	\details	The lobby, the rounds and the end of the game are played by the functions the server plays them with. The rounds are played in the order of the players, a winner ends the game at the end of its turn.
+ */
+void _simServe(void *args);
+
+/**
+ *	\fn			void _simStepClient(simGame_t *game, int playerIndex)
+ *	\brief		Lets a client handle its messages.
+ *	\param 		game : The game.
+ *	\param 		playerIndex : The index of the player.
+ *	\details	The thread assumes the identity of the clients while the client is stepped. Each time the client must play, it sends the combination of its strategy.
+ */
+void _simStepClient(simGame_t *game, int playerIndex);
+
+/**
+ *	\fn			void _simChoose(simGame_t *game, int playerIndex, char *combination)
+ *	\brief		Chooses the combination of a client.
+ *	\param 		game : The game.
+ *	\param 		playerIndex : The index of the player.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The combination of the opening book is played while the game stays in the book. Otherwise the random strategy draws any code, the consistent strategy plays the first code consistent with all the results of the client, scanning the codes from a random start, and the minimax strategy plays the guess of the solver, its ties broken from a random code.
+ */
+void _simChoose(simGame_t *game, int playerIndex, char *combination);
+
+/**
+ *	\fn			uint64_t _simDigest(const simGame_t *game)
+ *	\brief		Computes the digest of a game.
+ *	\param 		game : The game, once played.
+ *	\details	The digest covers the secret code, the winner and the rounds played by each player.
+ */
+uint64_t _simDigest(const simGame_t *game);
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the simulation usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name);
+
+#endif
@@ -0,0 +1,334 @@
+/**
+ *	\file		sim.c
+ *	\brief		Simulates complete games in one process.
+ *
+ *	\details	This file contains the simulation tool. Each game is played over the loopback transport: the clients are the libClient contexts, unchanged, and the server side is the code the server plays its sessions with, from the lobby to the end of the game. A thread plays both sides: the server side runs in a coroutine, yielding whenever it waits for a client, and the clients handle their messages in between. Each side assumes its own identity while it runs, so the games need neither queues of the system nor other processes.
+ *				Every random draw of a game, the secret code and the guesses of the players, comes from a generator seeded with the seed of the run and the number of the game. A run replays exactly on any machine and with any number of threads, and the digest of its games tells two runs apart.
+ */
+#include "sim.h"
+
+int serverPID = SIM_SERVER_PID; // The server side of the loopback is the identity SIM_SERVER_PID
+book_t book = {0};
+solver_t solver; // The threads search alone, sharing the memo
+
+/**
+ *	\fn			int main(int argc, char *argv[])
+ *	\brief		The main function of the simulation.
+ *	\param 		argc : The number of arguments.
+ *	\param 		argv : The arguments.
+ *	\details	-n sets the number of games, -p the number of players, -s the seed, -t the strategy, random, consistent or minimax, -b the opening book and -j the number of threads. A summary of the games is displayed at the end.
+ */
+int main(int argc, char *argv[]) {
+    simConfig_t config = {
+        .nbGames = SIM_DEFAULT_GAMES,
+        .nbPlayers = SIM_DEFAULT_PLAYERS,
+        .seed = SIM_DEFAULT_SEED,
+        .strategy = SIM_STRATEGY_CONSISTENT,
+        .book = NULL,
+        .nbThreads = SIM_DEFAULT_THREADS,
+    };
+    simThread_t *threads;
+    struct timespec start, end;
+    double elapsed;
+    long nbWins[MAX_PLAYERS] = {0};
+    long nbNoWinner = 0, winningRounds = 0, nbLost = 0;
+    uint64_t digest = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:p:s:t:b:j:")) != -1) {
+        switch (opt) {
+            case 'n':
+                config.nbGames = atol(optarg);
+                break;
+            case 'p':
+                config.nbPlayers = atoi(optarg);
+                break;
+            case 's':
+                config.seed = strtoull(optarg, NULL, 0);
+                break;
+            case 't':
+                if (strcmp(optarg, "random") == 0) {
+                    config.strategy = SIM_STRATEGY_RANDOM;
+                } else if (strcmp(optarg, "consistent") == 0) {
+                    config.strategy = SIM_STRATEGY_CONSISTENT;
+                } else if (strcmp(optarg, "minimax") == 0) {
+                    config.strategy = SIM_STRATEGY_MINIMAX;
+                } else {
+                    _usage(argv[0]);
+                }
+                break;
+            case 'b':
+                if (bookOpen(&book, optarg) == -1) {
+                    fprintf(stderr, "Error: %s is not an opening book for these rules.\n", optarg);
+                    exit(-1);
+                }
+                config.book = &book;
+                break;
+            case 'j':
+                config.nbThreads = atoi(optarg);
+                break;
+            default:
+                _usage(argv[0]);
+        }
+    }
+    if (config.nbGames < 1 || config.nbPlayers < 1 || config.nbPlayers > MAX_PLAYERS || config.nbThreads < 1) {
+        _usage(argv[0]);
+    }
+
+    // The server side plays without deadlines nor logs, its clients never keep it waiting
+    logLevel = 0;
+    serverConfig.turnDeadline = 0;
+    serverConfig.lobbyDeadline = 0;
+    threads = calloc(config.nbThreads, sizeof(simThread_t));
+    if (threads == NULL) {
+        perror("Error: could not allocate the threads");
+        exit(-1);
+    }
+    codeFeedbackInit();
+    if (config.strategy == SIM_STRATEGY_MINIMAX) {
+        solverInit(&solver, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < config.nbThreads; i++) {
+        threads[i].config = &config;
+        threads[i].index = i;
+        if (pthread_create(&threads[i].thread, NULL, simThreadHandler, &threads[i]) != 0) {
+            perror("Error: could not create a simulation thread");
+            exit(-1);
+        }
+    }
+    for (int i = 0; i < config.nbThreads; i++) {
+        pthread_join(threads[i].thread, NULL);
+        for (int j = 0; j < config.nbPlayers; j++) {
+            nbWins[j] += threads[i].nbWins[j];
+        }
+        nbNoWinner += threads[i].nbNoWinner;
+        winningRounds += threads[i].winningRounds;
+        nbLost += threads[i].nbLost;
+        digest ^= threads[i].digest;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%ld games of %d players on %d threads in %.3fs (%.0f games/s)\n",
+           config.nbGames, config.nbPlayers, config.nbThreads, elapsed, config.nbGames / elapsed);
+    printf("Wins by player:");
+    for (int i = 0; i < config.nbPlayers; i++) {
+        printf(" %ld", nbWins[i]);
+    }
+    printf(", no winner: %ld, lost players: %ld\n", nbNoWinner, nbLost);
+    if (config.nbGames > nbNoWinner) {
+        printf("Rounds played by the winners: %.3f\n", (double) winningRounds / (config.nbGames - nbNoWinner));
+    }
+    if (config.strategy == SIM_STRATEGY_MINIMAX) {
+        printf("Minimax searches: %ld, %ld answered by the memo\n", solver.nbSearches, solver.nbMemoized);
+    }
+    printf("Digest: %016llx\n", (unsigned long long) digest);
+    free(threads);
+    bookClose(&book);
+    return nbLost == 0 ? 0 : 1;
+}
+
+/**
+ *	\fn			void *simThreadHandler(void *args)
+ *	\brief		Plays the games of a thread.
+ *	\param 		args : The thread, a simThread_t.
+ *	\details	The thread uses the loopback transport and plays its games one after the other, each game seeded with its number.
+ */
+void *simThreadHandler(void *args) {
+    simThread_t *thread = (simThread_t *) args;
+    simGame_t game;
+    int winner;
+
+    transportUse(&transportLoopback);
+    transportAssume(SIM_SERVER_PID);
+    game.config = thread->config;
+    game.stack = malloc(COROUTINE_STACK_SIZE);
+    if (game.stack == NULL) {
+        perror("Error: could not allocate the stack of the server side");
+        exit(-1);
+    }
+    for (long i = thread->index; i < thread->config->nbGames; i += thread->config->nbThreads) {
+        rngSeed(&game.rng, (thread->config->seed << 32) ^ i);
+        thread->nbLost += simPlayGame(&game);
+        thread->nbGames++;
+        winner = game.session.gameWinner;
+        if (winner == EMPTY) {
+            thread->nbNoWinner++;
+        } else {
+            thread->nbWins[winner]++;
+            thread->winningRounds += game.session.playerList.nbRound[winner];
+        }
+        thread->digest ^= _simDigest(&game);
+    }
+    free(game.stack);
+    return NULL;
+}
+
+/**
+ *	\fn			int simPlayGame(simGame_t *game)
+ *	\brief		Plays a game.
+ *	\param 		game : The game, its configuration and its generator set.
+ *	\details	The queues of the players are created and attached to their clients, then the server side is resumed until the game ends, the clients handling their messages each time it waits for them. A game stalled for SIM_MAX_RESUMES resumes is abandoned. Returns the number of players lost.
+ */
+int simPlayGame(simGame_t *game) {
+    gameData_t *session = &game->session;
+    player_t *player;
+    int nbResumes = 0;
+    int nbLost = 0;
+
+    serverInit(session);
+    session->playerList.nbPlayers = game->config->nbPlayers;
+    session->secretCode = rngBelow(&game->rng, NB_CODES);
+    for (int i = 0; i < session->playerList.nbPlayers; i++) {
+        player = &session->playerList.players[i];
+        CHECK(player->msgid = transport->create(), "Error: could not create a loopback queue");
+        player->connected = 1;
+        clientAttach(&game->clients[i], player->msgid, SIM_SERVER_PID);
+        transportAssume(SIM_CLIENT_PID);
+        clientReady(&game->clients[i]);
+        transportAssume(SIM_SERVER_PID);
+    }
+
+    coroutineInit(&game->server, _simServe, game, game->stack, COROUTINE_STACK_SIZE);
+    while (coroutineResume(&game->server) && ++nbResumes < SIM_MAX_RESUMES) {
+        for (int i = 0; i < session->playerList.nbPlayers; i++) {
+            _simStepClient(game, i);
+        }
+    }
+
+    for (int i = 0; i < session->playerList.nbPlayers; i++) {
+        player = &session->playerList.players[i];
+        nbLost += !player->connected || game->clients[i].state != CLIENT_OVER;
+        // The queues of the evicted players are already removed
+        if (player->connected) {
+            transport->remove(player->msgid);
+        }
+    }
+    pthread_mutex_destroy(&session->mutex);
+    return nbLost;
+}
+
+/**
+ *	\fn			void _simServe(void *args)
+ *	\brief		Plays the server side of a game.
+ *	\param 		args : The game, a simGame_t.
+ *	\details	The lobby, the rounds and the end of the game are played by the functions the server plays them with. The rounds are played in the order of the players, a winner ends the game at the end of its turn.
+ */
+void _simServe(void *args) {
+    gameData_t *session = &((simGame_t *) args)->session;
+    player_t *players = session->playerList.players;
+
+    for (int i = 0; i < session->playerList.nbPlayers; i++) {
+        if (receiveReady(players[i].msgid, players[i].pid) == -1) {
+            players[i].connected = 0;
+        }
+    }
+    announceSession(session);
+    for (int round = 0; round < MAX_ROUND && session->gameWinner == EMPTY; round++) {
+        for (int i = 0; i < session->playerList.nbPlayers && session->gameWinner == EMPTY; i++) {
+            if (players[i].connected) {
+                playTurn(session, i);
+            }
+        }
+    }
+    endGame(session);
+}
+
+/**
+ *	\fn			void _simStepClient(simGame_t *game, int playerIndex)
+ *	\brief		Lets a client handle its messages.
+ *	\param 		game : The game.
+ *	\param 		playerIndex : The index of the player.
+ *	\details	The thread assumes the identity of the clients while the client is stepped. Each time the client must play, it sends the combination of its strategy.
+ */
+void _simStepClient(simGame_t *game, int playerIndex) {
+    clientContext_t *context = &game->clients[playerIndex];
+    char combination[BOARD_WIDTH + 1];
+    transportAssume(SIM_CLIENT_PID);
+    while (clientStep(context) != CLIENT_EVENT_NONE) {
+        if (context->state == CLIENT_TYPING) {
+            _simChoose(game, playerIndex, combination);
+            clientSendCombination(context, combination);
+        }
+    }
+    transportAssume(SIM_SERVER_PID);
+}
+
+/**
+ *	\fn			void _simChoose(simGame_t *game, int playerIndex, char *combination)
+ *	\brief		Chooses the combination of a client.
+ *	\param 		game : The game.
+ *	\param 		playerIndex : The index of the player.
+ *	\param 		combination : The buffer where the combination is stored, BOARD_WIDTH + 1 bytes.
+ *	\details	The combination of the opening book is played while the game stays in the book. Otherwise the random strategy draws any code, the consistent strategy plays the first code consistent with all the results of the client, scanning the codes from a random start, and the minimax strategy plays the guess of the solver, its ties broken from a random code.
+ */
+void _simChoose(simGame_t *game, int playerIndex, char *combination) {
+    const game_t *client = &game->clients[playerIndex].game;
+    code_t guesses[MAX_ROUND];
+    score_t scores[MAX_ROUND];
+    code_t guess = rngBelow(&game->rng, NB_CODES);
+    int round;
+
+    if (game->config->book != NULL && clientBookCombination(&game->clients[playerIndex], game->config->book, combination) == 0) {
+        return;
+    }
+    if (game->config->strategy == SIM_STRATEGY_MINIMAX
+        && clientSolverCombination(&game->clients[playerIndex], &solver, guess, combination) == 0) {
+        return;
+    }
+    if (game->config->strategy == SIM_STRATEGY_CONSISTENT) {
+        for (round = 0; round < client->nbRound; round++) {
+            codePack(client->board[round], &guesses[round]);
+            scores[round] = SCORE(client->result[round][0], client->result[round][1]);
+        }
+        for (int i = 0; i < NB_CODES; i++) {
+            code_t code = (guess + i) % NB_CODES;
+            for (round = 0; round < client->nbRound && CODE_FEEDBACK(guesses[round], code) == scores[round]; round++);
+            if (round == client->nbRound) {
+                guess = code;
+                break;
+            }
+        }
+    }
+    codeUnpack(guess, combination);
+    combination[BOARD_WIDTH] = '\0';
+}
+
+/**
+ *	\fn			uint64_t _simDigest(const simGame_t *game)
+ *	\brief		Computes the digest of a game.
+ *	\param 		game : The game, once played.
+ *	\details	The digest covers the secret code, the winner and the rounds played by each player.
+ */
+uint64_t _simDigest(const simGame_t *game) {
+    uint64_t digest = SIM_DIGEST_BASIS;
+    int values[2 + MAX_PLAYERS];
+    int nbValues = 0;
+    values[nbValues++] = game->session.secretCode;
+    values[nbValues++] = game->session.gameWinner;
+    for (int i = 0; i < game->session.playerList.nbPlayers; i++) {
+        values[nbValues++] = game->session.playerList.nbRound[i];
+    }
+    for (int i = 0; i < nbValues; i++) {
+        digest = (digest ^ (uint32_t) values[i]) * SIM_DIGEST_PRIME;
+    }
+    return digest;
+}
+
+/**
+ *	\fn			void _usage(char *name)
+ *	\brief		Displays the simulation usage.
+ *	\param 		name : The name of the executable.
+ *	\details	Prints the available command line options and exits.
+ */
+void _usage(char *name) {
+    fprintf(stderr, "Usage: %s [-n games] [-p players] [-s seed] [-t strategy] [-b book] [-j threads]\n", name);
+    fprintf(stderr, "  -n  number of games (default %d)\n", SIM_DEFAULT_GAMES);
+    fprintf(stderr, "  -p  number of players of each game (1-%d, default %d)\n", MAX_PLAYERS, SIM_DEFAULT_PLAYERS);
+    fprintf(stderr, "  -s  seed of the run (default %d)\n", SIM_DEFAULT_SEED);
+    fprintf(stderr, "  -t  strategy of the players, random, consistent or minimax (default consistent)\n");
+    fprintf(stderr, "  -b  opening book played before the strategy (default none)\n");
+    fprintf(stderr, "  -j  number of threads sharing the games (default %d)\n", SIM_DEFAULT_THREADS);
+    exit(-1);
+}